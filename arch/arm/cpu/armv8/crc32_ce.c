@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * CRC32 and CRC32C using the ARMv8 CRC32 instructions
+ *
+ * These are called from crc32(), which may run as part of the EFI runtime
+ * services, so they must live in the runtime section too.
+ */
+
+#include <common.h>
+#include <efi_loader.h>
+#include <errno.h>
+#include <asm/armv8/cpu.h>
+#include <u-boot/crc.h>
+
+asm(".arch_extension crc");
+
+static __always_inline uint32_t crc32_ce(uint32_t crc, const uint8_t *p,
+					 uint len, bool castagnoli)
+{
+	uint64_t val;
+
+	while (len && ((ulong)p & 7)) {
+		if (castagnoli)
+			asm("crc32cb %w0, %w0, %w1" : "+r" (crc) : "r" (*p));
+		else
+			asm("crc32b %w0, %w0, %w1" : "+r" (crc) : "r" (*p));
+		p++;
+		len--;
+	}
+
+	for (; len >= 8; len -= 8, p += 8) {
+		val = *(const uint64_t *)p;
+		if (castagnoli)
+			asm("crc32cx %w0, %w0, %x1" : "+r" (crc) : "r" (val));
+		else
+			asm("crc32x %w0, %w0, %x1" : "+r" (crc) : "r" (val));
+	}
+
+	while (len--) {
+		if (castagnoli)
+			asm("crc32cb %w0, %w0, %w1" : "+r" (crc) : "r" (*p));
+		else
+			asm("crc32b %w0, %w0, %w1" : "+r" (crc) : "r" (*p));
+		p++;
+	}
+
+	return crc;
+}
+
+int __efi_runtime crc32_ce_process(uint32_t *crc, const uint8_t *buf,
+				   uint len)
+{
+	if (!cpu_has_crc32())
+		return -ENOSYS;
+
+	*crc = crc32_ce(*crc, buf, len, false);
+
+	return 0;
+}
+
+int __efi_runtime crc32c_ce_process(uint32_t *crc, const uint8_t *buf,
+				    uint len)
+{
+	if (!cpu_has_crc32())
+		return -ENOSYS;
+
+	*crc = crc32_ce(*crc, buf, len, true);
+
+	return 0;
+}
@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running U-Boot jobs on the secondary cores while they wait in the spin table
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <mp_job.h>
+#include <watchdog.h>
+#include <asm/cache.h>
+#include <asm/system.h>
+#include <asm/armv8/mmu.h>
+#include <asm/arch/mp.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define MP_JOB_STACK_SIZE	SZ_16K
+
+/**
+ * struct mp_job_core - The share of a batch of jobs run by one secondary core
+ *
+ * The core reads this before turning its MMU on, so the primary core cleans
+ * it to memory before starting the core. Each one has a cache line to itself.
+ *
+ * @jobs:	All jobs in the batch
+ * @first:	First job for this core
+ * @count:	Number of jobs in the batch
+ * @stride:	Distance between the jobs run by this core
+ * @el:		Exception level U-Boot runs at
+ * @ttbr:	Page tables to use
+ * @tcr:	Translation control register value to use
+ * @done:	Set by the core once it has run its jobs
+ */
+struct mp_job_core {
+	struct mp_job *jobs;
+	int first;
+	int count;
+	int stride;
+	int el;
+	u64 ttbr;
+	u64 tcr;
+	bool done;
+} __aligned(ARCH_DMA_MINALIGN);
+
+static struct mp_job_core *mp_job_core;
+static void *mp_job_stack;
+static bool mp_job_kicked;
+
+void fsl_layerscape_mp_job_secondary(void *arg)
+{
+	struct mp_job_core *core = arg;
+	struct mp_job *job;
+	int i;
+
+	/* The page tables are only any use at U-Boot's exception level */
+	if (current_el() != core->el)
+		return;
+
+	invalidate_icache_all();
+	__asm_invalidate_tlb_all();
+	set_ttbr_tcr_mair(core->el, core->ttbr, core->tcr, MEMORY_ATTRIBUTES);
+	set_sctlr(get_sctlr() | CR_M | CR_C | CR_I);
+
+	for (i = core->first; i < core->count; i += core->stride) {
+		job = &core->jobs[i];
+		job->ret = job->func(job->arg);
+	}
+	core->done = true;
+}
+
+static u64 *mp_job_elem(int pos)
+{
+	return (u64 *)get_spin_tbl_addr() + pos * WORDS_PER_SPIN_TABLE_ENTRY;
+}
+
+static void mp_job_flush_elem(u64 *elem)
+{
+	flush_dcache_range((unsigned long)elem,
+			   (unsigned long)elem + SPIN_TABLE_ELEM_SIZE);
+}
+
+/**
+ * mp_job_find_cores() - Find the cores which can run jobs
+ *
+ * These are the secondary cores which are waiting in the spin table and have
+ * not been released with 'cpu release'.
+ *
+ * @pos: Returns the spin table position of each core
+ * @return number of cores found
+ */
+static int mp_job_find_cores(int *pos)
+{
+	u64 *elem;
+	int i, count = 0;
+
+	/* The jobs run with our page tables, so these must be set up */
+	if (!dcache_status())
+		return 0;
+	if (!mp_job_core) {
+		mp_job_core = memalign(ARCH_DMA_MINALIGN, CONFIG_MAX_CPUS *
+				       sizeof(struct mp_job_core));
+		mp_job_stack = memalign(ARCH_DMA_MINALIGN,
+					CONFIG_MAX_CPUS * MP_JOB_STACK_SIZE);
+		if (!mp_job_core || !mp_job_stack) {
+			free(mp_job_core);
+			free(mp_job_stack);
+			mp_job_core = NULL;
+			return 0;
+		}
+	}
+
+	for (i = 1; i < CONFIG_MAX_CPUS; i++) {
+		elem = mp_job_elem(i);
+		mp_job_flush_elem(elem);
+		if (elem[SPIN_TABLE_ELEM_STATUS_IDX] == 1 &&
+		    !elem[SPIN_TABLE_ELEM_ENTRY_ADDR_IDX])
+			pos[count++] = i;
+	}
+
+	return count;
+}
+
+int mp_job_cores(void)
+{
+	int pos[CONFIG_MAX_CPUS];
+
+	return mp_job_find_cores(pos) + 1;
+}
+
+int mp_job_run(struct mp_job *jobs, int count)
+{
+	int pos[CONFIG_MAX_CPUS];
+	struct mp_job_core *core;
+	int ncores, stride;
+	ulong stack;
+	u64 *elem;
+	int i, j;
+	int ret;
+
+	if (count <= 0)
+		return 0;
+	ncores = min(mp_job_find_cores(pos), count - 1);
+	stride = ncores + 1;
+
+	for (i = 0; i < ncores; i++) {
+		core = &mp_job_core[i];
+		core->jobs = jobs;
+		core->first = i + 1;
+		core->count = count;
+		core->stride = stride;
+		core->el = current_el();
+		core->ttbr = gd->arch.tlb_addr;
+		core->tcr = get_tcr(core->el, NULL, NULL);
+		core->done = false;
+		flush_dcache_range((ulong)core, (ulong)(core + 1));
+
+		/* The core writes its stack before its caches are on */
+		stack = (ulong)mp_job_stack + i * MP_JOB_STACK_SIZE;
+		flush_dcache_range(stack, stack + MP_JOB_STACK_SIZE);
+
+		elem = mp_job_elem(pos[i]);
+		elem[SPIN_TABLE_ELEM_JOB_ARG_IDX] = (ulong)core;
+		elem[SPIN_TABLE_ELEM_JOB_SP_IDX] = stack + MP_JOB_STACK_SIZE;
+		elem[SPIN_TABLE_ELEM_JOB_GD_IDX] = (ulong)gd;
+		elem[SPIN_TABLE_ELEM_JOB_IDX] =
+			(ulong)fsl_layerscape_mp_job_secondary;
+		mp_job_flush_elem(elem);
+	}
+	if (ncores) {
+		asm volatile("dsb st");
+		/* Until the first kick the cores wait on the GIC, not in wfe */
+		if (!mp_job_kicked) {
+			smp_kick_all_cpus();
+			mp_job_kicked = true;
+		}
+		asm volatile("sev");
+	}
+
+	for (j = 0; j < count; j += stride)
+		jobs[j].ret = jobs[j].func(jobs[j].arg);
+
+	for (i = 0; i < ncores; i++) {
+		elem = mp_job_elem(pos[i]);
+		do {
+			WATCHDOG_RESET();
+			mp_job_flush_elem(elem);
+		} while (elem[SPIN_TABLE_ELEM_JOB_IDX]);
+
+		/* A core at another exception level leaves its jobs to us */
+		core = &mp_job_core[i];
+		if (!core->done) {
+			for (j = core->first; j < count; j += stride)
+				jobs[j].ret = jobs[j].func(jobs[j].arg);
+		}
+	}
+
+	ret = 0;
+	for (j = 0; j < count && !ret; j++)
+		ret = jobs[j].ret;
+
+	return ret;
+}
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * SHA-1 block function using the ARMv8 Crypto Extensions
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <asm/armv8/cpu.h>
+#include <u-boot/sha1.h>
+
+void sha1_armv8_ce_process(uint32_t state[5], const uint8_t *src,
+			   uint32_t blocks);
+
+int sha1_ce_process(sha1_context *ctx, const unsigned char *data,
+		    unsigned int blocks)
+{
+	uint32_t state[5];
+	int i;
+
+	if (!cpu_has_sha1())
+		return -ENOSYS;
+
+	/* sha1_context keeps the state in unsigned longs */
+	for (i = 0; i < ARRAY_SIZE(state); i++)
+		state[i] = ctx->state[i];
+	sha1_armv8_ce_process(state, data, blocks);
+	for (i = 0; i < ARRAY_SIZE(state); i++)
+		ctx->state[i] = state[i];
+
+	return 0;
+}
@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * SHA-256 block function using the ARMv8 Crypto Extensions
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <asm/armv8/cpu.h>
+#include <u-boot/sha256.h>
+
+void sha256_armv8_ce_process(uint32_t state[8], const uint8_t *src,
+			     uint32_t blocks);
+
+int sha256_ce_process(sha256_context *ctx, const uint8_t *data,
+		      unsigned int blocks)
+{
+	if (!cpu_has_sha256())
+		return -ENOSYS;
+
+	sha256_armv8_ce_process(ctx->state, data, blocks);
+
+	return 0;
+}
@@ -23,6 +23,15 @@
 #define SPIN_TABLE_ELEM_LPID_IDX	2
 /* compare os arch and cpu arch */
 #define SPIN_TABLE_ELEM_ARCH_COMP_IDX	3
+/*
+ * U-Boot jobs for a core waiting in the spin table (see mp_job.c): the
+ * function to call (cleared by the core once it is done), its argument, the
+ * stack pointer and the global data pointer to run it with
+ */
+#define SPIN_TABLE_ELEM_JOB_IDX		4
+#define SPIN_TABLE_ELEM_JOB_ARG_IDX	5
+#define SPIN_TABLE_ELEM_JOB_SP_IDX	6
+#define SPIN_TABLE_ELEM_JOB_GD_IDX	7
 #ifdef CONFIG_ARCH_LX2160A
 #define WORDS_PER_SPIN_TABLE_ENTRY	16	/* pad to 128 bytes */
 #define SPIN_TABLE_ELEM_SIZE		128
@@ -51,6 +60,9 @@ static inline int fsl_layerscape_wake_seconday_cores(void) { return 0; }
 void *get_spin_tbl_addr(void);
 phys_addr_t determine_mp_bootpg(void);
 void secondary_boot_func(void);
+#ifdef CONFIG_FSL_LAYERSCAPE_MP_JOBS
+void fsl_layerscape_mp_job_secondary(void *arg);
+#endif
 int is_core_online(u64 cpu_id);
 u32 cpu_pos_mask(void);
 int get_core_id(void);
@@ -24,3 +24,23 @@ static inline unsigned int read_midr(void)
 			 MIDR_PARTNUM_SHIFT) == MIDR_PARTNUM_CORTEX_A53)
 #define is_cortex_a72() (((read_midr() & MIDR_PARTNUM_MASK) >>\
 			 MIDR_PARTNUM_SHIFT) == MIDR_PARTNUM_CORTEX_A72)
+
+#define ID_AA64ISAR0_SHA1_SHIFT		8
+#define ID_AA64ISAR0_SHA2_SHIFT		12
+#define ID_AA64ISAR0_CRC32_SHIFT	16
+#define ID_AA64ISAR0_FIELD_MASK		0xf
+
+static inline unsigned long read_id_aa64isar0(void)
+{
+	unsigned long val;
+
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (val));
+
+	return val;
+}
+
+#define id_aa64isar0_field(shift) ((read_id_aa64isar0() >> (shift)) & \
+				   ID_AA64ISAR0_FIELD_MASK)
+#define cpu_has_sha1() (id_aa64isar0_field(ID_AA64ISAR0_SHA1_SHIFT) != 0)
+#define cpu_has_sha256() (id_aa64isar0_field(ID_AA64ISAR0_SHA2_SHIFT) != 0)
+#define cpu_has_crc32() (id_aa64isar0_field(ID_AA64ISAR0_CRC32_SHIFT) != 0)
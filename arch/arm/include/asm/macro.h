@@ -140,6 +140,49 @@ lr	.req	x30
 #endif
 .endm
 
+/*
+ * Branch if the data cache is off at the current exception level. U-Boot
+ * turns the MMU off along with it, so all data accesses are then to Device
+ * memory, which must be aligned and can't be zeroed with DC ZVA.
+ */
+.macro	branch_if_dcache_off, xreg, off_label
+	mrs	\xreg, CurrentEL
+	cmp	\xreg, 0xc
+	b.ne	1001f
+	mrs	\xreg, sctlr_el3
+	b	1003f
+1001:	cmp	\xreg, 0x8
+	b.ne	1002f
+	mrs	\xreg, sctlr_el2
+	b	1003f
+1002:	mrs	\xreg, sctlr_el1
+1003:	tbz	\xreg, #2, \off_label		/* CR_C */
+.endm
+
+/*
+ * Branch if the address in \addr is not Normal memory at the current
+ * exception level, i.e. if it is Device memory or not mapped at all. Even
+ * with the MMU on, flash and on-chip memories may be mapped as Device memory,
+ * where unaligned accesses and DC ZVA fault. This clobbers PAR_EL1.
+ */
+.macro	branch_if_not_normal_mem, xreg, addr, label
+	mrs	\xreg, CurrentEL
+	cmp	\xreg, 0xc
+	b.ne	1001f
+	at	s1e3r, \addr
+	b	1003f
+1001:	cmp	\xreg, 0x8
+	b.ne	1002f
+	at	s1e2r, \addr
+	b	1003f
+1002:	at	s1e1r, \addr
+1003:	isb
+	mrs	\xreg, par_el1
+	tbnz	\xreg, #0, \label		/* PAR.F: translation failed */
+	lsr	\xreg, \xreg, #60
+	cbz	\xreg, \label		/* PAR.ATTR[7:4] == 0: Device */
+.endm
+
 /*
  * Switch from EL3 to EL2 for ARMv8
  * @ep:     kernel entry point
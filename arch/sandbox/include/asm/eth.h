@@ -78,6 +78,9 @@ typedef int sandbox_eth_tx_hand_f(struct udevice *dev, void *pkt,
  * recv_packet_buffer - buffers of the packet returned as received
  * recv_packet_length - lengths of the packet returned as received
  * recv_packets - number of packets returned
+ * recv_batch - number of packets handed out by the last recv_batch call
+ * recv_direct - buffer to receive the next packet into, if any
+ * recv_direct_packets - number of packets received into such a buffer
  * tx_handler - function to generate responses to sent packets
  * priv - a pointer to some structure a test may want to keep track of
  */
@@ -88,6 +91,9 @@ struct eth_sandbox_priv {
 	uchar * recv_packet_buffer[PKTBUFSRX];
 	int recv_packet_length[PKTBUFSRX];
 	int recv_packets;
+	int recv_batch;
+	uchar *recv_direct;
+	int recv_direct_packets;
 	sandbox_eth_tx_hand_f *tx_handler;
 	void *priv;
 };
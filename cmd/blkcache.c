@@ -12,37 +12,57 @@
 static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 		     int argc, char * const argv[])
 {
+	struct block_cache_dev_stats dev_stats;
 	struct block_cache_stats stats;
+	int i;
+
+	/* per-device counters are reset along with the totals, so go first */
+	for (i = 0; !blkcache_dev_stats(i, &dev_stats); i++)
+		printf("%s %d: hits: %u, misses: %u, entries: %u, "
+		       "bytes saved: %llu\n",
+		       blk_get_if_type_name(dev_stats.iftype), dev_stats.devnum,
+		       dev_stats.hits, dev_stats.misses, dev_stats.entries,
+		       (unsigned long long)dev_stats.bytes_saved);
+
 	blkcache_stats(&stats);
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
+	       "bytes saved: %llu\n"
 	       "entries: %u\n"
+	       "sets: %u x %u ways\n"
 	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "max cache entries: %u\n"
+	       "max entries/device: %u\n",
+	       stats.hits, stats.misses,
+	       (unsigned long long)stats.bytes_saved, stats.entries,
+	       stats.sets, stats.ways, stats.max_blocks_per_entry,
+	       stats.max_entries, stats.max_dev_entries);
 	return 0;
 }
 
 static int blkc_configure(cmd_tbl_t *cmdtp, int flag,
 			  int argc, char * const argv[])
 {
-	unsigned blocks_per_entry, max_entries;
-	if (argc != 3)
+	unsigned blocks_per_entry, max_entries, max_dev_entries = 0;
+	if (argc != 3 && argc != 4)
 		return CMD_RET_USAGE;
 
 	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
 	max_entries = simple_strtoul(argv[2], 0, 0);
-	blkcache_configure(blocks_per_entry, max_entries);
+	if (argc == 4)
+		max_dev_entries = simple_strtoul(argv[3], 0, 0);
+	blkcache_configure(blocks_per_entry, max_entries, max_dev_entries);
 	printf("changed to max of %u entries of %u blocks each\n",
 	       max_entries, blocks_per_entry);
+	if (max_dev_entries)
+		printf("at most %u entries per device\n", max_dev_entries);
 	return 0;
 }
 
 static cmd_tbl_t cmd_blkc_sub[] = {
 	U_BOOT_CMD_MKENT(show, 0, 0, blkc_show, "", ""),
-	U_BOOT_CMD_MKENT(configure, 3, 0, blkc_configure, "", ""),
+	U_BOOT_CMD_MKENT(configure, 4, 0, blkc_configure, "", ""),
 };
 
 static __maybe_unused void blkc_reloc(void)
@@ -79,8 +99,8 @@ static int do_blkcache(cmd_tbl_t *cmdtp, int flag,
 }
 
 U_BOOT_CMD(
-	blkcache, 4, 0, do_blkcache,
+	blkcache, 5, 0, do_blkcache,
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
-	"blkcache configure blocks entries\n"
+	"blkcache configure blocks entries [dev_entries]\n"
 );
@@ -4,6 +4,8 @@
  */
 
 #include <common.h>
+#include <env.h>
+#include <mapmem.h>
 
 static int do_bootstage_report(cmd_tbl_t *cmdtp, int flag, int argc,
 			       char * const argv[])
@@ -48,19 +50,53 @@ static int do_bootstage_stash(cmd_tbl_t *cmdtp, int flag, int argc,
 	}
 
 	if (0 == strcmp(argv[0], "stash"))
-		ret = bootstage_stash((void *)base, size);
+		ret = bootstage_stash(map_sysmem(base, size), size);
 	else
-		ret = bootstage_unstash((void *)base, size);
+		ret = bootstage_unstash(map_sysmem(base, size), size);
 	if (ret)
 		return 1;
 
 	return 0;
 }
 
+static int do_bootstage_check(cmd_tbl_t *cmdtp, int flag, int argc,
+			      char * const argv[])
+{
+	const void *baseline = NULL;
+	bool json = false;
+	ulong base, size;
+	int ret;
+
+	if (argc > 1 && !strcmp(argv[1], "-j")) {
+		json = true;
+		argc--;
+		argv++;
+	}
+	if (argc > 1) {
+		if (get_base_size(argc, argv, &base, &size))
+			return CMD_RET_USAGE;
+		baseline = map_sysmem(base, size);
+	} else {
+		base = env_get_hex("bootstage_baseline", 0);
+		if (base)
+			baseline = map_sysmem(base, 0);
+		size = -1;
+	}
+
+	ret = bootstage_check(baseline, size, json);
+	if (ret < 0) {
+		printf("Cannot read baseline (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	return ret ? CMD_RET_FAILURE : 0;
+}
+
 static cmd_tbl_t cmd_bootstage_sub[] = {
 	U_BOOT_CMD_MKENT(report, 2, 1, do_bootstage_report, "", ""),
 	U_BOOT_CMD_MKENT(stash, 4, 0, do_bootstage_stash, "", ""),
 	U_BOOT_CMD_MKENT(unstash, 4, 0, do_bootstage_stash, "", ""),
+	U_BOOT_CMD_MKENT(check, 5, 1, do_bootstage_check, "", ""),
 };
 
 /*
@@ -85,10 +121,14 @@ static int do_boostage(cmd_tbl_t *cmdtp, int flag, int argc,
 }
 
 
-U_BOOT_CMD(bootstage, 4, 1, do_boostage,
+U_BOOT_CMD(bootstage, 5, 1, do_boostage,
 	"Boot stage command",
 	" - check boot progress and timing\n"
 	"report                      - Print a report\n"
 	"stash [<start> [<size>]]    - Stash data into memory\n"
-	"unstash [<start> [<size>]]  - Unstash data from memory"
+	"unstash [<start> [<size>]]  - Unstash data from memory\n"
+	"check [-j] [<start> [<size>]]\n"
+	"                            - Check stages against budgets, and against\n"
+	"                              the baseline stashed at <start> (default\n"
+	"                              $bootstage_baseline); -j prints JSON"
 );
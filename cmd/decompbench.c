@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Measuring how quickly a compressed image is decompressed
+ */
+
+#include <common.h>
+#include <bootm.h>
+#include <command.h>
+#include <console.h>
+#include <decomp_stream.h>
+#include <div64.h>
+#include <image.h>
+#include <mapmem.h>
+#include <watchdog.h>
+
+static int decomp_bench_run(int comp, void *dst, size_t *dst_lenp,
+			    const void *src, size_t src_len)
+{
+	/* bootm decodes the blocks of an lz4 frame on all cores, if it can */
+	if (IS_ENABLED(CONFIG_LZ4) && comp == IH_COMP_LZ4)
+		return ulz4fn(src, src_len, dst, dst_lenp);
+
+	return decomp_stream_buf(comp, dst, dst_lenp, src, src_len);
+}
+
+/*
+ * Decompress an image in memory with the same code which bootm uses when the
+ * image is loaded, so that the same kernel compressed in different ways can
+ * be compared on the board itself.
+ */
+static int do_decomp_bench(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	ulong src, dst, src_len, dst_len = CONFIG_SYS_BOOTM_LEN;
+	ulong iterations = 1;
+	ulong i, start, us;
+	size_t out_len = 0;
+	void *sbuf, *dbuf;
+	u64 total;
+	int comp, ret = 0;
+
+	if (argc < 5)
+		return CMD_RET_USAGE;
+
+	comp = genimg_get_comp_id(argv[1]);
+	if (!decomp_stream_supported(comp)) {
+		printf("Cannot decompress '%s'\n", argv[1]);
+		return CMD_RET_FAILURE;
+	}
+	src = simple_strtoul(argv[2], NULL, 16);
+	src_len = simple_strtoul(argv[3], NULL, 16);
+	dst = simple_strtoul(argv[4], NULL, 16);
+	if (argc > 5)
+		dst_len = simple_strtoul(argv[5], NULL, 16);
+	if (argc > 6)
+		iterations = simple_strtoul(argv[6], NULL, 16);
+	if (!iterations)
+		return CMD_RET_USAGE;
+
+	sbuf = map_sysmem(src, src_len);
+	dbuf = map_sysmem(dst, dst_len);
+	start = timer_get_us();
+	for (i = 0; i < iterations && !ctrlc(); i++) {
+		out_len = dst_len;
+		ret = decomp_bench_run(comp, dbuf, &out_len, sbuf, src_len);
+		if (ret)
+			break;
+		WATCHDOG_RESET();
+	}
+	us = timer_get_us() - start;
+	unmap_sysmem(dbuf);
+	unmap_sysmem(sbuf);
+	if (ret) {
+		printf("Decompression failed (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	total = (u64)out_len * i;
+	printf("%s: %lu bytes -> %zu bytes, %lu times in %lu us",
+	       genimg_get_comp_short_name(comp), src_len, out_len, i, us);
+	if (us) {
+		puts(" (");
+		print_size(lldiv(total * 1000000, us), "/s");
+		puts(")");
+	}
+	puts("\n");
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	decompbench,	7,	0,	do_decomp_bench,
+	"measure decompression throughput",
+	"comp srcaddr srclen dstaddr [dstsize [iterations]]\n"
+	"    - time decompressing 'srclen' bytes compressed with 'comp'\n"
+	"      (gzip, lz4, lzma or zstd), 'iterations' times"
+);
@@ -12,13 +12,57 @@
 #include <common.h>
 #include <command.h>
 #include <hash.h>
+#include <mapmem.h>
+#include <div64.h>
 #include <linux/ctype.h>
 
+#ifdef CONFIG_HASH_BENCH
+static int hash_bench(const char *algo_name, int argc, char * const argv[])
+{
+	uint8_t output[HASH_MAX_DIGEST_SIZE];
+	struct hash_algo *algo;
+	ulong addr, len, start, us;
+	void *buf;
+
+	if (argc != 2)
+		return CMD_RET_USAGE;
+	if (hash_lookup_algo(algo_name, &algo)) {
+		printf("Unknown hash algorithm '%s'\n", algo_name);
+		return CMD_RET_FAILURE;
+	}
+	addr = simple_strtoul(argv[0], NULL, 16);
+	len = simple_strtoul(argv[1], NULL, 16);
+
+	buf = map_sysmem(addr, len);
+	start = timer_get_us();
+	algo->hash_func_ws(buf, len, output, algo->chunk_size);
+	us = timer_get_us() - start;
+	unmap_sysmem(buf);
+
+	printf("%s: %lu bytes in %lu us", algo->name, len, us);
+	if (us) {
+		puts(" (");
+		print_size(lldiv((u64)len * 1000000, us), "/s");
+		puts(")");
+	}
+	puts("\n");
+
+	return CMD_RET_SUCCESS;
+}
+#endif
+
 static int do_hash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	char *s;
 	int flags = HASH_FLAG_ENV;
 
+#ifdef CONFIG_HASH_BENCH
+	if (argc > 2 && !strcmp(argv[1], "-b")) {
+		for (s = argv[2]; *s; s++)
+			*s = tolower(*s);
+		return hash_bench(argv[2], argc - 3, argv + 3);
+	}
+#endif
 #ifdef CONFIG_HASH_VERIFY
 	if (argc < 4)
 		return CMD_RET_USAGE;
@@ -52,4 +96,8 @@ U_BOOT_CMD(
 		"    - verify message digest of memory area to immediate value, \n"
 		"      env var or *address"
 #endif
+#ifdef CONFIG_HASH_BENCH
+	"\nhash -b algorithm address count\n"
+		"    - measure the time taken to hash a memory area"
+#endif
 );
@@ -8,6 +8,7 @@
 #include <command.h>
 #include <dm.h>
 #include <log.h>
+#include <malloc.h>
 
 static char log_fmt_chars[LOGF_COUNT] = "clFLfm";
 
@@ -58,6 +59,49 @@ static int do_log_format(cmd_tbl_t *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#ifdef CONFIG_LOG_RING
+/**
+ * struct log_rec_name - A file or function name given to 'log rec'
+ *
+ * @next: Next name in the list
+ * @name: The name
+ */
+struct log_rec_name {
+	struct log_rec_name *next;
+	char name[];
+};
+
+static struct log_rec_name *log_rec_names;
+
+/**
+ * log_rec_name() - Get a copy of a name which lasts as long as U-Boot
+ *
+ * The ring buffer keeps the file and function pointers of each record, so
+ * they must not point into argv. Each distinct name is copied once and then
+ * shared by all the records which use it.
+ *
+ * @name: Name to copy
+ * @return the copy, or NULL if out of memory
+ */
+static const char *log_rec_name(const char *name)
+{
+	struct log_rec_name *entry;
+
+	for (entry = log_rec_names; entry; entry = entry->next) {
+		if (!strcmp(entry->name, name))
+			return entry->name;
+	}
+	entry = malloc(sizeof(*entry) + strlen(name) + 1);
+	if (!entry)
+		return NULL;
+	strcpy(entry->name, name);
+	entry->next = log_rec_names;
+	log_rec_names = entry;
+
+	return entry->name;
+}
+#endif
+
 static int do_log_rec(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	enum log_category_t cat;
@@ -87,6 +131,12 @@ static int do_log_rec(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	file = argv[3];
 	line = simple_strtoul(argv[4], NULL, 10);
 	func = argv[5];
+#ifdef CONFIG_LOG_RING
+	file = log_rec_name(file);
+	func = log_rec_name(func);
+	if (!file || !func)
+		return CMD_RET_FAILURE;
+#endif
 	msg = argv[6];
 	if (_log(cat, level, file, line, func, "%s\n", msg))
 		return CMD_RET_FAILURE;
@@ -94,6 +144,19 @@ static int do_log_rec(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	return 0;
 }
 
+#ifdef CONFIG_LOG_RING
+static int do_log_dump(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	if (log_ring_dump()) {
+		printf("Log ring buffer is not set up\n");
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+#endif
+
 static cmd_tbl_t log_sub[] = {
 	U_BOOT_CMD_MKENT(level, CONFIG_SYS_MAXARGS, 1, do_log_level, "", ""),
 #ifdef CONFIG_LOG_TEST
@@ -101,6 +164,9 @@ static cmd_tbl_t log_sub[] = {
 #endif
 	U_BOOT_CMD_MKENT(format, CONFIG_SYS_MAXARGS, 1, do_log_format, "", ""),
 	U_BOOT_CMD_MKENT(rec, CONFIG_SYS_MAXARGS, 1, do_log_rec, "", ""),
+#ifdef CONFIG_LOG_RING
+	U_BOOT_CMD_MKENT(dump, 1, 1, do_log_dump, "", ""),
+#endif
 };
 
 static int do_log(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
@@ -133,6 +199,9 @@ static char log_help_text[] =
 	"\tor 'default', equivalent to 'fm', or 'all' for all\n"
 	"log rec <category> <level> <file> <line> <func> <message> - "
 		"output a log record"
+#ifdef CONFIG_LOG_RING
+	"\nlog dump - show the records in the log ring buffer"
+#endif
 	;
 #endif
 
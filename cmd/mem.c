@@ -16,6 +16,7 @@
 #include <cli.h>
 #include <command.h>
 #include <console.h>
+#include <div64.h>
 #include <hash.h>
 #include <mapmem.h>
 #include <watchdog.h>
@@ -947,6 +948,106 @@ static int do_mem_mtest(cmd_tbl_t *cmdtp, int flag, int argc,
 }
 #endif	/* CONFIG_CMD_MEMTEST */
 
+#ifdef CONFIG_CMD_MEMBENCH
+/* How far memmove() moves the target area up, so that it overlaps itself */
+#define MEM_BENCH_MOVE		64
+
+enum {
+	MEM_BENCH_MEMCPY,
+	MEM_BENCH_MEMCPY_UNALIGNED,
+	MEM_BENCH_MEMMOVE,
+	MEM_BENCH_MEMSET,
+	MEM_BENCH_MEMSET_ZERO,
+
+	MEM_BENCH_COUNT,
+};
+
+static const char *const mem_bench_name[MEM_BENCH_COUNT] = {
+	"memcpy",
+	"memcpy unaligned",
+	"memmove",
+	"memset",
+	"memset zero",
+};
+
+static void mem_bench_run(int op, void *dest, const void *src, ulong count)
+{
+	switch (op) {
+	case MEM_BENCH_MEMCPY:
+		memcpy(dest, src, count);
+		break;
+	case MEM_BENCH_MEMCPY_UNALIGNED:
+		memcpy(dest, src + 1, count - 1);
+		break;
+	case MEM_BENCH_MEMMOVE:
+		memmove(dest + MEM_BENCH_MOVE, dest, count - MEM_BENCH_MOVE);
+		break;
+	case MEM_BENCH_MEMSET:
+		memset(dest, 0xa5, count);
+		break;
+	case MEM_BENCH_MEMSET_ZERO:
+		memset(dest, 0, count);
+		break;
+	}
+}
+
+/*
+ * Measure how quickly memcpy(), memmove() and memset() get through memory,
+ * for comparing the generic and the architecture-specific implementations.
+ */
+static int do_mem_bench(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	ulong src, dest, count, iterations = 1;
+	ulong i, start, us;
+	void *sbuf, *dbuf;
+	u64 total;
+	int op;
+
+	if (argc < 4)
+		return CMD_RET_USAGE;
+
+	src = simple_strtoul(argv[1], NULL, 16);
+	src += base_address;
+	dest = simple_strtoul(argv[2], NULL, 16);
+	dest += base_address;
+	count = simple_strtoul(argv[3], NULL, 16);
+	if (argc > 4)
+		iterations = simple_strtoul(argv[4], NULL, 16);
+	if (count <= MEM_BENCH_MOVE || !iterations)
+		return CMD_RET_USAGE;
+
+	sbuf = map_sysmem(src, count);
+	dbuf = map_sysmem(dest, count);
+	for (op = 0; op < MEM_BENCH_COUNT; op++) {
+		if (ctrlc()) {
+			putc('\n');
+			break;
+		}
+		start = timer_get_us();
+		for (i = 0; i < iterations; i++) {
+			mem_bench_run(op, dbuf, sbuf, count);
+			WATCHDOG_RESET();
+		}
+		us = timer_get_us() - start;
+
+		total = (u64)count * iterations;
+		printf("%-17s%llu bytes in %lu us", mem_bench_name[op], total,
+		       us);
+		if (us) {
+			puts(" (");
+			print_size(lldiv(total * 1000000, us), "/s");
+			puts(")");
+		}
+		puts("\n");
+	}
+	unmap_sysmem(dbuf);
+	unmap_sysmem(sbuf);
+
+	return 0;
+}
+#endif	/* CONFIG_CMD_MEMBENCH */
+
 /* Modify memory.
  *
  * Syntax:
@@ -1264,6 +1365,15 @@ U_BOOT_CMD(
 );
 #endif	/* CONFIG_CMD_MEMTEST */
 
+#ifdef CONFIG_CMD_MEMBENCH
+U_BOOT_CMD(
+	membench,	5,	0,	do_mem_bench,
+	"measure memcpy, memmove and memset throughput",
+	"source target count [iterations]\n"
+	"    - time copying, moving and filling 'count' bytes, 'iterations' times"
+);
+#endif	/* CONFIG_CMD_MEMBENCH */
+
 #ifdef CONFIG_MX_CYCLIC
 U_BOOT_CMD(
 	mdc,	4,	1,	do_mem_mdc,
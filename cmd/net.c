@@ -101,6 +101,19 @@ U_BOOT_CMD(
 );
 #endif
 
+#if defined(CONFIG_CMD_WGET)
+static int do_wget(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	return netboot_common(WGET, cmdtp, argc, argv);
+}
+
+U_BOOT_CMD(
+	wget,	3,	1,	do_wget,
+	"boot image via network using HTTP protocol",
+	"[loadAddress] [[hostIPaddr:]path]"
+);
+#endif
+
 #if defined(CONFIG_CMD_NFS)
 static int do_nfs(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
@@ -458,3 +471,37 @@ U_BOOT_CMD(
 );
 
 #endif  /* CONFIG_CMD_LINK_LOCAL */
+
+#if defined(CONFIG_CMD_NETSTAT)
+static int do_netstat(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	if (argc == 2 && !strcmp(argv[1], "clear")) {
+		memset(&net_stats, '\0', sizeof(net_stats));
+		return CMD_RET_SUCCESS;
+	}
+	if (argc != 1)
+		return CMD_RET_USAGE;
+
+	printf("Packets:   %lu received, %lu sent\n", net_stats.rx_packets,
+	       net_stats.tx_packets);
+#ifdef CONFIG_IP_DEFRAG
+	printf("Fragments: %lu received, %lu dropped\n", net_stats.frag_rx,
+	       net_stats.frag_dropped);
+	printf("Datagrams: %lu reassembled, %lu timed out\n",
+	       net_stats.frag_reassembled, net_stats.frag_timed_out);
+#endif
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	netstat,	2,	1,	do_netstat,
+	"show network statistics",
+	"\n"
+	"    - show packet and IP reassembly counters\n"
+	"netstat clear\n"
+	"    - reset the counters"
+);
+
+#endif  /* CONFIG_CMD_NETSTAT */
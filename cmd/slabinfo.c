@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Showing the malloc() slab statistics
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc_slab.h>
+
+static int do_slabinfo(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	struct slab_stats st;
+	int class;
+
+	printf(" size  pages  objects     used      allocs       frees  misses\n");
+	for (class = 0; !slab_get_stats(class, &st); class++) {
+		printf("%5u %6u %8u %8u %11lu %11lu %7lu\n", st.size,
+		       st.pages, st.objects, st.used, st.allocs, st.frees,
+		       st.misses);
+	}
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	slabinfo,	1,	1,	do_slabinfo,
+	"show malloc() slab statistics",
+	""
+);
@@ -6,6 +6,8 @@
 #include <common.h>
 #include <command.h>
 #include <env.h>
+#include <fs.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <trace.h>
 #include <asm/io.h>
@@ -76,9 +78,67 @@ static int create_call_list(int argc, char * const argv[])
 	return 0;
 }
 
+static int write_folded_file(const char *ifname, const char *dev_part,
+			     const char *filename)
+{
+	size_t needed;
+	loff_t actwrite;
+	char *buff;
+	int err;
+
+	trace_list_folded(NULL, 0, &needed);
+	buff = malloc(needed);
+	if (!buff) {
+		printf("Error: out of memory (%#zx bytes needed)\n", needed);
+		return -ENOMEM;
+	}
+	err = trace_list_folded(buff, needed, &needed);
+	if (!err)
+		err = fs_set_blk_dev(ifname, dev_part, FS_TYPE_ANY);
+	if (!err)
+		err = fs_write(filename, map_to_sysmem(buff), 0, needed,
+			       &actwrite);
+	free(buff);
+	if (err) {
+		printf("Error: cannot write '%s' (err=%d)\n", filename, err);
+		return err;
+	}
+	printf("Folded stacks written to %s, size %#llx\n", filename,
+	       actwrite);
+
+	return 0;
+}
+
+static int create_folded(int argc, char * const argv[])
+{
+	size_t buff_size, avail, buff_ptr, needed, used;
+	char *buff;
+	int err;
+
+	if (argc == 5)
+		return write_folded_file(argv[2], argv[3], argv[4]) ? 1 : 0;
+	if (get_args(argc, argv, &buff, &buff_ptr, &buff_size))
+		return -1;
+
+	avail = buff_size - buff_ptr;
+	err = trace_list_folded(buff + buff_ptr, avail, &needed);
+	if (err)
+		printf("Error: truncated (%#zx bytes needed)\n", needed);
+	used = min(avail, (size_t)needed);
+	printf("Folded stacks dumped to %08lx, size %#zx\n",
+	       (ulong)map_to_sysmem(buff + buff_ptr), used);
+
+	env_set_hex("profbase", map_to_sysmem(buff));
+	env_set_hex("profsize", buff_size);
+	env_set_hex("profoffset", buff_ptr + used);
+
+	return 0;
+}
+
 int do_trace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	const char *cmd = argc < 2 ? NULL : argv[1];
+	int err;
 
 	if (!cmd)
 		return cmd_usage(cmdtp);
@@ -100,6 +160,24 @@ int do_trace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	case 's':
 		trace_print_stats();
 		break;
+	case 'g':
+		err = create_folded(argc, argv);
+		if (err < 0)
+			return cmd_usage(cmdtp);
+		if (err)
+			return CMD_RET_FAILURE;
+		break;
+	case 'h':
+		if (trace_print_hot(argc > 2 ?
+				    simple_strtoul(argv[2], NULL, 10) : 20))
+			return CMD_RET_FAILURE;
+		break;
+	case 'w':
+		if (argc == 3 || argc > 4)
+			return CMD_RET_USAGE;
+		trace_set_window(argc > 2 ? simple_strtoul(argv[2], NULL, 10) : 0,
+				 argc > 3 ? simple_strtoul(argv[3], NULL, 10) : 0);
+		break;
 	default:
 		return CMD_RET_USAGE;
 	}
@@ -108,12 +186,21 @@ int do_trace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 }
 
 U_BOOT_CMD(
-	trace,	4,	1,	do_trace,
+	trace,	5,	1,	do_trace,
 	"trace utility commands",
 	"stats                        - display tracing statistics\n"
 	"trace pause                        - pause tracing\n"
 	"trace resume                       - resume tracing\n"
 	"trace funclist [<addr> <size>]     - dump function list into buffer\n"
 	"trace calls  [<addr> <size>]       "
-		"- dump function call trace into buffer"
+		"- dump function call trace into buffer\n"
+	"trace graph  [<addr> <size>]       "
+		"- dump call trace as folded stacks into buffer\n"
+	"trace graph  <interface> <dev[:part]> <file>\n"
+	"                                   "
+		"- write call trace as folded stacks to a file\n"
+	"trace hot    [<count>]             "
+		"- list functions taking most time\n"
+	"trace window [<start_us> <end_us>] "
+		"- only trace calls in this time window"
 );
@@ -25,11 +25,6 @@
 #include <bootm.h>
 #include <image.h>
 
-#ifndef CONFIG_SYS_BOOTM_LEN
-/* use 8MByte as default max gunzip size */
-#define CONFIG_SYS_BOOTM_LEN	0x800000
-#endif
-
 #define IH_INITRD_ARCH IH_ARCH_DEFAULT
 
 #ifndef USE_HOSTCC
@@ -350,15 +345,22 @@ static int bootm_load_os(bootm_headers_t *images, int boot_progress)
 	void *load_buf, *image_buf;
 	int err;
 
-	load_buf = map_sysmem(load, 0);
-	image_buf = map_sysmem(os.image_start, image_len);
-	err = image_decomp(os.comp, load, os.image_start, os.type,
-			   load_buf, image_buf, image_len,
-			   CONFIG_SYS_BOOTM_LEN, &load_end);
-	if (err) {
-		err = handle_decomp_error(os.comp, load_end - load, err);
-		bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
-		return err;
+	if (fit_stream_decompressed(os.comp, load, os.image_start, image_len,
+				    &load_end)) {
+		printf("   %s uncompressed while loading\n",
+		       genimg_get_type_name(os.type));
+	} else {
+		load_buf = map_sysmem(load, 0);
+		image_buf = map_sysmem(os.image_start, image_len);
+		err = image_decomp(os.comp, load, os.image_start, os.type,
+				   load_buf, image_buf, image_len,
+				   CONFIG_SYS_BOOTM_LEN, &load_end);
+		if (err) {
+			err = handle_decomp_error(os.comp, load_end - load,
+						  err);
+			bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
+			return err;
+		}
 	}
 
 	flush_cache(flush_start, ALIGN(load_end, ARCH_DMA_MINALIGN) - flush_start);
@@ -538,6 +540,10 @@ int do_bootm_states(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	if (!ret && (states & BOOTM_STATE_FINDOTHER))
 		ret = bootm_find_other(cmdtp, flag, argc, argv);
 
+	/* Images verified ahead of time are only trusted for this boot */
+	if (states & BOOTM_STATE_FINDOTHER)
+		fit_verified_clear();
+
 	/* Load the OS */
 	if (!ret && (states & BOOTM_STATE_LOADOS)) {
 		iflag = bootm_disable_interrupts();
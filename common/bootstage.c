@@ -10,8 +10,10 @@
  */
 
 #include <common.h>
+#include <env.h>
 #include <linux/libfdt.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <linux/compiler.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -311,6 +313,38 @@ int bootstage_fdt_add_report(void)
 }
 #endif
 
+/**
+ * get_budget_list() - Get the list of boot-time budgets
+ *
+ * This comes from the 'bootstage_budget' environment variable if set, else
+ * from the 'u-boot,bootstage-budget' string list in the /config node of the
+ * device tree. Each entry is <stage>:<microseconds>, where <stage> is a
+ * bootstage ID number or a record name, and entries are separated by commas
+ * (or are separate strings in the device tree).
+ *
+ * @lenp: Returns the length of the list in bytes
+ * @return list, or NULL if there are no budgets
+ */
+static const char *get_budget_list(int *lenp)
+{
+	const char *list;
+	int node;
+
+	list = env_get("bootstage_budget");
+	if (list) {
+		*lenp = strlen(list);
+		return list;
+	}
+	if (!CONFIG_IS_ENABLED(OF_CONTROL) || !gd->fdt_blob)
+		return NULL;
+	node = fdt_path_offset(gd->fdt_blob, "/config");
+	if (node < 0)
+		return NULL;
+
+	return fdt_getprop(gd->fdt_blob, node, "u-boot,bootstage-budget",
+			   lenp);
+}
+
 void bootstage_report(void)
 {
 	struct bootstage_data *data = gd->bootstage;
@@ -341,6 +375,318 @@ void bootstage_report(void)
 		if (rec->start_us)
 			prev = print_time_record(rec, -1);
 	}
+
+	if (CONFIG_IS_ENABLED(BOOTSTAGE_BUDGET)) {
+		ulong base = env_get_hex("bootstage_baseline", 0);
+		int len;
+
+		/* Only worth a table if there is something to compare with */
+		if (!base && !get_budget_list(&len))
+			return;
+		puts("\nBudgets:\n");
+		if (bootstage_check(base ? map_sysmem(base, 0) : NULL, -1,
+				    false) < 0)
+			puts("Cannot read baseline\n");
+	}
+}
+
+/**
+ * find_budget() - Find the budget for a record
+ *
+ * @list: List of budgets from get_budget_list()
+ * @len: Length of @list in bytes
+ * @rec: Record to look up
+ * @name: Name of @rec, from get_record_name()
+ * @return budget in microseconds, or 0 if none
+ */
+static ulong find_budget(const char *list, int len,
+			 const struct bootstage_record *rec, const char *name)
+{
+	const char *entry, *end = list + len, *sep, *colon;
+	char *endp;
+	ulong id;
+
+	for (entry = list; entry < end; entry = sep + 1) {
+		for (sep = entry; sep < end && *sep && *sep != ','; sep++)
+			;
+		while (entry < sep && *entry == ' ')
+			entry++;
+		colon = memchr(entry, ':', sep - entry);
+		if (!colon || colon == entry)
+			continue;
+		id = simple_strtoul(entry, &endp, 10);
+		if (endp == colon ? id == rec->id :
+		    (strlen(name) == colon - entry &&
+		     !strncmp(entry, name, colon - entry)))
+			return simple_strtoul(colon + 1, NULL, 10);
+	}
+
+	return 0;
+}
+
+/**
+ * struct stage_time - Time taken by a boot stage
+ *
+ * @rec: Record for the stage
+ * @elapsed: Time since the previous mark, or the total time for an
+ *	accumulated record
+ */
+struct stage_time {
+	const struct bootstage_record *rec;
+	ulong elapsed;
+};
+
+/**
+ * get_stage_times() - Work out the time taken by each stage
+ *
+ * Marks come first, in order, followed by the accumulated records.
+ *
+ * @rec: Records, sorted by increasing time
+ * @count: Number of records
+ * @times: Returns the time for each record which has an ID
+ * @return number of entries in @times
+ */
+static int get_stage_times(const struct bootstage_record *rec, int count,
+			   struct stage_time *times)
+{
+	ulong prev = 0;
+	int i, upto = 0;
+
+	for (i = 0; i < count; i++) {
+		if (rec[i].start_us || (!rec[i].id && i))
+			continue;
+		times[upto].rec = &rec[i];
+		times[upto++].elapsed = rec[i].time_us - prev;
+		prev = rec[i].time_us;
+	}
+	for (i = 0; i < count; i++) {
+		if (!rec[i].start_us)
+			continue;
+		times[upto].rec = &rec[i];
+		times[upto++].elapsed = rec[i].time_us;
+	}
+
+	return upto;
+}
+
+/**
+ * check_stash() - Check that a bootstage stash is valid
+ *
+ * @hdr: Start of stash
+ * @size: Size of stash buffer (-1 if unknown)
+ * @return 0 if OK, -ve on error (see bootstage_unstash())
+ */
+static int check_stash(const struct bootstage_hdr *hdr, int size)
+{
+	const char *ptr = (const char *)hdr, *end = ptr + size;
+
+	if (size == -1)
+		end = (char *)(~(uintptr_t)0);
+
+	if (hdr + 1 > (struct bootstage_hdr *)end) {
+		debug("%s: Not enough space for bootstage hdr\n", __func__);
+		return -EPERM;
+	}
+
+	if (hdr->magic != BOOTSTAGE_MAGIC) {
+		debug("%s: Invalid bootstage magic\n", __func__);
+		return -ENOENT;
+	}
+
+	if (ptr + hdr->size > end) {
+		debug("%s: Bootstage data runs past buffer end\n", __func__);
+		return -ENOSPC;
+	}
+
+	if (hdr->count * sizeof(struct bootstage_record) > hdr->size) {
+		debug("%s: Bootstage has %d records needing %lu bytes, but "
+			"only %d bytes is available\n", __func__, hdr->count,
+		      (ulong)hdr->count * sizeof(struct bootstage_record),
+		      hdr->size);
+		return -ENOSPC;
+	}
+
+	if (hdr->version != BOOTSTAGE_VERSION) {
+		debug("%s: Bootstage data version %#0x unrecognised\n",
+		      __func__, hdr->version);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * read_baseline() - Read the records of an earlier boot from a stash
+ *
+ * @base: Stash written by bootstage_stash()
+ * @size: Size of the stash buffer (-1 if unknown)
+ * @recp: Returns an allocated list of records, sorted by time, with names
+ *	pointing into @base. The caller must free it.
+ * @return number of records, or -ve on error
+ */
+static int read_baseline(const void *base, int size,
+			 struct bootstage_record **recp)
+{
+	const struct bootstage_hdr *hdr = base;
+	struct bootstage_record *rec;
+	const char *ptr;
+	int ret, i;
+
+	ret = check_stash(hdr, size);
+	if (ret)
+		return ret;
+	rec = malloc(hdr->count * sizeof(*rec));
+	if (!rec)
+		return -ENOMEM;
+	memcpy(rec, hdr + 1, hdr->count * sizeof(*rec));
+	ptr = (const char *)(hdr + 1) + hdr->count * sizeof(*rec);
+	for (i = 0; i < hdr->count; i++) {
+		rec[i].name = ptr;
+		ptr += strlen(ptr) + 1;
+	}
+	qsort(rec, hdr->count, sizeof(*rec), h_compare_record);
+	*recp = rec;
+
+	return hdr->count;
+}
+
+/* Find a stage in the baseline: by name for 'user' IDs, else by ID */
+static const struct stage_time *find_baseline(const struct stage_time *base,
+					      int count,
+					      const struct bootstage_record *rec,
+					      const char *name)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (rec->id >= BOOTSTAGE_ID_USER ?
+		    !strcmp(base[i].rec->name, name) : base[i].rec->id == rec->id)
+			return &base[i];
+	}
+
+	return NULL;
+}
+
+/* Print a signed time difference like print_grouped_ull(), with its sign */
+static void print_grouped_delta(long delta)
+{
+	char str[20], *s = str + sizeof(str) - 1;
+	ulong val = delta < 0 ? -delta : delta;
+	int digits = 0;
+
+	*s = '\0';
+	do {
+		if (digits && !(digits % 3))
+			*--s = ',';
+		*--s = '0' + val % 10;
+		val /= 10;
+		digits++;
+	} while (val);
+	*--s = delta < 0 ? '-' : '+';
+	printf("%11s", s);
+}
+
+/* Print a string as a JSON string, with quotes */
+static void print_json_string(const char *str)
+{
+	putc('"');
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			putc('\\');
+		if (*str >= ' ')
+			putc(*str);
+	}
+	putc('"');
+}
+
+int bootstage_check(const void *baseline, int size, bool json)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct stage_time *times, *base_times = NULL;
+	struct bootstage_record *base_rec = NULL;
+	int count, base_count = 0, overruns = 0;
+	const char *list;
+	int list_len = 0;
+	char buf[20];
+	int ret, i;
+
+	list = get_budget_list(&list_len);
+	if (baseline) {
+		ret = read_baseline(baseline, size, &base_rec);
+		if (ret < 0)
+			return ret;
+		base_count = ret;
+	}
+	times = calloc(data->rec_count + base_count, sizeof(*times));
+	if (!times) {
+		free(base_rec);
+		return -ENOMEM;
+	}
+	qsort(data->record, data->rec_count, sizeof(*data->record),
+	      h_compare_record);
+	count = get_stage_times(data->record, data->rec_count, times);
+	if (base_rec) {
+		base_times = times + count;
+		base_count = get_stage_times(base_rec, base_count, base_times);
+	}
+
+	if (json)
+		puts("{\"records\": [");
+	else
+		printf("%11s%11s%11s%11s  %s\n", "Elapsed", "Budget", "Baseline",
+		       "Delta", "Stage");
+	for (i = 0; i < count; i++) {
+		const struct bootstage_record *rec = times[i].rec;
+		const char *name = get_record_name(buf, sizeof(buf), rec);
+		const struct stage_time *prev = NULL;
+		ulong budget = 0;
+		bool over;
+
+		if (list)
+			budget = find_budget(list, list_len, rec, name);
+		if (base_times)
+			prev = find_baseline(base_times, base_count, rec, name);
+		over = budget && times[i].elapsed > budget;
+		overruns += over;
+		if (json) {
+			printf("%s\n  {\"id\": %d, \"name\": ", i ? "," : "",
+			       rec->id);
+			print_json_string(name);
+			printf(", \"%s\": %lu, \"elapsed_us\": %lu",
+			       rec->start_us ? "accum_us" : "mark_us",
+			       rec->time_us, times[i].elapsed);
+			if (budget)
+				printf(", \"budget_us\": %lu, \"over\": %s",
+				       budget, over ? "true" : "false");
+			if (prev)
+				printf(", \"baseline_us\": %lu, \"delta_us\": %ld",
+				       prev->elapsed,
+				       (long)(times[i].elapsed - prev->elapsed));
+			putc('}');
+			continue;
+		}
+		print_grouped_ull(times[i].elapsed, BOOTSTAGE_DIGITS);
+		if (budget)
+			print_grouped_ull(budget, BOOTSTAGE_DIGITS);
+		else
+			printf("%11s", "-");
+		if (prev) {
+			print_grouped_ull(prev->elapsed, BOOTSTAGE_DIGITS);
+			print_grouped_delta(times[i].elapsed - prev->elapsed);
+		} else {
+			printf("%11s%11s", "-", "-");
+		}
+		printf("  %s%s\n", name, over ? "  ** over budget **" : "");
+	}
+	if (json)
+		printf("\n], \"overruns\": %d}\n", overruns);
+	else if (overruns)
+		printf("%d stage%s over budget\n", overruns,
+		       overruns == 1 ? "" : "s");
+	free(times);
+	free(base_rec);
+
+	return overruns;
 }
 
 /**
@@ -424,41 +770,14 @@ int bootstage_unstash(const void *base, int size)
 {
 	const struct bootstage_hdr *hdr = (struct bootstage_hdr *)base;
 	struct bootstage_data *data = gd->bootstage;
-	const char *ptr = base, *end = ptr + size;
+	const char *ptr = base;
 	struct bootstage_record *rec;
 	uint rec_size;
-	int i;
-
-	if (size == -1)
-		end = (char *)(~(uintptr_t)0);
-
-	if (hdr + 1 > (struct bootstage_hdr *)end) {
-		debug("%s: Not enough space for bootstage hdr\n", __func__);
-		return -EPERM;
-	}
-
-	if (hdr->magic != BOOTSTAGE_MAGIC) {
-		debug("%s: Invalid bootstage magic\n", __func__);
-		return -ENOENT;
-	}
-
-	if (ptr + hdr->size > end) {
-		debug("%s: Bootstage data runs past buffer end\n", __func__);
-		return -ENOSPC;
-	}
-
-	if (hdr->count * sizeof(*rec) > hdr->size) {
-		debug("%s: Bootstage has %d records needing %lu bytes, but "
-			"only %d bytes is available\n", __func__, hdr->count,
-		      (ulong)hdr->count * sizeof(*rec), hdr->size);
-		return -ENOSPC;
-	}
+	int ret, i;
 
-	if (hdr->version != BOOTSTAGE_VERSION) {
-		debug("%s: Bootstage data version %#0x unrecognised\n",
-		      __func__, hdr->version);
-		return -EINVAL;
-	}
+	ret = check_stash(hdr, size);
+	if (ret)
+		return ret;
 
 	if (data->rec_count + hdr->count > RECORD_COUNT) {
 		debug("%s: Bootstage has %d records, we have space for %d\n"
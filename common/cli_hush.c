@@ -1589,6 +1589,8 @@ static int run_pipe_real(struct pipe *pi)
 #endif
 		return rcode;
 	} else if (pi->num_progs == 1 && pi->progs[0].argv != NULL) {
+		int sp = child->sp;	/* the pipe may be run again */
+
 		for (i=0; is_assignment(child->argv[i]); i++) { /* nothing */ }
 		if (i!=0 && child->argv[i]==NULL) {
 			/* assignments, but no command: set the local environment */
@@ -1627,11 +1629,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1759,11 +1761,26 @@ static int run_pipe_real(struct pipe *pi)
 	return -1;
 }
 
+/* Give back the variable name of a "for" loop which is left early, so that a
+ * cached list can be run again */
+static void restore_for(struct pipe *for_pi, char **list, char **save_list,
+			char *save_name)
+{
+	if (!list)
+		return;
+	free(for_pi->progs->argv[0]);
+	while (*list)
+		free(*list++);
+	free(save_list);
+	for_pi->progs->argv[0] = save_name;
+}
+
 static int run_list_real(struct pipe *pi)
 {
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+	struct pipe *for_pi = NULL;
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1803,6 +1820,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
+					restore_for(for_pi, list, save_list,
+						    save_name);
 					return 1;
 				}
 #endif
@@ -1832,6 +1851,7 @@ static int run_list_real(struct pipe *pi)
 				list = make_list_in(pi->next->progs->argv,
 					pi->progs->argv[0]);
 				save_list = list;
+				for_pi = pi;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
@@ -1903,6 +1923,7 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
+			restore_for(for_pi, list, save_list, save_name);
 			return -2;	/* exit */
 		}
 		last_return_code=(rcode == 0) ? 0 : 1;
@@ -1923,6 +1944,7 @@ static int run_list_real(struct pipe *pi)
 		checkjobs(NULL);
 #endif
 	}
+	restore_for(for_pi, list, save_list, save_name);
 	return rcode;
 }
 
@@ -3253,6 +3275,153 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #endif /* __U_BOOT__ */
 }
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+/*
+ * Scripts such as bootcmd are run many times over, so the lists parsed from
+ * a string are kept and run again the next time the same string is given,
+ * without tokenising it again. Variables are only expanded when each
+ * command runs, so the parsed lists depend on nothing but the text.
+ */
+struct parse_cache {
+	char *text;		/* string which was parsed, NULL if unused */
+	uint hash;		/* hash of text */
+	int flag;		/* flags it was parsed with */
+	int busy;		/* non-zero while the lists are being run */
+	ulong last_used;	/* for finding the least recently used entry */
+	int count;		/* number of lists */
+	struct pipe **lists;	/* one list per line */
+};
+
+static struct parse_cache parse_cache[CONFIG_HUSH_PARSE_CACHE_SIZE];
+static ulong parse_cache_clock;
+
+static uint parse_cache_hash(const char *s)
+{
+	uint hash = 0;
+
+	while (*s)
+		hash = hash * 31 + (uchar)*s++;
+
+	return hash;
+}
+
+static void parse_cache_drop(struct parse_cache *pc)
+{
+	int i;
+
+	for (i = 0; i < pc->count; i++)
+		free_pipe_list(pc->lists[i], 0);
+	free(pc->lists);
+	free(pc->text);
+	pc->text = NULL;
+}
+
+/* Parse every line of a string without running any of them, as
+ * parse_stream_outer() would. Returns 0 on success, 1 on a syntax error */
+static int parse_stream_lists(struct in_str *inp, int flag,
+			      struct parse_cache *pc)
+{
+	struct p_context ctx;
+	o_string temp=NULL_O_STRING;
+	int rcode;
+
+	do {
+		ctx.type = flag;
+		initialize_context(&ctx);
+		update_ifs_map();
+		if (!(flag & FLAG_PARSE_SEMICOLON) || (flag & FLAG_REPARSING)) mapset((uchar *)";$&|", 0);
+		inp->promptmode=1;
+		rcode = parse_stream(&temp, &ctx, inp,
+				     flag & FLAG_CONT_ON_NEWLINE ? -1 : '\n');
+		if (rcode == 1 || ctx.old_flag != 0) {
+			if (ctx.old_flag != 0)
+				free(ctx.stack);
+			free_pipe_list(ctx.list_head, 0);
+			b_free(&temp);
+			return 1;
+		}
+		done_word(&temp, &ctx);
+		done_pipe(&ctx,PIPE_SEQ);
+		b_free(&temp);
+		pc->lists = xrealloc(pc->lists,
+				     (pc->count + 1) * sizeof(*pc->lists));
+		pc->lists[pc->count++] = ctx.list_head;
+	} while (rcode != -1 && !(flag & FLAG_EXIT_FROM_LOOP) && b_peek(inp));
+
+	return 0;
+}
+
+/* Find the parsed lists for a string, parsing it if needed. Returns NULL if
+ * the string must be parsed and run in the normal way */
+static struct parse_cache *parse_cache_get(const char *s, const char *str,
+					   int flag)
+{
+	struct parse_cache *pc, *victim = NULL;
+	struct in_str input;
+	uint hash = parse_cache_hash(s);
+
+	for (pc = parse_cache; pc < parse_cache + ARRAY_SIZE(parse_cache);
+	     pc++) {
+		if (pc->text && pc->hash == hash && pc->flag == flag &&
+		    !strcmp(pc->text, s)) {
+			if (pc->busy)
+				return NULL;	/* running itself */
+			pc->last_used = ++parse_cache_clock;
+			return pc;
+		}
+		if (!pc->busy && (!victim || !pc->text ||
+				  (victim->text &&
+				   pc->last_used < victim->last_used)))
+			victim = pc;
+	}
+	if (!victim)
+		return NULL;
+
+	if (victim->text)
+		parse_cache_drop(victim);
+	pc = victim;
+	pc->lists = NULL;
+	pc->count = 0;
+	setup_string_in_str(&input, str);
+	if (parse_stream_lists(&input, flag, pc)) {
+		/* leave the syntax error to be reported as usual */
+		parse_cache_drop(pc);
+		return NULL;
+	}
+	pc->text = xstrdup(s);
+	if (!pc->text) {
+		parse_cache_drop(pc);
+		return NULL;
+	}
+	pc->hash = hash;
+	pc->flag = flag;
+	pc->last_used = ++parse_cache_clock;
+
+	return pc;
+}
+
+/* Run the lists parsed from a string, as parse_stream_outer() does */
+static int parse_cache_run(struct parse_cache *pc)
+{
+	int code = 1;
+	int i;
+
+	pc->busy++;
+	for (i = 0; i < pc->count; i++) {
+		code = run_list_real(pc->lists[i]);
+		if (code == -2) {	/* exit */
+			code = 0;
+			break;
+		}
+		if (code == -1)
+			flag_repeat = 0;
+	}
+	pc->busy--;
+
+	return (code != 0) ? 1 : 0;
+}
+#endif /* CONFIG_HUSH_PARSE_CACHE */
+
 #ifndef __U_BOOT__
 static int parse_string_outer(const char *s, int flag)
 #else
@@ -3271,6 +3440,20 @@ int parse_string_outer(const char *s, int flag)
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
 		strcat(p, "\n");
+	} else {
+		p = NULL;
+	}
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	if (!(flag & FLAG_REPARSING)) {
+		struct parse_cache *pc = parse_cache_get(s, p ? p : s, flag);
+
+		if (pc) {
+			free(p);
+			return parse_cache_run(pc);
+		}
+	}
+#endif
+	if (p) {
 		setup_string_in_str(&input, p);
 		rcode = parse_stream_outer(&input, flag);
 		free(p);
@@ -12,8 +12,11 @@
 #include <command.h>
 #include <console.h>
 #include <env.h>
+#include <malloc.h>
 #include <linux/ctype.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 /*
  * Use puts() instead of printf() to avoid printf buffer overflow
  * for long help messages
@@ -82,10 +85,85 @@ int _do_help(cmd_tbl_t *cmd_start, int cmd_items, cmd_tbl_t *cmdtp, int flag,
 	return rcode;
 }
 
+#ifdef CONFIG_CMDLINE
+/*
+ * The linker script sorts the command list by symbol name, which is not
+ * always the command name (e.g. '?'), so build an index sorted by name once
+ * and find commands in it by binary search, instead of comparing with every
+ * command in turn.
+ */
+static cmd_tbl_t **cmd_index;	/* command list, sorted by name */
+static bool cmd_index_failed;
+
+static int cmd_compare(const void *p1, const void *p2)
+{
+	const cmd_tbl_t *cmd1 = *(const cmd_tbl_t **)p1;
+	const cmd_tbl_t *cmd2 = *(const cmd_tbl_t **)p2;
+
+	return strcmp(cmd1->name, cmd2->name);
+}
+
+static cmd_tbl_t **cmd_sorted_index(cmd_tbl_t *table, int table_len)
+{
+	int i;
+
+	if (!(gd->flags & GD_FLG_RELOC) ||
+	    !(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return NULL;	/* too early to keep an index */
+	if (table != ll_entry_start(cmd_tbl_t, cmd) ||
+	    table_len != ll_entry_count(cmd_tbl_t, cmd))
+		return NULL;	/* not the command list */
+	if (cmd_index || cmd_index_failed)
+		return cmd_index;
+
+	cmd_index = malloc(table_len * sizeof(*cmd_index));
+	if (!cmd_index) {
+		cmd_index_failed = true;
+		return NULL;
+	}
+	for (i = 0; i < table_len; i++)
+		cmd_index[i] = &table[i];
+	qsort(cmd_index, table_len, sizeof(*cmd_index), cmd_compare);
+
+	return cmd_index;
+}
+
+/* find command table entry for a command, in an index sorted by name */
+static cmd_tbl_t *find_cmd_sorted(const char *cmd, cmd_tbl_t **index,
+				  int table_len)
+{
+	int lo = 0, hi = table_len, mid;
+	const char *p;
+	int len;
+
+	len = ((p = strchr(cmd, '.')) == NULL) ? strlen(cmd) : (p - cmd);
+
+	/* Find the first command which does not sort before 'cmd' */
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (strncmp(index[mid]->name, cmd, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == table_len || strncmp(index[lo]->name, cmd, len))
+		return NULL;	/* not found */
+
+	/* A full match sorts before any command which it abbreviates */
+	if (!index[lo]->name[len])
+		return index[lo];
+	if (lo + 1 < table_len && !strncmp(index[lo + 1]->name, cmd, len))
+		return NULL;	/* ambiguous */
+
+	return index[lo];	/* exactly one match */
+}
+#endif /* CONFIG_CMDLINE */
+
 /* find command table entry for a command */
 cmd_tbl_t *find_cmd_tbl(const char *cmd, cmd_tbl_t *table, int table_len)
 {
 #ifdef CONFIG_CMDLINE
+	cmd_tbl_t **index;
 	cmd_tbl_t *cmdtp;
 	cmd_tbl_t *cmdtp_temp = table;	/* Init value */
 	const char *p;
@@ -94,6 +172,9 @@ cmd_tbl_t *find_cmd_tbl(const char *cmd, cmd_tbl_t *table, int table_len)
 
 	if (!cmd)
 		return NULL;
+	index = cmd_sorted_index(table, table_len);
+	if (index)
+		return find_cmd_sorted(cmd, index, table_len);
 	/*
 	 * Some commands allow length modifiers (like "cp.b");
 	 * compare command name only until first dot.
@@ -484,8 +565,6 @@ int cmd_get_data_size(char* arg, int default_size)
 #endif
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
-DECLARE_GLOBAL_DATA_PTR;
-
 void fixup_cmdtable(cmd_tbl_t *cmdtp, int size)
 {
 	int	i;
@@ -551,6 +630,14 @@ int cmd_discard_repeatable(cmd_tbl_t *cmdtp, int flag, int argc,
 	return cmdtp->cmd_rep(cmdtp, flag, argc, argv, &repeatable);
 }
 
+/* Number of commands started so far */
+static ulong cmd_count;
+
+ulong cmd_get_count(void)
+{
+	return cmd_count;
+}
+
 /**
  * Call a command function. This should be the only route in U-Boot to call
  * a command, so that we can track whether we are waiting for input or
@@ -568,6 +655,7 @@ static int cmd_call(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 {
 	int result;
 
+	cmd_count++;
 	result = cmdtp->cmd_rep(cmdtp, flag, argc, argv, repeatable);
 	if (result)
 		debug("Command failed, result=%d\n", result);
@@ -5,6 +5,7 @@
 #endif
 
 #include <malloc.h>
+#include <malloc_slab.h>
 #include <asm/io.h>
 
 #ifdef DEBUG
@@ -610,6 +611,9 @@ void mem_malloc_init(ulong start, ulong size)
 	memset((void *)mem_malloc_start, 0x0, size);
 #endif
 	malloc_bin_reloc();
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	mem_malloc_brk += slab_init(start, size);
+#endif
 }
 
 /* field-extraction macros */
@@ -1267,6 +1271,15 @@ Void_t* mALLOc(bytes) size_t bytes;
 
   if ((long)bytes < 0) return NULL;
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  if (bytes <= SLAB_MAX_SIZE) {
+    Void_t *mem = slab_alloc(bytes);
+
+    if (mem)
+      return mem;
+  }
+#endif
+
   nb = request2size(bytes);  /* padded request size; */
 
   /* Check for exact match in a bin */
@@ -1531,6 +1544,11 @@ void fREe(mem) Void_t* mem;
   if (mem == NULL)                              /* free(0) has no effect */
     return;
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  if (slab_free(mem))
+    return;
+#endif
+
   p = mem2chunk(mem);
   hd = p->size;
 
@@ -1689,6 +1707,21 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 	}
 #endif
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  /* A slab object cannot grow, so move it if it must */
+  oldsize = slab_usable_size(oldmem);
+  if (oldsize) {
+    if (bytes <= oldsize)
+      return oldmem;
+    newmem = mALLOc(bytes);
+    if (newmem == NULL)
+      return NULL;
+    memcpy(newmem, oldmem, oldsize);
+    fREe(oldmem);
+    return newmem;
+  }
+#endif
+
   newp    = oldp    = mem2chunk(oldmem);
   newsize = oldsize = chunksize(oldp);
 
@@ -1873,6 +1906,16 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 */
 
 
+/*
+  memalign splits up the chunk which malloc returns, so that chunk must not
+  be a slab object
+*/
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+#define memalign_request(n)	max_t(size_t, (n), SLAB_MAX_SIZE + 1)
+#else
+#define memalign_request(n)	(n)
+#endif
+
 #if __STD_C
 Void_t* mEMALIGn(size_t alignment, size_t bytes)
 #else
@@ -1908,7 +1951,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
   /* Call malloc with worst case padding to hit alignment. */
 
   nb = request2size(bytes);
-  m  = (char*)(mALLOc(nb + alignment + MINSIZE));
+  m  = (char*)(mALLOc(memalign_request(nb + alignment + MINSIZE)));
 
   /*
   * The attempt to over-allocate (with a size large enough to guarantee the
@@ -1924,7 +1967,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
      * Use bytes not nb, since mALLOc internally calls request2size too, and
      * each call increases the size to allocate, to account for the header.
      */
-    m  = (char*)(mALLOc(bytes));
+    m  = (char*)(mALLOc(memalign_request(bytes)));
     /* Aligned -> return it */
     if ((((unsigned long)(m)) % alignment) == 0)
       return m;
@@ -1935,7 +1978,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
     fREe(m);
     /* Add in extra bytes to match misalignment of unexpanded allocation */
     extra = alignment - (((unsigned long)(m)) % alignment);
-    m  = (char*)(mALLOc(bytes + extra));
+    m  = (char*)(mALLOc(memalign_request(bytes + extra)));
     /*
      * m might not be the same as before. Validate that the previous value of
      * extra still works for the current value of m.
@@ -2089,6 +2132,12 @@ Void_t* cALLOc(n, elem_size) size_t n; size_t elem_size;
 		MALLOC_ZERO(mem, sz);
 		return mem;
 	}
+#endif
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+    if (slab_usable_size(mem)) {
+      memset(mem, 0, sz);
+      return mem;
+    }
 #endif
     p = mem2chunk(mem);
 
@@ -2239,6 +2288,12 @@ size_t malloc_usable_size(mem) Void_t* mem;
     return 0;
   else
   {
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+    size_t size = slab_usable_size(mem);
+
+    if (size)
+      return size;
+#endif
     p = mem2chunk(mem);
     if(!chunk_is_mmapped(p))
     {
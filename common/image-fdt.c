@@ -14,6 +14,7 @@
 #include <env.h>
 #include <errno.h>
 #include <image.h>
+#include <log.h>
 #include <linux/libfdt.h>
 #include <mapmem.h>
 #include <asm/io.h>
@@ -560,6 +561,12 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 			goto err;
 		}
 	}
+	if (CONFIG_IS_ENABLED(LOG_RING_HANDOFF)) {
+		fdt_ret = log_ring_fdt_fixup(blob);
+		if (fdt_ret)
+			printf("WARNING: could not pass log to OS (err=%d)\n",
+			       fdt_ret);
+	}
 
 	/* Delete the old LMB reservation */
 	if (lmb)
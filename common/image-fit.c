@@ -18,11 +18,15 @@
 #include <errno.h>
 #include <mapmem.h>
 #include <asm/io.h>
+#include <hash.h>
+#include <lmb.h>
 #include <malloc.h>
+#include <mp_job.h>
 DECLARE_GLOBAL_DATA_PTR;
 #endif /* !USE_HOSTCC*/
 
 #include <bootm.h>
+#include <decomp_stream.h>
 #include <image.h>
 #include <bootstage.h>
 #include <u-boot/crc.h>
@@ -1728,12 +1732,753 @@ int fit_conf_get_prop_node(const void *fit, int noffset,
 	return fit_conf_get_prop_node_index(fit, noffset, prop_name, 0);
 }
 
+#if IMAGE_ENABLE_STREAM_VERIFY || IMAGE_ENABLE_PARALLEL_VERIFY
+/*
+ * Images which have already been verified, either while the FIT was loaded or
+ * by hashing several images at once on all cores, so that fit_image_select()
+ * does not need to hash them again
+ */
+#define FIT_VERIFIED_MAX	16
+
+/* An image whose hashes all matched, and the digest of its first hash */
+struct fit_verified_image {
+	int noffset;
+	int hash_noffset;
+	uint8_t value[FIT_MAX_HASH_LEN];
+};
+
+static struct fit_verified {
+	const void *fit;		/* FIT the images belong to */
+	const char *how;		/* How they were verified */
+	ulong cmd;			/* Command they were verified in */
+	int count;
+	struct fit_verified_image image[FIT_VERIFIED_MAX];
+} fit_verified;
+
+static void fit_verified_reset(const void *fit, const char *how)
+{
+	fit_verified.fit = fit;
+	fit_verified.how = how;
+	fit_verified.cmd = cmd_get_count();
+	fit_verified.count = 0;
+}
+
+void fit_verified_clear(void)
+{
+	fit_verified_reset(NULL, NULL);
+}
+
+/**
+ * fit_image_verified() - check if an image has already been verified
+ *
+ * @fit: pointer to the FIT format image header
+ * @image_noffset: component image node offset
+ * @return how the image was verified, or NULL if its hashes have not all been
+ * checked yet
+ */
+static const char *fit_image_verified(const void *fit, int image_noffset)
+{
+	struct fit_verified_image *image;
+	uint8_t *fit_value;
+	int fit_value_len;
+	const void *data;
+	size_t size;
+	int no_sigs;
+	int i;
+
+	if (fit != fit_verified.fit)
+		return NULL;
+
+	/*
+	 * Nothing can tell us whether the data has been written since it was
+	 * hashed, so only trust the digest within the command which loaded
+	 * the FIT (or verified it on all cores) and the one straight after,
+	 * e.g. 'tftpboot; bootm'. Anything else is hashed again.
+	 */
+	if (cmd_get_count() - fit_verified.cmd > 1)
+		return NULL;
+
+	/*
+	 * Something else may have been loaded here since, so make sure that
+	 * the FIT still expects the digest we calculated
+	 */
+	for (i = 0; i < fit_verified.count; i++) {
+		image = &fit_verified.image[i];
+		if (image->noffset != image_noffset)
+			continue;
+		if (fit_image_hash_get_value(fit, image->hash_noffset,
+					     &fit_value, &fit_value_len) ||
+		    fit_value_len > FIT_MAX_HASH_LEN ||
+		    memcmp(image->value, fit_value, fit_value_len))
+			return NULL;
+
+		/* Keys marked 'required' must still be checked */
+		if (IMAGE_ENABLE_VERIFY &&
+		    (fit_image_get_data_and_size(fit, image_noffset, &data,
+						 &size) ||
+		     fit_image_verify_required_sigs(fit, image_noffset, data,
+						    size, gd_fdt_blob(),
+						    &no_sigs)))
+			return NULL;
+
+		return fit_verified.how;
+	}
+
+	return NULL;
+}
+#else
+static const char *fit_image_verified(const void *fit, int image_noffset)
+{
+	return NULL;
+}
+#endif
+
+#if IMAGE_ENABLE_STREAM_VERIFY
+/*
+ * Streaming verification
+ *
+ * A loader which writes an image to memory front to back can tell us how
+ * much of it has arrived with fit_stream_data(). Once the FIT structure is
+ * complete we set up a progressive hash for each hash node, then hash image
+ * data as it lands, while it is still in the cache. fit_stream_end()
+ * compares the digests and records the images which matched in
+ * fit_verified.
+ *
+ * With CONFIG_FIT_STREAM_DECOMP the kernel of the default configuration is
+ * also decompressed into its load address as it lands. If that works, it is
+ * recorded in fit_decompressed for bootm_load_os().
+ */
+#define FIT_STREAM_MAX_HASHES	16
+
+struct fit_stream_hash {
+	int image_noffset;		/* Image node */
+	int noffset;			/* Hash node */
+	struct hash_algo *algo;
+	void *ctx;
+	ulong start;			/* Image data, as offsets from base */
+	ulong end;
+	ulong done;			/* Hashed up to here */
+};
+
+struct fit_stream_decomp {
+	bool active;
+	struct decomp_stream ds;
+	int noffset;			/* Kernel image node */
+	ulong load;			/* Kernel load address */
+	ulong start;			/* Kernel data, as offsets from base */
+	ulong end;
+	ulong done;			/* Decompressed up to here */
+};
+
+static struct fit_stream {
+	bool active;			/* Loading and looks like a FIT */
+	bool parsed;			/* FIT structure is complete */
+	ulong base;			/* Load address */
+	ulong size;			/* Bytes in memory so far */
+	int count;
+	struct fit_stream_hash hash[FIT_STREAM_MAX_HASHES];
+	struct fit_stream_decomp decomp;
+} fit_stream;
+
+/* The kernel which was decompressed while the FIT was loaded */
+static struct fit_decompressed {
+	bool valid;
+	int comp;
+	ulong data;			/* Compressed data address */
+	ulong len;			/* Compressed data size */
+	ulong load;
+	ulong size;			/* Uncompressed size */
+	ulong cmd;			/* Command it was decompressed in */
+} fit_decompressed;
+
+static void fit_stream_drop(struct fit_stream_hash *hash)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+
+	/* hash_finish() is the only way to free the context */
+	if (hash->ctx)
+		hash->algo->hash_finish(hash->algo, hash->ctx, value,
+					sizeof(value));
+	hash->ctx = NULL;
+}
+
+static void fit_stream_decomp_stop(void)
+{
+	struct fit_stream_decomp *sd = &fit_stream.decomp;
+	size_t out;
+
+	if (sd->active)
+		decomp_stream_finish(&sd->ds, &out);
+	sd->active = false;
+}
+
+static void fit_stream_reset(void)
+{
+	int i;
+
+	for (i = 0; i < fit_stream.count; i++)
+		fit_stream_drop(&fit_stream.hash[i]);
+	fit_stream_decomp_stop();
+	memset(&fit_stream, '\0', sizeof(fit_stream));
+}
+
+/* Only stream the algorithms which calculate_hash() would accept */
+static int fit_stream_algo(const char *name, struct hash_algo **algop)
+{
+	if (!(IMAGE_ENABLE_CRC32 && !strcmp(name, "crc32")) &&
+	    !(IMAGE_ENABLE_SHA1 && !strcmp(name, "sha1")) &&
+	    !(IMAGE_ENABLE_SHA256 && !strcmp(name, "sha256")))
+		return -EPROTONOSUPPORT;
+
+	return hash_progressive_lookup_algo(name, algop);
+}
+
+/* Add the hash nodes of one image, or none of them */
+static int fit_stream_add_image(const void *fit, int image_noffset)
+{
+	struct fit_stream_hash *hash;
+	const void *data;
+	size_t size;
+	int first = fit_stream.count;
+	int noffset;
+	char *algo;
+
+	if (fit_image_get_data_and_size(fit, image_noffset, &data, &size))
+		return -ENOENT;
+
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+
+		/* Signatures are checked the usual way */
+		if (!strncmp(name, FIT_SIG_NODENAME,
+			     strlen(FIT_SIG_NODENAME)))
+			goto err;
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+
+		if (fit_stream.count == FIT_STREAM_MAX_HASHES)
+			goto err;
+		hash = &fit_stream.hash[fit_stream.count];
+		if (fit_image_hash_get_algo(fit, noffset, &algo) ||
+		    fit_stream_algo(algo, &hash->algo) ||
+		    hash->algo->hash_init(hash->algo, &hash->ctx))
+			goto err;
+		hash->image_noffset = image_noffset;
+		hash->noffset = noffset;
+		hash->start = (ulong)data - (ulong)fit;
+		hash->end = hash->start + size;
+		hash->done = hash->start;
+		fit_stream.count++;
+	}
+
+	return 0;
+err:
+	while (fit_stream.count > first)
+		fit_stream_drop(&fit_stream.hash[--fit_stream.count]);
+	return -ENOTSUPP;
+}
+
+/* Offset of the end of the last image data in the FIT */
+static ulong fit_stream_fit_end(const void *fit)
+{
+	ulong end = fdt_totalsize(fit);
+	int images_noffset;
+	const void *data;
+	size_t size;
+	int noffset;
+
+	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	fdt_for_each_subnode(noffset, fit, images_noffset) {
+		if (!fit_image_get_data_and_size(fit, noffset, &data, &size))
+			end = max(end, (ulong)(data - fit) + size);
+	}
+
+	return end;
+}
+
+/*
+ * Start decompressing the kernel of the default configuration, as long as it
+ * can be written to its load address without landing on the FIT or on
+ * reserved memory
+ */
+static void fit_stream_decomp_start(const void *fit)
+{
+	struct fit_stream_decomp *sd = &fit_stream.decomp;
+	ulong base = fit_stream.base;
+	ulong load, dst_len;
+	const void *data;
+	size_t size;
+	uint8_t comp;
+	int noffset;
+#ifdef CONFIG_LMB
+	struct lmb lmb;
+#endif
+
+	if (!IMAGE_ENABLE_STREAM_DECOMP)
+		return;
+
+	noffset = fit_conf_get_node(fit, NULL);
+	if (noffset < 0)
+		return;
+	noffset = fit_conf_get_prop_node(fit, noffset, FIT_KERNEL_PROP);
+	if (noffset < 0 ||
+	    !fit_image_check_type(fit, noffset, IH_TYPE_KERNEL) ||
+	    fit_image_get_comp(fit, noffset, &comp) ||
+	    !decomp_stream_supported(comp) ||
+	    fit_image_get_load(fit, noffset, &load) ||
+	    fit_image_get_data_and_size(fit, noffset, &data, &size))
+		return;
+
+	dst_len = CONFIG_SYS_BOOTM_LEN;
+	if (load < base + fit_stream_fit_end(fit) && load + dst_len > base) {
+		if (load >= base)
+			return;
+		dst_len = base - load;
+	}
+#ifdef CONFIG_LMB
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+	dst_len = min(dst_len, (ulong)lmb_get_free_size(&lmb, load));
+#endif
+	if (!dst_len)
+		return;
+
+	if (decomp_stream_init(&sd->ds, comp, map_sysmem(load, dst_len),
+			       dst_len))
+		return;
+	sd->active = true;
+	sd->noffset = noffset;
+	sd->load = load;
+	sd->start = (ulong)data - (ulong)fit;
+	sd->end = sd->start + size;
+	sd->done = sd->start;
+	debug("%s: decompressing %s kernel to %lx\n", __func__,
+	      genimg_get_comp_name(comp), load);
+}
+
+static void fit_stream_decomp_data(const void *fit, ulong size)
+{
+	struct fit_stream_decomp *sd = &fit_stream.decomp;
+	ulong end;
+
+	if (!sd->active)
+		return;
+
+	/* Whatever follows the FIT must not run into the kernel */
+	if (sd->load >= fit_stream.base && fit_stream.base + size > sd->load) {
+		fit_stream_decomp_stop();
+		return;
+	}
+
+	end = min(sd->end, size);
+	if (end <= sd->done)
+		return;
+	if (decomp_stream_feed(&sd->ds, fit + sd->done, end - sd->done)) {
+		fit_stream_decomp_stop();
+		return;
+	}
+	sd->done = end;
+}
+
+static void fit_stream_decomp_end(void)
+{
+	struct fit_stream_decomp *sd = &fit_stream.decomp;
+	size_t out;
+	int ret, i;
+
+	if (!sd->active)
+		return;
+	sd->active = false;
+	ret = decomp_stream_finish(&sd->ds, &out);
+	if (ret || sd->done != sd->end)
+		return;
+
+	/* Only keep the output if the compressed data matched its hashes */
+	for (i = 0; i < fit_verified.count; i++) {
+		if (fit_verified.image[i].noffset == sd->noffset)
+			break;
+	}
+	if (i == fit_verified.count)
+		return;
+
+	fit_decompressed.valid = true;
+	fit_decompressed.comp = sd->ds.comp;
+	fit_decompressed.data = fit_stream.base + sd->start;
+	fit_decompressed.len = sd->end - sd->start;
+	fit_decompressed.load = sd->load;
+	fit_decompressed.size = out;
+	fit_decompressed.cmd = cmd_get_count();
+	debug("%s: kernel decompressed to %lx, %zx bytes\n", __func__,
+	      sd->load, out);
+}
+
+static void fit_stream_parse(const void *fit)
+{
+	int images_noffset;
+	int noffset;
+
+	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	if (images_noffset < 0) {
+		fit_stream.active = false;
+		return;
+	}
+
+	fdt_for_each_subnode(noffset, fit, images_noffset)
+		fit_stream_add_image(fit, noffset);
+	fit_stream_decomp_start(fit);
+	fit_stream.parsed = true;
+}
+
+void fit_stream_start(ulong addr)
+{
+	fit_stream_reset();
+	fit_verified_clear();
+	fit_decompressed.valid = false;
+	fit_stream.active = true;
+	fit_stream.base = addr;
+}
+
+void fit_stream_data(ulong size)
+{
+	struct fit_stream_hash *hash;
+	const void *fit;
+	ulong end;
+	int i;
+
+	if (!fit_stream.active || size <= fit_stream.size)
+		return;
+	fit_stream.size = size;
+
+	fit = map_sysmem(fit_stream.base, 0);
+	if (!fit_stream.parsed) {
+		if (size < sizeof(struct fdt_header))
+			return;
+		if (fdt_magic(fit) != FDT_MAGIC) {
+			fit_stream.active = false;
+			return;
+		}
+		if (size < fdt_totalsize(fit))
+			return;
+		fit_stream_parse(fit);
+	}
+
+	for (i = 0; i < fit_stream.count; i++) {
+		hash = &fit_stream.hash[i];
+		end = min(hash->end, size);
+		if (!hash->ctx || end <= hash->done)
+			continue;
+		if (hash->algo->hash_update(hash->algo, hash->ctx,
+					    fit + hash->done,
+					    end - hash->done, 0)) {
+			/* The context has been freed */
+			hash->ctx = NULL;
+			continue;
+		}
+		hash->done = end;
+	}
+	fit_stream_decomp_data(fit, size);
+}
+
+void fit_stream_written(const void *buf, ulong len)
+{
+	/* Filesystems read other things too, e.g. directories */
+	if (fit_stream.active &&
+	    map_to_sysmem(buf) == fit_stream.base + fit_stream.size)
+		fit_stream_data(fit_stream.size + len);
+}
+
+ulong fit_stream_chunk_size(void)
+{
+	return fit_stream.active ? CONFIG_FIT_STREAM_CHUNK_SIZE : 0;
+}
+
+/* Finish a hash and compare it with the value in the FIT */
+static int fit_stream_check(const void *fit, struct fit_stream_hash *hash,
+			    uint8_t *value)
+{
+	uint8_t *fit_value;
+	int fit_value_len;
+	int ret;
+
+	if (!hash->ctx || hash->done != hash->end) {
+		fit_stream_drop(hash);
+		return -EIO;
+	}
+	ret = hash->algo->hash_finish(hash->algo, hash->ctx, value,
+				      FIT_MAX_HASH_LEN);
+	hash->ctx = NULL;
+	if (ret)
+		return -EIO;
+
+	/* FIT stores CRC32 values big-endian, see calculate_hash() */
+	if (!strcmp(hash->algo->name, "crc32"))
+		*((uint32_t *)value) = cpu_to_uimage(*((uint32_t *)value));
+
+	if (fit_image_hash_get_value(fit, hash->noffset, &fit_value,
+				     &fit_value_len) ||
+	    fit_value_len != hash->algo->digest_size ||
+	    memcmp(value, fit_value, fit_value_len))
+		return -EACCES;
+
+	return 0;
+}
+
+void fit_stream_end(void)
+{
+	struct fit_verified_image *image = NULL;
+	struct fit_stream_hash *hash;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	const void *fit;
+	int i;
+
+	if (!fit_stream.active)
+		return;
+
+	fit = map_sysmem(fit_stream.base, 0);
+	fit_verified_reset(fit, "while loading");
+	for (i = 0; i < fit_stream.count; i++) {
+		hash = &fit_stream.hash[i];
+
+		/* The hashes of each image are next to each other */
+		if (!image || image->noffset != hash->image_noffset) {
+			if (image && image->hash_noffset >= 0)
+				fit_verified.count++;
+			image = &fit_verified.image[fit_verified.count];
+			image->noffset = hash->image_noffset;
+			image->hash_noffset = hash->noffset;
+		}
+
+		if (fit_stream_check(fit, hash, value))
+			image->hash_noffset = -1;
+		else if (image->hash_noffset == hash->noffset)
+			memcpy(image->value, value, hash->algo->digest_size);
+	}
+	if (image && image->hash_noffset >= 0)
+		fit_verified.count++;
+	debug("%s: %d images verified while loading\n", __func__,
+	      fit_verified.count);
+	fit_stream_decomp_end();
+
+	fit_stream.count = 0;
+	fit_stream.active = false;
+}
+
+bool fit_stream_active(void)
+{
+	return fit_stream.active;
+}
+
+#if IMAGE_ENABLE_STREAM_DECOMP
+bool fit_stream_decompressed(int comp, ulong load, ulong image_start,
+			     ulong image_len, ulong *load_end)
+{
+	struct fit_decompressed *fd = &fit_decompressed;
+	bool match;
+
+	/* As with the digests, nothing else may have run in between */
+	match = fd->valid && cmd_get_count() - fd->cmd <= 1 &&
+		fd->comp == comp && fd->load == load &&
+		fd->data == image_start && fd->len == image_len;
+	if (match)
+		*load_end = load + fd->size;
+
+	/* Anything may be loaded over it after this */
+	fd->valid = false;
+
+	return match;
+}
+#endif
+#endif /* IMAGE_ENABLE_STREAM_VERIFY */
+
+#if IMAGE_ENABLE_PARALLEL_VERIFY
+/*
+ * Parallel verification
+ *
+ * Before the first image of a configuration is loaded, hash all of the images
+ * it uses at once, one hash node per job, spread over all available cores.
+ * The images whose hashes all match are recorded in fit_verified.
+ */
+#define FIT_PARALLEL_MAX_HASHES	16
+
+struct fit_parallel_hash {
+	int image_noffset;		/* Image node */
+	int noffset;			/* Hash node */
+	const char *algo;
+	const void *data;
+	size_t size;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+};
+
+/*
+ * This may run on a secondary core, where the watchdog must not be touched,
+ * so use the plain hash functions rather than calculate_hash()
+ */
+static int fit_parallel_hash_job(void *arg)
+{
+	struct fit_parallel_hash *hash = arg;
+	sha256_context ctx;
+
+	if (IMAGE_ENABLE_CRC32 && !strcmp(hash->algo, "crc32")) {
+		*((uint32_t *)hash->value) =
+			cpu_to_uimage(crc32(0, hash->data, hash->size));
+		hash->value_len = 4;
+	} else if (IMAGE_ENABLE_SHA1 && !strcmp(hash->algo, "sha1")) {
+		sha1_csum(hash->data, hash->size, hash->value);
+		hash->value_len = SHA1_SUM_LEN;
+	} else if (IMAGE_ENABLE_SHA256 && !strcmp(hash->algo, "sha256")) {
+		sha256_starts(&ctx);
+		sha256_update(&ctx, hash->data, hash->size);
+		sha256_finish(&ctx, hash->value);
+		hash->value_len = SHA256_SUM_LEN;
+	} else if (IMAGE_ENABLE_MD5 && !strcmp(hash->algo, "md5")) {
+		md5((unsigned char *)hash->data, hash->size, hash->value);
+		hash->value_len = 16;
+	} else {
+		return -EPROTONOSUPPORT;
+	}
+
+	return 0;
+}
+
+/* Add the hash nodes of one image, or none of them */
+static int fit_parallel_add_image(const void *fit, int image_noffset,
+				  struct fit_parallel_hash *hash, int count)
+{
+	const void *data;
+	size_t size;
+	int first = count;
+	int noffset;
+	char *algo;
+	int i;
+
+	/* Images may be used more than once in a configuration */
+	for (i = 0; i < count; i++) {
+		if (hash[i].image_noffset == image_noffset)
+			return count;
+	}
+
+	if (fit_image_get_data_and_size(fit, image_noffset, &data, &size))
+		return first;
+
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+
+		/* Signatures are checked the usual way */
+		if (!strncmp(name, FIT_SIG_NODENAME,
+			     strlen(FIT_SIG_NODENAME)))
+			return first;
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+
+		if (count == FIT_PARALLEL_MAX_HASHES ||
+		    fit_image_hash_get_algo(fit, noffset, &algo))
+			return first;
+		memset(&hash[count], '\0', sizeof(*hash));
+		hash[count].image_noffset = image_noffset;
+		hash[count].noffset = noffset;
+		hash[count].algo = algo;
+		hash[count].data = data;
+		hash[count].size = size;
+		count++;
+	}
+
+	return count;
+}
+
+/**
+ * fit_conf_verify_parallel() - hash the images of a configuration at once
+ *
+ * Nothing is reported here: images which fail to verify are simply hashed
+ * again, with the usual messages, when they are loaded.
+ *
+ * @fit: pointer to the FIT format image header
+ * @cfg_noffset: configuration node offset
+ */
+static void fit_conf_verify_parallel(const void *fit, int cfg_noffset)
+{
+	static const char *const props[] = {
+		FIT_KERNEL_PROP, FIT_RAMDISK_PROP, FIT_FDT_PROP,
+		FIT_LOADABLE_PROP, FIT_FPGA_PROP,
+	};
+	struct fit_parallel_hash hash[FIT_PARALLEL_MAX_HASHES];
+	struct mp_job jobs[FIT_PARALLEL_MAX_HASHES];
+	struct fit_verified_image *image = NULL;
+	uint8_t *fit_value;
+	int fit_value_len;
+	int count = 0;
+	int noffset;
+	int i, j;
+
+	/* Keep what was verified while this FIT was being loaded */
+	if (fit_verified.fit == fit && fit_verified.count)
+		return;
+	if (mp_job_cores() < 2)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(props); i++) {
+		for (j = 0; ; j++) {
+			noffset = fit_conf_get_prop_node_index(fit, cfg_noffset,
+							       props[i], j);
+			if (noffset < 0)
+				break;
+			count = fit_parallel_add_image(fit, noffset, hash,
+						       count);
+		}
+	}
+	if (count < 2)
+		return;
+
+	for (i = 0; i < count; i++) {
+		jobs[i].func = fit_parallel_hash_job;
+		jobs[i].arg = &hash[i];
+	}
+	mp_job_run(jobs, count);
+
+	fit_verified_reset(fit, "on all cores");
+	for (i = 0; i < count; i++) {
+		/* The hashes of each image are next to each other */
+		if (!image || image->noffset != hash[i].image_noffset) {
+			if (image && image->hash_noffset >= 0)
+				fit_verified.count++;
+			image = &fit_verified.image[fit_verified.count];
+			image->noffset = hash[i].image_noffset;
+			image->hash_noffset = hash[i].noffset;
+			memcpy(image->value, hash[i].value, hash[i].value_len);
+		}
+
+		if (jobs[i].ret ||
+		    fit_image_hash_get_value(fit, hash[i].noffset, &fit_value,
+					     &fit_value_len) ||
+		    fit_value_len != hash[i].value_len ||
+		    memcmp(hash[i].value, fit_value, fit_value_len))
+			image->hash_noffset = -1;
+	}
+	if (image && image->hash_noffset >= 0)
+		fit_verified.count++;
+	debug("%s: %d images verified on %d cores\n", __func__,
+	      fit_verified.count, mp_job_cores());
+}
+#else
+static void fit_conf_verify_parallel(const void *fit, int cfg_noffset)
+{
+}
+#endif /* IMAGE_ENABLE_PARALLEL_VERIFY */
+
 static int fit_image_select(const void *fit, int rd_noffset, int verify)
 {
+	const char *verified;
+
 	fit_image_print(fit, rd_noffset, "   ");
 
 	if (verify) {
 		puts("   Verifying Hash Integrity ... ");
+		verified = fit_image_verified(fit, rd_noffset);
+		if (verified) {
+			printf("OK (%s)\n", verified);
+			return 0;
+		}
 		if (!fit_image_verify(fit, rd_noffset)) {
 			puts("Bad Data Hash\n");
 			return -EACCES;
@@ -1881,6 +2626,10 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 			puts("OK\n");
 		}
 
+		/* Hash all of the images of the configuration at once */
+		if (image_type == IH_TYPE_KERNEL && images->verify)
+			fit_conf_verify_parallel(fit, cfg_noffset);
+
 		bootstage_mark(BOOTSTAGE_ID_FIT_CONFIG);
 
 		noffset = fit_conf_get_prop_node(fit, cfg_noffset,
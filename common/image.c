@@ -17,9 +17,11 @@
 
 #include <rtc.h>
 
+#include <decomp_stream.h>
 #include <gzip.h>
 #include <image.h>
 #include <mapmem.h>
+#include <mp_job.h>
 
 #if IMAGE_ENABLE_FIT || IMAGE_ENABLE_OF_LIBFDT
 #include <linux/libfdt.h>
@@ -187,6 +189,7 @@ static const table_entry_t uimage_comp[] = {
 	{	IH_COMP_LZMA,	"lzma",		"lzma compressed",	},
 	{	IH_COMP_LZO,	"lzo",		"lzo compressed",	},
 	{	IH_COMP_LZ4,	"lz4",		"lz4 compressed",	},
+	{	IH_COMP_ZSTD,	"zstd",		"zstd compressed",	},
 	{	-1,		"",		"",			},
 };
 
@@ -474,6 +477,16 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 		break;
 	}
 #endif /* CONFIG_LZ4 */
+#ifdef CONFIG_ZSTD
+	case IH_COMP_ZSTD: {
+		size_t size = unc_len;
+
+		ret = decomp_stream_buf(IH_COMP_ZSTD, load_buf, &size,
+					image_buf, image_len);
+		image_len = size;
+		break;
+	}
+#endif /* CONFIG_ZSTD */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
 		return -ENOSYS;
@@ -637,6 +650,14 @@ void memmove_wd(void *to, void *from, size_t len, ulong chunksz)
 	if (to == from)
 		return;
 
+#if CONFIG_IS_ENABLED(MP_JOBS)
+	/* Unless the areas overlap, the other cores can help */
+	if (to + len <= from || from + len <= to) {
+		mp_memcpy(to, from, len);
+		return;
+	}
+#endif
+
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
 	if (to > from) {
 		from += len;
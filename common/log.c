@@ -179,18 +179,29 @@ static bool log_passes_filters(struct log_device *ldev, struct log_rec *rec)
  * log_dispatch() - Send a log record to all log devices for processing
  *
  * The log record is sent to each log device in turn, skipping those which have
- * filters which block the record
+ * filters which block the record. The message is only formatted once a device
+ * which needs it accepts the record, so records which only go to drivers with
+ * LOGDF_RAW set (or nowhere at all) cost very little.
  *
  * @rec: Log record to dispatch
  * @return 0 (meaning success)
  */
 static int log_dispatch(struct log_rec *rec)
 {
+	char buf[CONFIG_SYS_CBSIZE];
 	struct log_device *ldev;
+	va_list args;
 
 	list_for_each_entry(ldev, &gd->log_head, sibling_node) {
-		if (log_passes_filters(ldev, rec))
-			ldev->drv->emit(ldev, rec);
+		if (!log_passes_filters(ldev, rec))
+			continue;
+		if (!rec->msg && !(ldev->drv->flags & LOGDF_RAW)) {
+			va_copy(args, *rec->args);
+			vsnprintf(buf, sizeof(buf), rec->fmt, args);
+			va_end(args);
+			rec->msg = buf;
+		}
+		ldev->drv->emit(ldev, rec);
 	}
 
 	return 0;
@@ -199,25 +210,25 @@ static int log_dispatch(struct log_rec *rec)
 int _log(enum log_category_t cat, enum log_level_t level, const char *file,
 	 int line, const char *func, const char *fmt, ...)
 {
-	char buf[CONFIG_SYS_CBSIZE];
 	struct log_rec rec;
 	va_list args;
 
+	if (!gd || !(gd->flags & GD_FLG_LOG_READY)) {
+		if (gd)
+			gd->log_drop_count++;
+		return -ENOSYS;
+	}
 	rec.cat = cat;
 	rec.level = level;
 	rec.file = file;
 	rec.line = line;
 	rec.func = func;
+	rec.msg = NULL;
+	rec.fmt = fmt;
+	rec.args = &args;
 	va_start(args, fmt);
-	vsnprintf(buf, sizeof(buf), fmt, args);
-	va_end(args);
-	rec.msg = buf;
-	if (!gd || !(gd->flags & GD_FLG_LOG_READY)) {
-		if (gd)
-			gd->log_drop_count++;
-		return -ENOSYS;
-	}
 	log_dispatch(&rec);
+	va_end(args);
 
 	return 0;
 }
@@ -312,6 +323,8 @@ int log_init(void)
 		ldev->drv = drv;
 		list_add_tail(&ldev->sibling_node,
 			      (struct list_head *)&gd->log_head);
+		if (drv->probe && drv->probe(ldev))
+			debug("%s: Cannot probe '%s'\n", __func__, drv->name);
 		drv++;
 	}
 	gd->flags |= GD_FLG_LOG_READY;
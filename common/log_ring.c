@@ -0,0 +1,585 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Logging to a ring buffer in memory
+ *
+ * Each record holds the format string pointer and the raw arguments, along
+ * with the time it was generated. Formatting is put off until the log is
+ * dumped or passed to the OS, so debug logging can stay enabled without
+ * slowing the boot down, since nothing is formatted or sent to the console.
+ */
+
+#include <common.h>
+#include <fdtdec.h>
+#include <log.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <linux/ctype.h>
+#include <linux/libfdt.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* The signature ramoops expects at the start of its console region */
+#define RAMOOPS_SIG		0x43474244	/* DBGC */
+
+enum log_ring_rec_flags {
+	LRF_TEXT	= 1 << 0,	/* @args holds the formatted message */
+};
+
+/**
+ * struct log_ring_rec - A record in the ring buffer
+ *
+ * @len: Length of the record including this header, a multiple of 8. A
+ *	length of 0 marks unused space at the end of the buffer.
+ * @level: Log level
+ * @flags: Flags for this record (LRF_...)
+ * @cat: Log category
+ * @line: Line number where the record was generated
+ * @time_us: Time when the record was generated, from timer_get_us()
+ * @file: Name of file where the record was generated
+ * @func: Function where the record was generated
+ * @fmt: printf() format string, unless @flags has LRF_TEXT
+ * @args: Arguments, in the order they appear in @fmt. Numbers and pointers
+ *	take 8 bytes each. A string takes 8 bytes holding its length plus one
+ *	(0 for a NULL pointer), then the string and its terminator, padded to
+ *	a multiple of 8.
+ */
+struct log_ring_rec {
+	u16 len;
+	u8 level;
+	u8 flags;
+	u16 cat;
+	u16 line;
+	ulong time_us;
+	const char *file;
+	const char *func;
+	const char *fmt;
+	u64 args[];
+};
+
+/**
+ * struct log_ring - The ring buffer
+ *
+ * @head and @tail only ever increase; the offset in @buf is found by taking
+ * them modulo @size. Records do not wrap around the end of @buf.
+ *
+ * @buf: Buffer holding the records
+ * @size: Size of @buf in bytes
+ * @head: Position of the next record to write
+ * @tail: Position of the oldest record
+ * @dropped: Number of records overwritten to make space for newer ones
+ */
+struct log_ring {
+	void *buf;
+	ulong size;
+	ulong head;
+	ulong tail;
+	ulong dropped;
+};
+
+static struct log_ring log_ring;
+
+/**
+ * struct log_ring_spec - A printf() conversion specification
+ *
+ * @width_arg: true if the field width is taken from an argument ('*')
+ * @prec_arg: true if the precision is taken from an argument ('*')
+ * @qualifier: Length qualifier as understood by vsprintf(), 'L' for 'll',
+ *	or 0 if none
+ * @conv: Conversion character
+ */
+struct log_ring_spec {
+	bool width_arg;
+	bool prec_arg;
+	char qualifier;
+	char conv;
+};
+
+/**
+ * log_ring_parse_spec() - Parse a conversion specification
+ *
+ * @p: Position just after the '%'
+ * @spec: Returns the specification
+ * @return position of the conversion character
+ */
+static const char *log_ring_parse_spec(const char *p,
+				       struct log_ring_spec *spec)
+{
+	memset(spec, '\0', sizeof(*spec));
+	while (*p && strchr("-+ #0", *p))
+		p++;
+	if (*p == '*') {
+		spec->width_arg = true;
+		p++;
+	}
+	while (isdigit(*p))
+		p++;
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			spec->prec_arg = true;
+			p++;
+		}
+		while (isdigit(*p))
+			p++;
+	}
+	if (*p && strchr("hlLZzt", *p)) {
+		spec->qualifier = *p++;
+		if (spec->qualifier == 'l' && *p == 'l') {
+			spec->qualifier = 'L';
+			p++;
+		}
+	}
+	spec->conv = *p;
+
+	return p;
+}
+
+/**
+ * log_ring_save_args() - Save the arguments for a format string
+ *
+ * @fmt: printf() format string
+ * @args: Arguments for @fmt
+ * @out: Buffer to save them to
+ * @size: Size of @out in bytes
+ * @return number of bytes saved, -E2BIG if @out is too small, -ENOTSUPP if
+ *	@fmt uses a conversion which cannot be put off, e.g. one which prints
+ *	the data a pointer points to
+ */
+static int log_ring_save_args(const char *fmt, va_list args, u64 *out,
+			      size_t size)
+{
+	struct log_ring_spec spec;
+	u64 *ptr = out, *end = out + size / sizeof(u64);
+	const char *p, *str;
+	size_t len;
+
+	for (p = fmt; *p; p++) {
+		if (*p != '%')
+			continue;
+		p = log_ring_parse_spec(p + 1, &spec);
+		if (ptr + spec.width_arg + spec.prec_arg + 1 > end)
+			return -E2BIG;
+		if (spec.width_arg)
+			*ptr++ = va_arg(args, int);
+		if (spec.prec_arg)
+			*ptr++ = va_arg(args, int);
+		switch (spec.conv) {
+		case 'c':
+		case 'd':
+		case 'i':
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			if (spec.qualifier == 'L')
+				*ptr++ = va_arg(args, unsigned long long);
+			else if (spec.qualifier == 'l')
+				*ptr++ = va_arg(args, unsigned long);
+			else if (spec.qualifier == 'Z' || spec.qualifier == 'z')
+				*ptr++ = va_arg(args, size_t);
+			else if (spec.qualifier == 't')
+				*ptr++ = va_arg(args, ptrdiff_t);
+			else
+				*ptr++ = va_arg(args, unsigned int);
+			break;
+		case 's':
+			if (spec.qualifier == 'l')
+				return -ENOTSUPP;
+			str = va_arg(args, const char *);
+			if (!str) {
+				*ptr++ = 0;
+				break;
+			}
+			len = strlen(str) + 1;
+			if (len > (end - ptr - 1) * sizeof(u64))
+				return -E2BIG;
+			*ptr++ = len;
+			memcpy(ptr, str, len);
+			ptr += DIV_ROUND_UP(len, sizeof(u64));
+			break;
+		case 'p':
+			if (isalnum(p[1]))
+				return -ENOTSUPP;
+			*ptr++ = (uintptr_t)va_arg(args, void *);
+			break;
+		case 'n':
+			return -ENOTSUPP;
+		case '\0':
+			return (ptr - out) * sizeof(u64);
+		}
+	}
+
+	return (ptr - out) * sizeof(u64);
+}
+
+/**
+ * log_ring_format() - Format the message of a record
+ *
+ * Each conversion is passed to snprintf() on its own, with the argument
+ * saved for it.
+ *
+ * @rec: Record to format
+ * @buf: Buffer for the message
+ * @size: Size of @buf in bytes
+ * @return length of the message, which is truncated to fit @buf
+ */
+static int log_ring_format(const struct log_ring_rec *rec, char *buf,
+			   size_t size)
+{
+	const u64 *arg = rec->args;
+	struct log_ring_spec spec;
+	char conv[24], *out = buf, *end = buf + size - 1;
+	const char *p, *start;
+	u64 val;
+	int len;
+
+	if (rec->flags & LRF_TEXT) {
+		strlcpy(buf, (const char *)rec->args, size);
+		return strlen(buf);
+	}
+
+	for (p = rec->fmt; *p && out < end; p++) {
+		if (*p != '%') {
+			*out++ = *p;
+			continue;
+		}
+		start = p;
+		p = log_ring_parse_spec(p + 1, &spec);
+		if (!*p)
+			break;
+		if (*p == '%') {
+			*out++ = '%';
+			continue;
+		}
+
+		/* Copy the specification, filling in any '*' arguments */
+		len = 0;
+		for (; start <= p && len < sizeof(conv) - 12; start++) {
+			if (*start == '*')
+				len += sprintf(conv + len, "%d", (int)*arg++);
+			else
+				conv[len++] = *start;
+		}
+		conv[len] = '\0';
+
+		val = *arg;
+		switch (spec.conv) {
+		case 'c':
+		case 'd':
+		case 'i':
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			arg++;
+			if (spec.qualifier == 'L')
+				len = snprintf(out, end - out + 1, conv, val);
+			else if (spec.qualifier == 'l')
+				len = snprintf(out, end - out + 1, conv,
+					       (ulong)val);
+			else if (spec.qualifier == 'Z' || spec.qualifier == 'z')
+				len = snprintf(out, end - out + 1, conv,
+					       (size_t)val);
+			else if (spec.qualifier == 't')
+				len = snprintf(out, end - out + 1, conv,
+					       (ptrdiff_t)val);
+			else
+				len = snprintf(out, end - out + 1, conv,
+					       (uint)val);
+			break;
+		case 's':
+			arg++;
+			len = snprintf(out, end - out + 1, conv,
+				       val ? (const char *)arg : NULL);
+			arg += DIV_ROUND_UP(val, sizeof(u64));
+			break;
+		case 'p':
+			arg++;
+			len = snprintf(out, end - out + 1, conv,
+				       (void *)(uintptr_t)val);
+			break;
+		default:
+			len = snprintf(out, end - out + 1, "%s", conv);
+			break;
+		}
+		out += min_t(int, len, end - out);
+	}
+	*out = '\0';
+
+	return out - buf;
+}
+
+static void log_ring_drop(struct log_ring *ring)
+{
+	struct log_ring_rec *rec = ring->buf + ring->tail % ring->size;
+
+	if (rec->len) {
+		ring->tail += rec->len;
+		ring->dropped++;
+	} else {
+		ring->tail = roundup(ring->tail + 1, ring->size);
+	}
+}
+
+/**
+ * log_ring_alloc() - Make space for a new record
+ *
+ * The oldest records are dropped to make space if needed. Since records do
+ * not wrap, one of up to half the size of the buffer always fits once enough
+ * have been dropped.
+ *
+ * @ring: Ring buffer
+ * @len: Length of the record, a multiple of 8, at most @ring->size / 2
+ * @return pointer to the space for the record
+ */
+static struct log_ring_rec *log_ring_alloc(struct log_ring *ring, uint len)
+{
+	ulong offset = ring->head % ring->size;
+	ulong pad = offset + len > ring->size ? ring->size - offset : 0;
+	struct log_ring_rec *rec;
+
+	while (ring->size - (ring->head - ring->tail) < pad + len)
+		log_ring_drop(ring);
+	if (pad) {
+		rec = ring->buf + offset;
+		rec->len = 0;
+		ring->head += pad;
+		offset = 0;
+	}
+
+	return ring->buf + offset;
+}
+
+static int log_ring_emit(struct log_device *ldev, struct log_rec *rec)
+{
+	struct log_ring *ring = &log_ring;
+	u64 args[CONFIG_SYS_CBSIZE / sizeof(u64)];
+	struct log_ring_rec *out;
+	va_list copy;
+	int flags = 0;
+	uint size;
+	int len;
+
+	/* The ring buffer is only set up after relocation */
+	if (!(gd->flags & GD_FLG_RELOC) || !ring->buf)
+		return -ENOSYS;
+
+	va_copy(copy, *rec->args);
+	len = log_ring_save_args(rec->fmt, copy, args, sizeof(args));
+	va_end(copy);
+	if (len < 0) {
+		va_copy(copy, *rec->args);
+		vsnprintf((char *)args, sizeof(args), rec->fmt, copy);
+		va_end(copy);
+		len = strlen((char *)args) + 1;
+		flags = LRF_TEXT;
+	}
+
+	size = sizeof(*out) + ALIGN(len, sizeof(u64));
+	if (size > ring->size / 2)
+		return -E2BIG;
+
+	/*
+	 * Fill in the record before moving the head past it, so that a
+	 * reader never sees a partial record
+	 */
+	out = log_ring_alloc(ring, size);
+	out->len = size;
+	out->level = rec->level;
+	out->flags = flags;
+	out->cat = rec->cat;
+	out->line = rec->line;
+	out->time_us = timer_get_us();
+	out->file = rec->file;
+	out->func = rec->func;
+	out->fmt = rec->fmt;
+	memcpy(out->args, args, len);
+	ring->head += out->len;
+
+	return 0;
+}
+
+/**
+ * log_ring_line() - Format a record as a line of text
+ *
+ * This uses the same fields as the console driver, with the time first.
+ *
+ * @rec: Record to format
+ * @buf: Buffer for the line
+ * @size: Size of @buf in bytes
+ * @return length of the line
+ */
+static int log_ring_line(const struct log_ring_rec *rec, char *buf,
+			 size_t size)
+{
+	int fmt = gd->log_fmt;
+	int len;
+
+	len = snprintf(buf, size, "[%5lu.%06lu] ", rec->time_us / 1000000,
+		       rec->time_us % 1000000);
+	if (fmt & (1 << LOGF_LEVEL))
+		len += snprintf(buf + len, size - len, "%s.",
+				log_get_level_name(rec->level));
+	if (fmt & (1 << LOGF_CAT))
+		len += snprintf(buf + len, size - len, "%s,",
+				log_get_cat_name(rec->cat));
+	if (fmt & (1 << LOGF_FILE))
+		len += snprintf(buf + len, size - len, "%s:", rec->file);
+	if (fmt & (1 << LOGF_LINE))
+		len += snprintf(buf + len, size - len, "%d-", rec->line);
+	if (fmt & (1 << LOGF_FUNC))
+		len += snprintf(buf + len, size - len, "%s()", rec->func);
+	if (fmt & (1 << LOGF_MSG)) {
+		if (fmt != (1 << LOGF_MSG))
+			len += snprintf(buf + len, size - len, " ");
+		len += log_ring_format(rec, buf + len, size - len);
+	}
+
+	return min_t(int, len, size - 1);
+}
+
+/**
+ * log_ring_walk() - Format each record in the ring buffer, oldest first
+ *
+ * @func: Function to call with each line
+ * @priv: Private data for @func
+ */
+static void log_ring_walk(void (*func)(const char *line, int len, void *priv),
+			  void *priv)
+{
+	struct log_ring *ring = &log_ring;
+	struct log_ring_rec *rec;
+	char buf[CONFIG_SYS_CBSIZE + 128];
+	ulong pos;
+	int len;
+
+	for (pos = ring->tail; pos != ring->head;) {
+		rec = ring->buf + pos % ring->size;
+		if (!rec->len) {
+			pos = roundup(pos + 1, ring->size);
+			continue;
+		}
+		len = log_ring_line(rec, buf, sizeof(buf));
+		func(buf, len, priv);
+		pos += rec->len;
+	}
+}
+
+static void log_ring_print_line(const char *line, int len, void *priv)
+{
+	puts(line);
+}
+
+int log_ring_dump(void)
+{
+	if (!log_ring.buf)
+		return -ENOENT;
+	if (log_ring.dropped)
+		printf("(%lu older records dropped)\n", log_ring.dropped);
+	log_ring_walk(log_ring_print_line, NULL);
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(LOG_RING_HANDOFF)
+/**
+ * struct ramoops_buffer - Header of a ramoops region, as Linux expects
+ *
+ * @sig: RAMOOPS_SIG
+ * @start: Offset in @data where the next byte would be written
+ * @size: Number of bytes of @data in use
+ * @data: Circular buffer of text
+ */
+struct ramoops_buffer {
+	u32 sig;
+	u32 start;
+	u32 size;
+	u8 data[];
+};
+
+struct log_ring_handoff {
+	struct ramoops_buffer *buf;
+	u32 data_size;
+	ulong written;
+};
+
+static void log_ring_add_line(const char *line, int len, void *priv)
+{
+	struct log_ring_handoff *ho = priv;
+	ulong pos = ho->written % ho->data_size;
+	int part;
+
+	/* Older text is overwritten, as Linux would do itself */
+	for (; len; line += part, len -= part) {
+		part = min_t(ulong, len, ho->data_size - pos);
+		memcpy(ho->buf->data + pos, line, part);
+		ho->written += part;
+		pos = 0;
+	}
+}
+
+int log_ring_fdt_fixup(void *blob)
+{
+	/* Each boot attempt reuses the region, so it is only reserved once */
+	static struct ramoops_buffer *handoff_buf;
+	struct log_ring_handoff ho;
+	struct fdt_memory region;
+	ulong size = CONFIG_LOG_RING_HANDOFF_SIZE;
+	uint32_t phandle;
+	int node, ret;
+
+	if (!log_ring.buf)
+		return -ENOENT;
+	if (!handoff_buf) {
+		handoff_buf = memalign(SZ_4K, size);
+		if (!handoff_buf)
+			return -ENOMEM;
+	}
+	ho.buf = handoff_buf;
+	ho.data_size = size - sizeof(*ho.buf);
+	ho.written = 0;
+	log_ring_walk(log_ring_add_line, &ho);
+	ho.buf->sig = RAMOOPS_SIG;
+	ho.buf->start = ho.written % ho.data_size;
+	ho.buf->size = min_t(ulong, ho.written, ho.data_size);
+
+	region.start = map_to_sysmem(ho.buf);
+	region.end = region.start + size - 1;
+	ret = fdtdec_add_reserved_memory(blob, "ramoops", &region, &phandle);
+	if (ret)
+		return ret;
+	node = fdt_node_offset_by_phandle(blob, phandle);
+	if (node < 0)
+		return node;
+	ret = fdt_setprop_string(blob, node, "compatible", "ramoops");
+	if (!ret)
+		ret = fdt_setprop_u32(blob, node, "console-size", size);
+
+	return ret;
+}
+#endif
+
+static int log_ring_probe(struct log_device *ldev)
+{
+	int ret;
+
+	/* Wait until after relocation, so the buffer is not lost */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return 0;
+	log_ring.buf = memalign(sizeof(u64), CONFIG_LOG_RING_SIZE);
+	if (!log_ring.buf)
+		return -ENOMEM;
+	log_ring.size = CONFIG_LOG_RING_SIZE;
+	ret = log_add_filter(ldev->drv->name, NULL, CONFIG_LOG_RING_LEVEL,
+			     NULL);
+
+	return ret < 0 ? ret : 0;
+}
+
+LOG_DRIVER(ring) = {
+	.name	= "ring",
+	.flags	= LOGDF_RAW,
+	.probe	= log_ring_probe,
+	.emit	= log_ring_emit,
+};
@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Small allocations served from per-size slabs
+ *
+ * Driver model, the filesystems and the network stack make thousands of
+ * allocations of a few dozen bytes. Each size class here takes whole pages
+ * from dlmalloc and hands out fixed-size objects from them through a free
+ * list, which is quicker than searching dlmalloc's bins and keeps small
+ * objects from scattering free fragments all over the pool.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <malloc_slab.h>
+#include <linux/bitops.h>
+#include <linux/list.h>
+
+/* Each slab page is one naturally aligned page taken from dlmalloc */
+#define SLAB_PAGE_SIZE		4096
+
+/* Alignment of every object, at least as much as malloc() gives */
+#define SLAB_ALIGN		16
+
+static const u16 slab_sizes[] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, SLAB_MAX_SIZE
+};
+
+#define SLAB_CLASSES		ARRAY_SIZE(slab_sizes)
+
+/**
+ * struct slab_page - Header at the start of each slab page
+ *
+ * @node:	Link in the class's list of pages with free objects
+ * @free:	First free object, each of which points to the next
+ * @class:	Size class of the objects in the page
+ * @used:	Number of objects allocated
+ */
+struct slab_page {
+	struct list_head node;
+	void *free;
+	u16 class;
+	u16 used;
+};
+
+#define SLAB_HDR_SIZE		ALIGN(sizeof(struct slab_page), SLAB_ALIGN)
+
+/**
+ * struct slab_class - A size class
+ *
+ * @partial:	Pages with at least one free object
+ * @stats:	Statistics, including the object size
+ */
+struct slab_class {
+	struct list_head partial;
+	struct slab_stats stats;
+};
+
+/**
+ * struct slab_state - The slabs in the malloc() pool
+ *
+ * @base:	Address of the first page covered by @map
+ * @end:	End of the malloc() pool
+ * @map:	One bit per page of the pool, set if the page is a slab
+ * @classes:	Size classes, smallest first
+ * @index:	Size class for each request size, in units of SLAB_ALIGN
+ */
+struct slab_state {
+	ulong base;
+	ulong end;
+	ulong *map;
+	struct slab_class classes[SLAB_CLASSES];
+	u8 index[SLAB_MAX_SIZE / SLAB_ALIGN + 1];
+};
+
+static struct slab_state slab;
+
+static uint slab_page_objects(int class)
+{
+	return (SLAB_PAGE_SIZE - SLAB_HDR_SIZE) / slab_sizes[class];
+}
+
+static void slab_map_set(struct slab_page *sp, bool set)
+{
+	ulong page = ((ulong)sp - slab.base) / SLAB_PAGE_SIZE;
+	ulong mask = BIT(page % BITS_PER_LONG);
+
+	if (set)
+		slab.map[page / BITS_PER_LONG] |= mask;
+	else
+		slab.map[page / BITS_PER_LONG] &= ~mask;
+}
+
+static struct slab_page *slab_page_of(const void *mem)
+{
+	ulong addr = (ulong)mem;
+	ulong page;
+
+	if (!slab.map || addr < slab.base || addr >= slab.end)
+		return NULL;
+	page = (addr - slab.base) / SLAB_PAGE_SIZE;
+	if (!(slab.map[page / BITS_PER_LONG] & BIT(page % BITS_PER_LONG)))
+		return NULL;
+
+	return (struct slab_page *)(slab.base + page * SLAB_PAGE_SIZE);
+}
+
+size_t slab_init(ulong start, size_t size)
+{
+	size_t pages, map_size;
+	int i, class;
+
+	memset(&slab, '\0', sizeof(slab));
+	slab.base = round_down(start, SLAB_PAGE_SIZE);
+	slab.end = start + size;
+	pages = DIV_ROUND_UP(slab.end - slab.base, SLAB_PAGE_SIZE);
+	map_size = ALIGN(BITS_TO_LONGS(pages) * sizeof(ulong), SLAB_ALIGN);
+	if (map_size + SLAB_PAGE_SIZE * 2 > size)
+		return 0;	/* too small to bother */
+
+	slab.map = (ulong *)start;
+	memset(slab.map, '\0', map_size);
+	for (class = 0; class < SLAB_CLASSES; class++) {
+		INIT_LIST_HEAD(&slab.classes[class].partial);
+		slab.classes[class].stats.size = slab_sizes[class];
+	}
+	for (i = 0, class = 0; i < ARRAY_SIZE(slab.index); i++) {
+		while (slab_sizes[class] < i * SLAB_ALIGN)
+			class++;
+		slab.index[i] = class;
+	}
+
+	return map_size;
+}
+
+static struct slab_page *slab_new_page(int class)
+{
+	struct slab_class *sc = &slab.classes[class];
+	uint count = slab_page_objects(class);
+	struct slab_page *sp;
+	void *obj;
+	int i;
+
+	sp = memalign(SLAB_PAGE_SIZE, SLAB_PAGE_SIZE);
+	if (!sp)
+		return NULL;
+	slab_map_set(sp, true);
+	sp->class = class;
+	sp->used = 0;
+
+	/* Thread the objects onto the free list, lowest address first */
+	sp->free = NULL;
+	for (i = count - 1; i >= 0; i--) {
+		obj = (void *)sp + SLAB_HDR_SIZE + i * slab_sizes[class];
+		*(void **)obj = sp->free;
+		sp->free = obj;
+	}
+	list_add(&sp->node, &sc->partial);
+	sc->stats.pages++;
+	sc->stats.objects += count;
+
+	return sp;
+}
+
+static void slab_release_page(struct slab_page *sp)
+{
+	struct slab_class *sc = &slab.classes[sp->class];
+
+	list_del(&sp->node);
+	sc->stats.pages--;
+	sc->stats.objects -= slab_page_objects(sp->class);
+	slab_map_set(sp, false);
+	free(sp);
+}
+
+void *slab_alloc(size_t bytes)
+{
+	struct slab_class *sc;
+	struct slab_page *sp;
+	void *obj;
+	int class;
+
+	if (!slab.map)
+		return NULL;
+	class = slab.index[DIV_ROUND_UP(bytes, SLAB_ALIGN)];
+	sc = &slab.classes[class];
+	if (list_empty(&sc->partial) && !slab_new_page(class)) {
+		sc->stats.misses++;
+		return NULL;
+	}
+
+	sp = list_first_entry(&sc->partial, struct slab_page, node);
+	obj = sp->free;
+	sp->free = *(void **)obj;
+	sp->used++;
+	if (!sp->free)
+		list_del(&sp->node);	/* now full */
+	sc->stats.used++;
+	sc->stats.allocs++;
+
+	return obj;
+}
+
+bool slab_free(void *mem)
+{
+	struct slab_page *sp = slab_page_of(mem);
+	struct slab_class *sc;
+
+	if (!sp)
+		return false;
+	sc = &slab.classes[sp->class];
+	if (!sp->free)
+		list_add(&sp->node, &sc->partial);	/* no longer full */
+	*(void **)mem = sp->free;
+	sp->free = mem;
+	sp->used--;
+	sc->stats.used--;
+	sc->stats.frees++;
+
+	/* Keep the last page of each class, in case it is needed again soon */
+	if (!sp->used && sc->stats.pages > 1)
+		slab_release_page(sp);
+
+	return true;
+}
+
+size_t slab_usable_size(const void *mem)
+{
+	struct slab_page *sp = slab_page_of(mem);
+
+	return sp ? slab_sizes[sp->class] : 0;
+}
+
+int slab_get_stats(int class, struct slab_stats *stats)
+{
+	if (class < 0 || class >= SLAB_CLASSES)
+		return -ENOENT;
+	*stats = slab.classes[class].stats;
+
+	return 0;
+}
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Splitting memory operations into jobs for the secondary cores
+ */
+
+#include <common.h>
+#include <mp_job.h>
+#include <linux/sizes.h>
+
+/* Areas smaller than this are not worth waking the other cores for */
+#define MP_MEM_MIN_SIZE		SZ_1M
+
+/* Most pieces an operation is split into */
+#define MP_MEM_MAX_JOBS		16
+
+struct mp_mem_job {
+	void *dest;
+	const void *src;
+	size_t len;
+	int c;
+};
+
+static int mp_memcpy_job(void *arg)
+{
+	struct mp_mem_job *mj = arg;
+
+	memcpy(mj->dest, mj->src, mj->len);
+
+	return 0;
+}
+
+static int mp_memset_job(void *arg)
+{
+	struct mp_mem_job *mj = arg;
+
+	memset(mj->dest, mj->c, mj->len);
+
+	return 0;
+}
+
+static void mp_mem_run(int (*func)(void *arg), void *dest, const void *src,
+		       int c, size_t len)
+{
+	struct mp_mem_job mem[MP_MEM_MAX_JOBS];
+	struct mp_job jobs[MP_MEM_MAX_JOBS];
+	size_t chunk, done;
+	int count, i;
+
+	count = min(mp_job_cores(), MP_MEM_MAX_JOBS);
+
+	/* Make each piece a whole number of cache lines */
+	chunk = ALIGN(DIV_ROUND_UP(len, count), ARCH_DMA_MINALIGN);
+	for (i = 0, done = 0; done < len; i++, done += chunk) {
+		mem[i].dest = dest + done;
+		mem[i].src = src ? src + done : NULL;
+		mem[i].len = min(chunk, len - done);
+		mem[i].c = c;
+		jobs[i].func = func;
+		jobs[i].arg = &mem[i];
+	}
+	mp_job_run(jobs, i);
+}
+
+void *mp_memcpy(void *dest, const void *src, size_t len)
+{
+	if (len < MP_MEM_MIN_SIZE || mp_job_cores() < 2)
+		return memcpy(dest, src, len);
+	mp_mem_run(mp_memcpy_job, dest, src, 0, len);
+
+	return dest;
+}
+
+void *mp_memset(void *s, int c, size_t len)
+{
+	if (len < MP_MEM_MIN_SIZE || mp_job_cores() < 2)
+		return memset(s, c, len);
+	mp_mem_run(mp_memset_job, s, NULL, c, len);
+
+	return s;
+}
@@ -10,44 +10,154 @@
 #include <part.h>
 #include <linux/ctype.h>
 #include <linux/list.h>
+#include <linux/log2.h>
 
-struct block_cache_node {
+/*
+ * The cache is split into a power-of-two number of sets, each holding up to
+ * BLKCACHE_WAYS entries in MRU order. An entry lives in the set selected by
+ * hashing (iftype, devnum) with the group of max_blocks_per_entry blocks its
+ * start is in. An entry can only cover blocks in its own group or the next,
+ * so a lookup walks at most two sets.
+ */
+#define BLKCACHE_WAYS	4
+
+/* A block device which has been seen by the cache */
+struct block_cache_dev {
 	struct list_head lh;
-	int iftype;
-	int devnum;
+	struct list_head nodes;		/* entries for this device, MRU first */
+	struct block_cache_dev_stats stats;
+};
+
+struct block_cache_node {
+	struct list_head lh;		/* position in its set */
+	struct list_head dev_lh;	/* position in its device's list */
+	struct block_cache_dev *dev;
 	lbaint_t start;
 	lbaint_t blkcnt;
 	unsigned long blksz;
 	char *cache;
 };
 
-static LIST_HEAD(block_cache);
+static LIST_HEAD(block_cache_devs);
+static struct list_head *block_cache_sets;
+static unsigned block_cache_nsets;
 
 static struct block_cache_stats _stats = {
 	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_entries = 32,
+	.max_dev_entries = 0,
 };
 
+static struct list_head *cache_set(int iftype, int devnum, lbaint_t group)
+{
+	u32 hash;
+
+	hash = (u32)group ^ (u32)((u64)group >> 32) ^
+	       ((u32)devnum << 16) ^ ((u32)iftype << 24);
+	hash *= 0x9e3779b1;
+
+	return &block_cache_sets[hash >> 16 & (block_cache_nsets - 1)];
+}
+
+/* The set an entry starting at @start belongs in */
+static struct list_head *cache_start_set(int iftype, int devnum,
+					 lbaint_t start)
+{
+	return cache_set(iftype, devnum, start / _stats.max_blocks_per_entry);
+}
+
+static int cache_setup(void)
+{
+	unsigned ways, nsets, i;
+
+	if (block_cache_sets)
+		return 0;
+
+	/*
+	 * Round the number of sets up, so that none of the capacity asked for
+	 * is lost; blkcache_fill() keeps to max_entries in total
+	 */
+	ways = min(_stats.max_entries, (unsigned)BLKCACHE_WAYS);
+	nsets = roundup_pow_of_two(DIV_ROUND_UP(_stats.max_entries, ways));
+	block_cache_sets = malloc(nsets * sizeof(*block_cache_sets));
+	if (!block_cache_sets)
+		return -ENOMEM;
+	for (i = 0; i < nsets; i++)
+		INIT_LIST_HEAD(&block_cache_sets[i]);
+	block_cache_nsets = nsets;
+	_stats.sets = nsets;
+	_stats.ways = ways;
+
+	return 0;
+}
+
+static struct block_cache_dev *cache_dev(int iftype, int devnum, bool create)
+{
+	struct block_cache_dev *cdev;
+
+	list_for_each_entry(cdev, &block_cache_devs, lh)
+		if (cdev->stats.iftype == iftype &&
+		    cdev->stats.devnum == devnum)
+			return cdev;
+	if (!create)
+		return NULL;
+
+	cdev = calloc(1, sizeof(*cdev));
+	if (!cdev)
+		return NULL;
+	INIT_LIST_HEAD(&cdev->nodes);
+	cdev->stats.iftype = iftype;
+	cdev->stats.devnum = devnum;
+	list_add_tail(&cdev->lh, &block_cache_devs);
+
+	return cdev;
+}
+
 static struct block_cache_node *cache_find(int iftype, int devnum,
 					   lbaint_t start, lbaint_t blkcnt,
 					   unsigned long blksz)
 {
+	lbaint_t group = start / _stats.max_blocks_per_entry;
 	struct block_cache_node *node;
+	struct list_head *set;
+	int i;
 
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
+	if (!block_cache_sets)
+		return NULL;
+
+	/* Look for an entry starting in this group, then the one before */
+	for (i = 0; i < 2 && i <= group; i++) {
+		set = cache_set(iftype, devnum, group - i);
+		list_for_each_entry(node, set, lh)
+			if ((node->dev->stats.iftype == iftype) &&
+			    (node->dev->stats.devnum == devnum) &&
+			    (node->blksz == blksz) &&
+			    (node->start <= start) &&
+			    (node->start + node->blkcnt >= start + blkcnt)) {
 				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
+				list_move(&node->lh, set);
+				list_move(&node->dev_lh, &node->dev->nodes);
+				return node;
 			}
-			return node;
-		}
-	return 0;
+	}
+	return NULL;
+}
+
+static void cache_drop(struct block_cache_node *node)
+{
+	debug("drop: start " LBAF ", count " LBAFU "\n",
+	      node->start, node->blkcnt);
+	list_del(&node->lh);
+	list_del(&node->dev_lh);
+	node->dev->stats.entries--;
+	_stats.entries--;
+}
+
+static void cache_free(struct block_cache_node *node)
+{
+	cache_drop(node);
+	free(node->cache);
+	free(node);
 }
 
 int blkcache_read(int iftype, int devnum,
@@ -56,18 +166,28 @@ int blkcache_read(int iftype, int devnum,
 {
 	struct block_cache_node *node = cache_find(iftype, devnum, start,
 						   blkcnt, blksz);
+	struct block_cache_dev *cdev;
+
 	if (node) {
 		const char *src = node->cache + (start - node->start) * blksz;
+
 		memcpy(buffer, src, blksz * blkcnt);
 		debug("hit: start " LBAF ", count " LBAFU "\n",
 		      start, blkcnt);
 		++_stats.hits;
+		_stats.bytes_saved += blksz * blkcnt;
+		++node->dev->stats.hits;
+		node->dev->stats.bytes_saved += blksz * blkcnt;
 		return 1;
 	}
 
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 	++_stats.misses;
+	/* Only keep track of devices while there is a cache */
+	cdev = cache_dev(iftype, devnum, _stats.max_entries != 0);
+	if (cdev)
+		++cdev->stats.misses;
 	return 0;
 }
 
@@ -76,7 +196,10 @@ void blkcache_fill(int iftype, int devnum,
 		   unsigned long blksz, void const *buffer)
 {
 	lbaint_t bytes;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *victim;
+	struct block_cache_dev *cdev;
+	struct list_head *set;
+	unsigned count;
 
 	/* don't cache big stuff */
 	if (blkcnt > _stats.max_blocks_per_entry)
@@ -85,14 +208,56 @@ void blkcache_fill(int iftype, int devnum,
 	if (_stats.max_entries == 0)
 		return;
 
+	if (cache_setup())
+		return;
+
+	cdev = cache_dev(iftype, devnum, true);
+	if (!cdev)
+		return;
+
 	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
+	set = cache_start_set(iftype, devnum, start);
+
+	/*
+	 * Reuse an older, shorter copy of the same blocks if there is one.
+	 * Otherwise make room: a device which has used up its share of the
+	 * cache gives up its LRU entry, and a full set gives up its LRU entry.
+	 */
+	node = NULL;
+	count = 0;
+	list_for_each_entry(victim, set, lh) {
+		if (victim->dev == cdev && victim->start == start) {
+			node = victim;
+			break;
+		}
+		count++;
+	}
+	if (!node) {
+		if (_stats.max_dev_entries &&
+		    cdev->stats.entries >= _stats.max_dev_entries) {
+			node = list_last_entry(&cdev->nodes,
+					       struct block_cache_node, dev_lh);
+			if (cache_start_set(iftype, devnum, node->start) == set)
+				count--;
+		}
+		/* Sets are rounded up, so the cache may fill before the set */
+		if (!node && _stats.entries >= _stats.max_entries) {
+			if (!count)
+				return;
+			count = _stats.ways;
+		}
+		if (count >= _stats.ways) {
+			victim = list_last_entry(set, struct block_cache_node,
+						 lh);
+			if (node)
+				cache_free(victim);
+			else
+				node = victim;
+		}
+	}
+
+	if (node) {
+		cache_drop(node);
 		if (node->blkcnt * node->blksz < bytes) {
 			free(node->cache);
 			node->cache = 0;
@@ -115,58 +280,100 @@ void blkcache_fill(int iftype, int devnum,
 	debug("fill: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 
-	node->iftype = iftype;
-	node->devnum = devnum;
+	node->dev = cdev;
 	node->start = start;
 	node->blkcnt = blkcnt;
 	node->blksz = blksz;
 	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
+	list_add(&node->lh, set);
+	list_add(&node->dev_lh, &cdev->nodes);
+	cdev->stats.entries++;
 	_stats.entries++;
 }
 
+void blkcache_invalidate_range(int iftype, int devnum,
+			       lbaint_t start, lbaint_t blkcnt)
+{
+	struct block_cache_node *node, *n;
+	struct block_cache_dev *cdev;
+
+	cdev = cache_dev(iftype, devnum, false);
+	if (!cdev)
+		return;
+
+	list_for_each_entry_safe(node, n, &cdev->nodes, dev_lh)
+		if ((node->start < start + blkcnt) &&
+		    (node->start + node->blkcnt > start))
+			cache_free(node);
+}
+
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
+	struct block_cache_dev *cdev;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
-		}
-	}
+	cdev = cache_dev(iftype, devnum, false);
+	if (!cdev)
+		return;
+
+	list_for_each_entry_safe(node, n, &cdev->nodes, dev_lh)
+		cache_free(node);
 }
 
-void blkcache_configure(unsigned blocks, unsigned entries)
+void blkcache_configure(unsigned blocks, unsigned entries,
+			unsigned dev_entries)
 {
-	struct block_cache_node *node;
+	struct block_cache_dev *cdev, *n;
+
 	if ((blocks != _stats.max_blocks_per_entry) ||
 	    (entries != _stats.max_entries)) {
 		/* invalidate cache */
-		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
+		list_for_each_entry_safe(cdev, n, &block_cache_devs, lh) {
+			blkcache_invalidate(cdev->stats.iftype,
+					    cdev->stats.devnum);
+			list_del(&cdev->lh);
+			free(cdev);
 		}
-		_stats.entries = 0;
+		free(block_cache_sets);
+		block_cache_sets = NULL;
+		block_cache_nsets = 0;
+		_stats.sets = 0;
+		_stats.ways = 0;
 	}
 
 	_stats.max_blocks_per_entry = blocks;
 	_stats.max_entries = entries;
+	_stats.max_dev_entries = dev_entries;
 
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.bytes_saved = 0;
+}
+
+int blkcache_dev_stats(int index, struct block_cache_dev_stats *stats)
+{
+	struct block_cache_dev *cdev;
+
+	list_for_each_entry(cdev, &block_cache_devs, lh)
+		if (!index--) {
+			memcpy(stats, &cdev->stats, sizeof(*stats));
+			return 0;
+		}
+
+	return -ENOENT;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
 {
+	struct block_cache_dev *cdev;
+
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.bytes_saved = 0;
+	list_for_each_entry(cdev, &block_cache_devs, lh) {
+		cdev->stats.hits = 0;
+		cdev->stats.misses = 0;
+		cdev->stats.bytes_saved = 0;
+	}
 }
@@ -50,6 +50,12 @@ static enum caam_hash_algos get_hash_type(struct hash_algo *algo)
 		return SHA256;
 }
 
+/*
+ * Once this much data is queued and SEC is idle, start hashing it while the
+ * caller gets the next buffer ready
+ */
+#define CAAM_HASH_STEP_MIN	0x10000
+
 /* Create the context for progressive hashing using h/w acceleration.
  *
  * @ctxp: Pointer to the pointer of the context for hashing
@@ -58,11 +64,153 @@ static enum caam_hash_algos get_hash_type(struct hash_algo *algo)
  */
 static int caam_hash_init(void **ctxp, enum caam_hash_algos caam_algo)
 {
-	*ctxp = calloc(1, sizeof(struct sha_ctx));
-	if (*ctxp == NULL) {
+	struct sha_ctx *ctx;
+
+	ctx = malloc_cache_aligned(sizeof(struct sha_ctx));
+	if (ctx == NULL) {
 		debug("Cannot allocate memory for context\n");
 		return -ENOMEM;
 	}
+	memset(ctx, 0, sizeof(struct sha_ctx));
+
+	/* SEC writes the running context and hash, so nothing must be dirty */
+	flush_dcache_range((unsigned long)ctx,
+			   (unsigned long)ctx + sizeof(struct sha_ctx));
+	*ctxp = ctx;
+
+	return 0;
+}
+
+static uint32_t sg_entry_len(struct sg_entry *sg)
+{
+	return sec_in32(&sg->len_flag) & SG_ENTRY_LENGTH_MASK;
+}
+
+/* Add a buffer to the sg table of the current step */
+static void caam_hash_add(struct sha_ctx *ctx, const void *buf,
+			  unsigned int size)
+{
+	struct sha_step *step = &ctx->step[ctx->cur];
+	phys_addr_t addr = virt_to_phys((void *)buf);
+
+#ifdef CONFIG_PHYS_64BIT
+	sec_out32(&step->sg_tbl[ctx->sg_num].addr_hi, (uint32_t)(addr >> 32));
+#else
+	sec_out32(&step->sg_tbl[ctx->sg_num].addr_hi, 0x0);
+#endif
+	sec_out32(&step->sg_tbl[ctx->sg_num].addr_lo, (uint32_t)addr);
+
+	sec_out32(&step->sg_tbl[ctx->sg_num].len_flag,
+		  (size & SG_ENTRY_LENGTH_MASK));
+
+	step->sg_buf[ctx->sg_num] = buf;
+	ctx->sg_num++;
+	ctx->len += size;
+}
+
+/* Mark the last entry in the sg table of the current step */
+static void caam_hash_set_final(struct sha_ctx *ctx)
+{
+	struct sha_step *step = &ctx->step[ctx->cur];
+	uint32_t final;
+
+	if (!ctx->sg_num)
+		return;
+	final = sec_in32(&step->sg_tbl[ctx->sg_num - 1].len_flag) |
+		SG_ENTRY_FINAL_BIT;
+	sec_out32(&step->sg_tbl[ctx->sg_num - 1].len_flag, final);
+}
+
+/* Wait for SEC to finish the step it is working on, if any */
+static int caam_hash_wait(struct sha_ctx *ctx)
+{
+	int ret;
+
+	if (!ctx->pending)
+		return 0;
+	ret = run_descriptor_jr_wait(&ctx->pending->op);
+	ctx->pending = NULL;
+	if (ret)
+		debug("Error %x\n", ret);
+
+	return ret;
+}
+
+/* Check, without waiting, whether SEC is free to start another step */
+static bool caam_hash_idle(struct sha_ctx *ctx)
+{
+	if (ctx->pending && !ctx->pending->op.done)
+		run_descriptor_jr_poll();
+
+	return !ctx->pending || ctx->pending->op.done;
+}
+
+/*
+ * Start hashing the whole blocks in the current step, then move on to the
+ * other step, starting it with any partial block left over
+ *
+ * SEC saves the running context at the end of each step and the next step
+ * loads it again, so there is no limit on the number of buffers hashed.
+ * Callers may not say which update is the last, so a whole block is kept
+ * back if nothing else is, leaving data for the final step to hash.
+ */
+static int caam_hash_flush(struct sha_ctx *ctx,
+			   enum caam_hash_algos caam_algo)
+{
+	struct sha_step *step = &ctx->step[ctx->cur];
+	struct sha_step *next = &ctx->step[!ctx->cur];
+	uint32_t ctx_len = driver_hash[caam_algo].digestsize + HASH_MSG_LEN;
+	uint32_t rem = ctx->len % SHA_BLOCK_SIZE ?: SHA_BLOCK_SIZE;
+	uint32_t left, len, take;
+	int num = ctx->sg_num;
+	int ret;
+
+	/* The other step's carry buffer may still be in use */
+	ret = caam_hash_wait(ctx);
+	if (ret)
+		return ret;
+
+	/* Take the partial (or kept back) block off the end of the table */
+	rem = min(rem, ctx->len);
+	left = rem;
+	while (left) {
+		len = sg_entry_len(&step->sg_tbl[num - 1]);
+		take = min(len, left);
+		memcpy(next->carry + left - take,
+		       step->sg_buf[num - 1] + len - take, take);
+		left -= take;
+		if (take == len)
+			num--;
+		else
+			sec_out32(&step->sg_tbl[num - 1].len_flag, len - take);
+	}
+
+	if (num) {
+		ctx->sg_num = num;
+		caam_hash_set_final(ctx);
+		inline_cnstr_jobdesc_hash_step(step->sha_desc,
+					       (uint8_t *)step->sg_tbl,
+					       ctx->len - rem, ctx->run_ctx,
+					       ctx_len,
+					       driver_hash[caam_algo].alg_type,
+					       ctx->started ? OP_ALG_AS_UPDATE :
+					       OP_ALG_AS_INIT, ctx->run_ctx,
+					       ctx_len);
+		flush_dcache_range((unsigned long)step,
+				   (unsigned long)step + sizeof(*step));
+		ret = run_descriptor_jr_async(step->sha_desc, &step->op);
+		if (ret)
+			return ret;
+		ctx->pending = step;
+		ctx->started = true;
+	}
+
+	ctx->cur = !ctx->cur;
+	ctx->sg_num = 0;
+	ctx->len = 0;
+	if (rem)
+		caam_hash_add(ctx, next->carry, rem);
+
 	return 0;
 }
 
@@ -70,47 +218,49 @@ static int caam_hash_init(void **ctxp, enum caam_hash_algos caam_algo)
  * Update sg table for progressive hashing using h/w acceleration
  *
  * The context is freed by this function if an error occurs.
- * We support at most 32 Scatter/Gather Entries.
+ * Each step takes at most 32 Scatter/Gather Entries; once they are used up,
+ * or enough data is queued and SEC is idle, SEC starts hashing what there is
+ * while more is added. The buffer must not change until the hash is
+ * finished.
  *
  * @hash_ctx: Pointer to the context for hashing
  * @buf: Pointer to the buffer being hashed
  * @size: Size of the buffer being hashed
  * @is_last: 1 if this is the last update; 0 otherwise
  * @caam_algo: Enum for SHA1 or SHA256
- * @return 0 if ok, -EINVAL on error
+ * @return 0 if ok, non-zero on error
  */
 static int caam_hash_update(void *hash_ctx, const void *buf,
 			    unsigned int size, int is_last,
 			    enum caam_hash_algos caam_algo)
 {
-	uint32_t final = 0;
-	phys_addr_t addr = virt_to_phys((void *)buf);
 	struct sha_ctx *ctx = hash_ctx;
+	unsigned long start, end;
+	int ret;
 
 	if (ctx->sg_num >= MAX_SG_32) {
-		free(ctx);
-		return -EINVAL;
+		ret = caam_hash_flush(ctx, caam_algo);
+		if (ret)
+			goto err;
 	}
 
-#ifdef CONFIG_PHYS_64BIT
-	sec_out32(&ctx->sg_tbl[ctx->sg_num].addr_hi, (uint32_t)(addr >> 32));
-#else
-	sec_out32(&ctx->sg_tbl[ctx->sg_num].addr_hi, 0x0);
-#endif
-	sec_out32(&ctx->sg_tbl[ctx->sg_num].addr_lo, (uint32_t)addr);
-
-	sec_out32(&ctx->sg_tbl[ctx->sg_num].len_flag,
-		  (size & SG_ENTRY_LENGTH_MASK));
-
-	ctx->sg_num++;
+	start = (unsigned long)buf & ~(ARCH_DMA_MINALIGN - 1);
+	end = ALIGN((unsigned long)buf + size, ARCH_DMA_MINALIGN);
+	flush_dcache_range(start, end);
+	caam_hash_add(ctx, buf, size);
 
 	if (is_last) {
-		final = sec_in32(&ctx->sg_tbl[ctx->sg_num - 1].len_flag) |
-			SG_ENTRY_FINAL_BIT;
-		sec_out32(&ctx->sg_tbl[ctx->sg_num - 1].len_flag, final);
+		caam_hash_set_final(ctx);
+	} else if (ctx->len >= CAAM_HASH_STEP_MIN && caam_hash_idle(ctx)) {
+		ret = caam_hash_flush(ctx, caam_algo);
+		if (ret)
+			goto err;
 	}
 
 	return 0;
+err:
+	free(ctx);
+	return ret;
 }
 
 /*
@@ -128,32 +278,43 @@ static int caam_hash_update(void *hash_ctx, const void *buf,
 static int caam_hash_finish(void *hash_ctx, void *dest_buf,
 			    int size, enum caam_hash_algos caam_algo)
 {
-	uint32_t len = 0;
 	struct sha_ctx *ctx = hash_ctx;
-	int i = 0, ret = 0;
+	struct sha_step *step = &ctx->step[ctx->cur];
+	unsigned int digestsize = driver_hash[caam_algo].digestsize;
+	int ret = 0;
 
-	if (size < driver_hash[caam_algo].digestsize) {
+	if (size < digestsize) {
+		caam_hash_wait(ctx);
 		free(ctx);
 		return -EINVAL;
 	}
 
-	for (i = 0; i < ctx->sg_num; i++)
-		len += (sec_in32(&ctx->sg_tbl[i].len_flag) &
-			SG_ENTRY_LENGTH_MASK);
-
-	inline_cnstr_jobdesc_hash(ctx->sha_desc, (uint8_t *)ctx->sg_tbl, len,
-				  ctx->hash,
-				  driver_hash[caam_algo].alg_type,
-				  driver_hash[caam_algo].digestsize,
-				  1);
-
-	ret = run_descriptor_jr(ctx->sha_desc);
-
+	ret = caam_hash_wait(ctx);
 	if (ret)
+		goto out;
+
+	caam_hash_set_final(ctx);
+	inline_cnstr_jobdesc_hash_step(step->sha_desc, (uint8_t *)step->sg_tbl,
+				       ctx->len, ctx->run_ctx,
+				       digestsize + HASH_MSG_LEN,
+				       driver_hash[caam_algo].alg_type,
+				       ctx->started ? OP_ALG_AS_FINALIZE :
+				       OP_ALG_AS_INITFINAL, ctx->hash,
+				       digestsize);
+	flush_dcache_range((unsigned long)step,
+			   (unsigned long)step + sizeof(*step));
+
+	ret = run_descriptor_jr(step->sha_desc);
+
+	if (ret) {
 		debug("Error %x\n", ret);
-	else
-		memcpy(dest_buf, ctx->hash, sizeof(ctx->hash));
-
+	} else {
+		invalidate_dcache_range((unsigned long)ctx->hash,
+					(unsigned long)ctx->hash +
+					sizeof(ctx->hash));
+		memcpy(dest_buf, ctx->hash, digestsize);
+	}
+out:
 	free(ctx);
 	return ret;
 }
@@ -11,23 +11,53 @@
 #include <hash.h>
 #include "jr.h"
 
-/* We support at most 32 Scatter/Gather Entries.*/
+/* We support at most 32 Scatter/Gather Entries in each step */
 #define MAX_SG_32	32
 
+/* Block size of SHA-1 and SHA-256; every step but the last is whole blocks */
+#define SHA_BLOCK_SIZE	64
+
+/* The running context holds the digest so far and the message length */
+#define HASH_MSG_LEN	8
+#define MAX_HASH_CTX	(HASH_MAX_DIGEST_SIZE + HASH_MSG_LEN)
+
 /*
- * Hash context contains the following fields
+ * A step of progressive hashing, which SEC may be working on while the
+ * next step is filled in
  * @sha_desc: Sha Descriptor
- * @sg_num: number of entries in sg table
- * @len: total length of buffer
  * @sg_tbl: sg entry table
+ * @sg_buf: buffer for each entry in sg table
+ * @carry: partial block left over from the previous step
+ * @op: result of running the descriptor
+ */
+struct sha_step {
+	uint32_t sha_desc[64];
+	struct sg_entry sg_tbl[MAX_SG_32];
+	const void *sg_buf[MAX_SG_32];
+	u8 carry[SHA_BLOCK_SIZE];
+	struct result op;
+} __aligned(ARCH_DMA_MINALIGN);
+
+/*
+ * Hash context contains the following fields
+ * @step: steps used in turn
+ * @cur: index of the step being filled in
+ * @pending: step which SEC is working on, or NULL
+ * @started: true once a step has been run, so there is a running context
+ * @sg_num: number of entries in sg table of the current step
+ * @len: total length of buffers in the current step
+ * @run_ctx: running context saved by each step for the next
  * @hash: index to the hash calculated
  */
 struct sha_ctx {
-	uint32_t sha_desc[64];
+	struct sha_step step[2];
+	int cur;
+	struct sha_step *pending;
+	bool started;
 	uint32_t sg_num;
 	uint32_t len;
-	struct sg_entry sg_tbl[MAX_SG_32];
-	u8 hash[HASH_MAX_DIGEST_SIZE];
+	u8 run_ctx[MAX_HASH_CTX] __aligned(ARCH_DMA_MINALIGN);
+	u8 hash[HASH_MAX_DIGEST_SIZE] __aligned(ARCH_DMA_MINALIGN);
 };
 
 #endif
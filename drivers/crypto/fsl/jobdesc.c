@@ -203,6 +203,49 @@ void inline_cnstr_jobdesc_hash(uint32_t *desc,
 	append_store(desc, dma_addr_out, storelen,
 		     LDST_CLASS_2_CCB | LDST_SRCDST_BYTE_CONTEXT);
 }
+
+void inline_cnstr_jobdesc_hash_step(uint32_t *desc, const uint8_t *sg_tbl,
+				    uint32_t msgsz, uint8_t *ctx,
+				    uint32_t ctx_len, u32 alg_type,
+				    u32 state, uint8_t *out, uint32_t out_len)
+{
+	u32 options;
+	dma_addr_t dma_addr_in, dma_addr_ctx, dma_addr_out;
+
+	dma_addr_in = virt_to_phys((void *)sg_tbl);
+	dma_addr_ctx = virt_to_phys((void *)ctx);
+	dma_addr_out = virt_to_phys((void *)out);
+
+	init_job_desc(desc, 0);
+
+	/* Carry on from the running context saved by the previous step */
+	if (state == OP_ALG_AS_UPDATE || state == OP_ALG_AS_FINALIZE)
+		append_load(desc, dma_addr_ctx, ctx_len,
+			    LDST_CLASS_2_CCB | LDST_SRCDST_BYTE_CONTEXT);
+
+	append_operation(desc, OP_TYPE_CLASS2_ALG |
+			 OP_ALG_AAI_HASH | state |
+			 OP_ALG_ENCRYPT | OP_ALG_ICV_OFF | alg_type);
+
+	/* An empty table may be stale, so do not point SEC at it */
+	options = LDST_CLASS_2_CCB | FIFOLD_TYPE_MSG;
+	if (msgsz)
+		options |= FIFOLDST_SGF;
+	else
+		dma_addr_in = 0;
+	if (state == OP_ALG_AS_FINALIZE || state == OP_ALG_AS_INITFINAL)
+		options |= FIFOLD_TYPE_LAST2;
+	if (msgsz > 0xffff) {
+		options |= FIFOLDST_EXT;
+		append_fifo_load(desc, dma_addr_in, 0, options);
+		append_cmd(desc, msgsz);
+	} else {
+		append_fifo_load(desc, dma_addr_in, msgsz, options);
+	}
+
+	append_store(desc, dma_addr_out, out_len,
+		     LDST_CLASS_2_CCB | LDST_SRCDST_BYTE_CONTEXT);
+}
 #ifndef CONFIG_SPL_BUILD
 void inline_cnstr_jobdesc_blob_encap(uint32_t *desc, uint8_t *key_idnfr,
 				     uint8_t *plain_txt, uint8_t *enc_blob,
@@ -31,6 +31,28 @@ void inline_cnstr_jobdesc_hash(uint32_t *desc,
 			  const uint8_t *msg, uint32_t msgsz, uint8_t *digest,
 			  u32 alg_type, uint32_t alg_size, int sg_tbl);
 
+/* inline_cnstr_jobdesc_hash_step:
+ * Constructs a job descriptor which hashes part of a message given by a
+ * scatter/gather table, so that a message can be hashed in any number of
+ * steps.
+ * @desc: reference to the job descriptor
+ * @sg_tbl: reference to the scatter/gather table
+ * @msgsz: number of bytes in the table; must be a multiple of the block
+ *	size unless this is the last step
+ * @ctx: running context, loaded for OP_ALG_AS_UPDATE and OP_ALG_AS_FINALIZE
+ * @ctx_len: size of the running context in bytes
+ * @alg_type: algorithm selector, e.g. OP_ALG_ALGSEL_SHA256
+ * @state: OP_ALG_AS_INIT, OP_ALG_AS_UPDATE, OP_ALG_AS_FINALIZE or
+ *	OP_ALG_AS_INITFINAL
+ * @out: where to store the running context, or the digest after the last
+ *	step
+ * @out_len: number of bytes to store
+ */
+void inline_cnstr_jobdesc_hash_step(uint32_t *desc, const uint8_t *sg_tbl,
+				    uint32_t msgsz, uint8_t *ctx,
+				    uint32_t ctx_len, u32 alg_type,
+				    u32 state, uint8_t *out, uint32_t out_len);
+
 void inline_cnstr_jobdesc_blob_encap(uint32_t *desc, uint8_t *key_idnfr,
 				     uint8_t *plain_txt, uint8_t *enc_blob,
 				     uint32_t in_sz);
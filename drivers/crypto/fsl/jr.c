@@ -191,6 +191,9 @@ static int jr_enqueue(uint32_t *desc_addr,
 	uint32_t *addr_hi, *addr_lo;
 #endif
 
+	if (!CIRC_SPACE(head, jr->tail, jr->size))
+		return -1;
+
 	/* The descriptor must be submitted to SEC block as per endianness
 	 * of the SEC Block.
 	 * So, if the endianness of Core and SEC block is different, each word
@@ -271,9 +274,21 @@ static int jr_dequeue(int sec_idx)
 
 	while (sec_in32(&regs->orsf) && CIRC_CNT(jr->head, jr->tail,
 						 jr->size)) {
+		unsigned long start, end;
 
 		found = 0;
 
+		/*
+		 * Jobs complete in any order and several may be in flight, so
+		 * the entry may have been read into the cache before SEC
+		 * wrote it
+		 */
+		start = (unsigned long)&jr->output_ring[jr->read_idx] &
+			~(ARCH_DMA_MINALIGN - 1);
+		end = ALIGN((unsigned long)&jr->output_ring[jr->read_idx] +
+			    sizeof(struct op_ring), ARCH_DMA_MINALIGN);
+		invalidate_dcache_range(start, end);
+
 		phys_addr_t op_desc;
 	#ifdef CONFIG_PHYS_64BIT
 		/* Read the 64 bit Descriptor address from Output Ring.
@@ -281,11 +296,11 @@ static int jr_dequeue(int sec_idx)
 		 * depend on endianness of SEC block.
 		 */
 	#ifdef CONFIG_SYS_FSL_SEC_LE
-		addr_lo = (uint32_t *)(&jr->output_ring[jr->tail].desc);
-		addr_hi = (uint32_t *)(&jr->output_ring[jr->tail].desc) + 1;
+		addr_lo = (uint32_t *)(&jr->output_ring[jr->read_idx].desc);
+		addr_hi = (uint32_t *)(&jr->output_ring[jr->read_idx].desc) + 1;
 	#elif defined(CONFIG_SYS_FSL_SEC_BE)
-		addr_hi = (uint32_t *)(&jr->output_ring[jr->tail].desc);
-		addr_lo = (uint32_t *)(&jr->output_ring[jr->tail].desc) + 1;
+		addr_hi = (uint32_t *)(&jr->output_ring[jr->read_idx].desc);
+		addr_lo = (uint32_t *)(&jr->output_ring[jr->read_idx].desc) + 1;
 	#endif /* ifdef CONFIG_SYS_FSL_SEC_LE */
 
 		op_desc = ((u64)sec_in32(addr_hi) << 32) |
@@ -293,15 +308,16 @@ static int jr_dequeue(int sec_idx)
 
 	#else
 		/* Read the 32 bit Descriptor address from Output Ring. */
-		addr = (uint32_t *)&jr->output_ring[jr->tail].desc;
+		addr = (uint32_t *)&jr->output_ring[jr->read_idx].desc;
 		op_desc = sec_in32(addr);
 	#endif /* ifdef CONFIG_PHYS_64BIT */
 
-		uint32_t status = sec_in32(&jr->output_ring[jr->tail].status);
+		uint32_t status = sec_in32(&jr->output_ring[jr->read_idx].status);
 
 		for (i = 0; CIRC_CNT(head, tail + i, jr->size) >= 1; i++) {
 			idx = (tail + i) & (jr->size - 1);
-			if (op_desc == jr->info[idx].desc_phys_addr) {
+			if (!jr->info[idx].op_done &&
+			    op_desc == jr->info[idx].desc_phys_addr) {
 				found = 1;
 				break;
 			}
@@ -316,19 +332,19 @@ static int jr_dequeue(int sec_idx)
 		arg = jr->info[idx].arg;
 
 		/* When the job on tail idx gets done, increment
-		 * tail till the point where job completed out of oredr has
+		 * tail till the point where job completed out of order has
 		 * been taken into account
 		 */
-		if (idx == tail)
-			do {
-				tail = (tail + 1) & (jr->size - 1);
-			} while (jr->info[tail].op_done);
+		while (CIRC_CNT(head, tail, jr->size) &&
+		       jr->info[tail].op_done) {
+			jr->info[tail].op_done = 0;
+			tail = (tail + 1) & (jr->size - 1);
+		}
 
 		jr->tail = tail;
 		jr->read_idx = (jr->read_idx + 1) & (jr->size - 1);
 
 		sec_out32(&regs->orjr, 1);
-		jr->info[idx].op_done = 0;
 
 		callback(status, arg);
 	}
@@ -346,45 +362,66 @@ static void desc_done(uint32_t status, void *arg)
 	x->done = 1;
 }
 
-static inline int run_descriptor_jr_idx(uint32_t *desc, uint8_t sec_idx)
+/*
+ * Queue a descriptor, first waiting for earlier jobs to finish if the ring is
+ * full
+ */
+static int jr_submit(uint32_t *desc, struct result *op, uint8_t sec_idx)
 {
 	unsigned long long timeval = get_ticks();
 	unsigned long long timeout = usec2ticks(CONFIG_SEC_DEQ_TIMEOUT);
-	struct result op;
-	int ret = 0;
 
-	memset(&op, 0, sizeof(op));
+	memset(op, 0, sizeof(*op));
+	while (jr_enqueue(desc, desc_done, op, sec_idx)) {
+		if (jr_dequeue(sec_idx)) {
+			debug("Error in SEC deq\n");
+			return JQ_DEQ_ERR;
+		}
 
-	ret = jr_enqueue(desc, desc_done, &op, sec_idx);
-	if (ret) {
-		debug("Error in SEC enq\n");
-		ret = JQ_ENQ_ERR;
-		goto out;
+		if ((get_ticks() - timeval) > timeout) {
+			debug("Error in SEC enq\n");
+			return JQ_ENQ_ERR;
+		}
 	}
 
-	timeval = get_ticks();
-	timeout = usec2ticks(CONFIG_SEC_DEQ_TIMEOUT);
-	while (op.done != 1) {
-		ret = jr_dequeue(sec_idx);
-		if (ret) {
+	return 0;
+}
+
+static int jr_wait(struct result *op, uint8_t sec_idx)
+{
+	unsigned long long timeval = get_ticks();
+	unsigned long long timeout = usec2ticks(CONFIG_SEC_DEQ_TIMEOUT);
+
+	while (op->done != 1) {
+		if (jr_dequeue(sec_idx)) {
 			debug("Error in SEC deq\n");
-			ret = JQ_DEQ_ERR;
-			goto out;
+			return JQ_DEQ_ERR;
 		}
 
 		if ((get_ticks() - timeval) > timeout) {
 			debug("SEC Dequeue timed out\n");
-			ret = JQ_DEQ_TO_ERR;
-			goto out;
+			return JQ_DEQ_TO_ERR;
 		}
 	}
 
-	if (op.status) {
-		debug("Error %x\n", op.status);
-		ret = op.status;
+	if (op->status) {
+		debug("Error %x\n", op->status);
+		return op->status;
 	}
-out:
-	return ret;
+
+	return 0;
+}
+
+static inline int run_descriptor_jr_idx(uint32_t *desc, uint8_t sec_idx)
+{
+	struct result op;
+	int ret;
+
+	ret = jr_submit(desc, &op, sec_idx);
+	if (ret)
+		return ret;
+
+	return jr_wait(&op, sec_idx);
 }
 
 int run_descriptor_jr(uint32_t *desc)
@@ -392,6 +429,21 @@ int run_descriptor_jr(uint32_t *desc)
 	return run_descriptor_jr_idx(desc, 0);
 }
 
+int run_descriptor_jr_async(uint32_t *desc, struct result *op)
+{
+	return jr_submit(desc, op, 0);
+}
+
+int run_descriptor_jr_poll(void)
+{
+	return jr_dequeue(0) ? JQ_DEQ_ERR : 0;
+}
+
+int run_descriptor_jr_wait(struct result *op)
+{
+	return jr_wait(op, 0);
+}
+
 static inline int jr_reset_sec(uint8_t sec_idx)
 {
 	if (jr_hw_reset(sec_idx) < 0)
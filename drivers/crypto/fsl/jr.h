@@ -104,4 +104,25 @@ struct result {
 void caam_jr_strstatus(u32 status);
 int run_descriptor_jr(uint32_t *desc);
 
+/*
+ * Run descriptors without waiting for them
+ *
+ * Up to JR_SIZE - 1 descriptors can be in flight on the job ring at once,
+ * and they may complete in any order. The descriptor and @op must stay
+ * valid until the job is done.
+ *
+ * run_descriptor_jr_async() queues a descriptor, waiting for room on the
+ * ring if it is full. @op->done is set once the job has run. Returns 0 if
+ * queued, or an error code.
+ *
+ * run_descriptor_jr_poll() handles any jobs which have completed, without
+ * waiting. Returns 0 if ok, or JQ_DEQ_ERR.
+ *
+ * run_descriptor_jr_wait() waits for the job using @op to complete.
+ * Returns 0 if it succeeded, the SEC status if it failed, or an error code.
+ */
+int run_descriptor_jr_async(uint32_t *desc, struct result *op);
+int run_descriptor_jr_poll(void);
+int run_descriptor_jr_wait(struct result *op);
+
 #endif
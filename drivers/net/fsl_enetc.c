@@ -443,11 +443,17 @@ static void enetc_setup_rx_bdr(struct udevice *dev)
 	memset(priv->enetc_rxbd, 0,
 	       rx_bdr->bd_count * sizeof(union enetc_rx_bd));
 	for (i = 0; i < rx_bdr->bd_count; i++) {
+		priv->rx_buf[i] = net_rx_packets[i];
 		priv->enetc_rxbd[i].w.addr = enetc_rxb_address(dev, i);
 		/* each RX buffer must be aligned to 64B */
 		WARN_ON(priv->enetc_rxbd[i].w.addr & (ARCH_DMA_MINALIGN - 1));
 	}
 
+	/* HW may fill all but one BD, the one before the consumer index */
+	priv->rx_direct = NULL;
+	priv->rx_direct_bd = -1;
+	priv->rx_hw = rx_bdr->bd_count - 1;
+
 	/* reset producer (ENETC owned) and consumer (SW owned) index */
 	enetc_write_reg(rx_bdr->cons_idx, rx_bdr->next_cons_idx);
 	enetc_write_reg(rx_bdr->prod_idx, rx_bdr->next_prod_idx);
@@ -593,10 +599,148 @@ static int enetc_recv(struct udevice *dev, int flags, uchar **packetp)
 	return len;
 }
 
+/*
+ * HW was pointed at the aligned address below a caller's buffer, see
+ * enetc_free_batch(), so move the frame up into place and put back the bytes
+ * it landed on
+ */
+static void enetc_rx_direct_done(struct enetc_priv *priv, uchar *buf, int len)
+{
+	int off = priv->rx_direct_off;
+
+	priv->rx_direct_bd = -1;
+	if (!off)
+		return;
+	memmove(buf, buf - off, len);
+	memcpy(buf - off, priv->rx_direct_head, off);
+}
+
+/*
+ * Receive a burst of frames:
+ * - wait for the next BD to get ready bit set
+ * - take every consecutive ready BD after it, up to count
+ * - the BDs stay owned by SW until enetc_free_batch() gives them back, so HW
+ *   can't reuse a buffer while the stack is still processing it
+ */
+static int enetc_recv_batch(struct udevice *dev, int flags, uchar **packetp,
+			    int *lenp, int count)
+{
+	struct enetc_priv *priv = dev_get_priv(dev);
+	struct bd_ring *rxr = &priv->rx_bdr;
+	int tries = ENETC_POLL_TRIES;
+	int pi = rxr->next_prod_idx;
+	u32 status;
+	int n;
+
+	count = min(count, rxr->bd_count);
+	for (n = 0; n < count; n++) {
+		do {
+			dmb();
+			status = le32_to_cpu(priv->enetc_rxbd[pi].r.lstatus);
+			/* only wait for the first BD of the burst */
+		} while (!n && --tries >= 0 && !ENETC_RXBD_STATUS_R(status));
+
+		if (!ENETC_RXBD_STATUS_R(status))
+			break;
+
+		dmb();
+		lenp[n] = le16_to_cpu(priv->enetc_rxbd[pi].r.buf_len);
+		packetp[n] = priv->rx_buf[pi];
+		if (pi == priv->rx_direct_bd)
+			enetc_rx_direct_done(priv, packetp[n], lenp[n]);
+		enetc_dbg(dev, "RxBD[%d]: len=%d err=%d\n", pi, lenp[n],
+			  ENETC_RXBD_STATUS_ERRORS(status));
+		pi = (pi + 1) % rxr->bd_count;
+	}
+	rxr->next_prod_idx = pi;
+	priv->rx_hw -= n;
+
+	return n;
+}
+
+/*
+ * Free the frames of the last burst:
+ * - clean up the descriptors
+ * - indicate to HW which BDs are available for Rx with a single consumer
+ *   index update
+ *
+ * HW fills BDs in ring order, so a frame can only be received into a caller's
+ * buffer once HW has filled all the BDs it owned and the stack holds no frame.
+ * The next BD it fills is then the one at the producer index, so that BD is
+ * pointed at the caller's buffer and HW is given that BD alone. While a
+ * caller's buffer is waiting, the BDs of each burst are held back until this
+ * happens. The stack only asks for this while it expects a single frame at a
+ * time, so in lock-step every frame after the first few is received in place,
+ * and the whole ring is given back as soon as no buffer is waiting. HW needs
+ * the buffer to be aligned like our own, so it is given the aligned address
+ * below the caller's buffer and the bytes in between are saved until the
+ * frame has been moved up.
+ */
+static int enetc_free_batch(struct udevice *dev, uchar **packetp, int *lenp,
+			    int count)
+{
+	struct enetc_priv *priv = dev_get_priv(dev);
+	struct bd_ring *rxr = &priv->rx_bdr;
+	int ci = rxr->next_cons_idx;
+	int pi = rxr->next_prod_idx;
+	uchar *buf = priv->rx_direct;
+	int off;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		memset(&priv->enetc_rxbd[ci], 0, sizeof(union enetc_rx_bd));
+		priv->rx_buf[ci] = net_rx_packets[ci];
+		priv->enetc_rxbd[ci].w.addr = enetc_rxb_address(dev, ci);
+		ci = (ci + 1) % rxr->bd_count;
+	}
+	rxr->next_cons_idx = ci;
+
+	if (!buf) {
+		/* HW may fill all clean BDs but one, the one before ci */
+		priv->rx_hw = (ci - pi - 1 + rxr->bd_count) % rxr->bd_count;
+	} else if (!priv->rx_hw && ci == pi) {
+		off = (ulong)buf & (ARCH_DMA_MINALIGN - 1);
+		memcpy(priv->rx_direct_head, buf - off, off);
+		priv->rx_direct_off = off;
+		priv->rx_direct_bd = pi;
+		priv->rx_buf[pi] = buf;
+		priv->enetc_rxbd[pi].w.addr =
+			cpu_to_le64(dm_pci_virt_to_mem(dev, buf - off));
+		priv->rx_direct = NULL;
+		priv->rx_hw = 1;
+	}
+	dmb();
+	/* free up the slots in the ring for HW */
+	enetc_write_reg(rxr->cons_idx,
+			(pi + priv->rx_hw + 1) % rxr->bd_count);
+
+	return 0;
+}
+
+/*
+ * Receive a frame into a caller's buffer, which only needs to be 2-byte
+ * aligned. The BD is set up by enetc_free_batch() once HW has no other BD to
+ * fill first; once HW owns it the request can't be cancelled. Until then,
+ * cancelling it has the held back BDs given to HW with the next burst.
+ */
+static int enetc_recv_into(struct udevice *dev, uchar *buf)
+{
+	struct enetc_priv *priv = dev_get_priv(dev);
+
+	if ((ulong)buf & 1)
+		return -EINVAL;
+	priv->rx_direct = buf;
+
+	return 0;
+}
+
 static const struct eth_ops enetc_ops = {
 	.start	= enetc_start,
 	.send	= enetc_send,
 	.recv	= enetc_recv,
+	.recv_batch = enetc_recv_batch,
+	.free_batch = enetc_free_batch,
+	.recv_into = enetc_recv_into,
 	.stop	= enetc_stop,
 	.write_hwaddr = enetc_write_hwaddr,
 };
@@ -152,6 +152,17 @@ struct enetc_priv {
 	struct bd_ring tx_bdr;
 	struct bd_ring rx_bdr;
 
+	/* buffer each Rx BD points to */
+	uchar *rx_buf[ENETC_BD_CNT];
+	/* buffer to receive the next frame into, see enetc_recv_into() */
+	uchar *rx_direct;
+	/* BD pointed at that buffer, or -1, and the bytes in front of it */
+	int rx_direct_bd;
+	int rx_direct_off;
+	uchar rx_direct_head[ARCH_DMA_MINALIGN];
+	/* Rx BDs owned by HW */
+	int rx_hw;
+
 	int if_type;
 	struct mii_dev imdio;
 	struct phy_device *phy;
@@ -325,6 +325,8 @@ static int sb_eth_start(struct udevice *dev)
 	debug("eth_sandbox: Start\n");
 
 	priv->recv_packets = 0;
+	priv->recv_batch = 0;
+	priv->recv_direct = NULL;
 	for (int i = 0; i < PKTBUFSRX; i++) {
 		priv->recv_packet_buffer[i] = net_rx_packets[i];
 		priv->recv_packet_length[i] = 0;
@@ -365,22 +367,83 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 	return 0;
 }
 
+/* Drop the first @count received packets and move the rest up the queue */
+static void sb_eth_drop_packets(struct eth_sandbox_priv *priv, int count)
+{
+	int i;
+
+	count = min(count, priv->recv_packets);
+	priv->recv_packets -= count;
+	for (i = 0; i < priv->recv_packets; i++) {
+		priv->recv_packet_length[i] =
+			priv->recv_packet_length[i + count];
+		memcpy(priv->recv_packet_buffer[i],
+		       priv->recv_packet_buffer[i + count],
+		       priv->recv_packet_length[i + count]);
+	}
+	for (i = priv->recv_packets; i < priv->recv_packets + count; i++)
+		priv->recv_packet_length[i] = 0;
+}
+
 static int sb_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	sb_eth_drop_packets(priv, 1);
+
+	return 0;
+}
+
+/*
+ * Hand out every packet waiting in the queue at once. The buffers stay in use
+ * until sb_eth_free_batch() is called, like a real receive ring would.
+ */
+static int sb_eth_recv_batch(struct udevice *dev, int flags, uchar **packetp,
+			     int *lenp, int count)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
 	int i;
 
-	if (!priv->recv_packets)
-		return 0;
+	if (skip_timeout) {
+		timer_test_add_offset(11000UL);
+		skip_timeout = false;
+	}
 
-	--priv->recv_packets;
-	for (i = 0; i < priv->recv_packets; i++) {
-		priv->recv_packet_length[i] = priv->recv_packet_length[i + 1];
-		memcpy(priv->recv_packet_buffer[i],
-		       priv->recv_packet_buffer[i + 1],
-		       priv->recv_packet_length[i + 1]);
+	count = min(count, priv->recv_packets);
+	for (i = 0; i < count; i++) {
+		packetp[i] = priv->recv_packet_buffer[i];
+		lenp[i] = priv->recv_packet_length[i];
 	}
-	priv->recv_packet_length[priv->recv_packets] = 0;
+	/* Pretend the first packet was DMAed to where we were asked to */
+	if (count && priv->recv_direct) {
+		memcpy(priv->recv_direct, packetp[0], lenp[0]);
+		packetp[0] = priv->recv_direct;
+		priv->recv_direct = NULL;
+		priv->recv_direct_packets++;
+	}
+	priv->recv_batch = count;
+	debug("eth_sandbox: received %d packets, %d waiting\n", count,
+	      priv->recv_packets - count);
+
+	return count;
+}
+
+static int sb_eth_free_batch(struct udevice *dev, uchar **packetp, int *lenp,
+			     int count)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	sb_eth_drop_packets(priv, priv->recv_batch);
+	priv->recv_batch = 0;
+
+	return 0;
+}
+
+static int sb_eth_recv_into(struct udevice *dev, uchar *buf)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	priv->recv_direct = buf;
 
 	return 0;
 }
@@ -404,6 +467,9 @@ static const struct eth_ops sb_eth_ops = {
 	.send			= sb_eth_send,
 	.recv			= sb_eth_recv,
 	.free_pkt		= sb_eth_free_pkt,
+	.recv_batch		= sb_eth_recv_batch,
+	.free_batch		= sb_eth_free_batch,
+	.recv_into		= sb_eth_recv_into,
 	.stop			= sb_eth_stop,
 	.write_hwaddr		= sb_eth_write_hwaddr,
 };
@@ -307,3 +307,129 @@ int env_attr_lookup(const char *attr_list, const char *name, char *attributes)
 	return -ENOENT;
 }
 #endif
+
+#ifndef USE_HOSTCC
+struct lookup_all_priv {
+	int count;
+	const char *const *names;
+	char **attributes;
+};
+
+/* Set the attributes found for a name, replacing any found earlier */
+static int set_attributes(char **attrp, const char *attributes)
+{
+	free(*attrp);
+	*attrp = NULL;
+#if defined(CONFIG_REGEX)
+	if (!attributes)
+		return 0;	/* env_attr_lookup() fails, so not found */
+#else
+	if (!attributes)
+		attributes = "";
+#endif
+	*attrp = strdup(attributes);
+
+	return *attrp ? 0 : -ENOMEM;
+}
+
+static int lookup_all_callback(const char *name, const char *attributes,
+			       void *priv)
+{
+	struct lookup_all_priv *lap = priv;
+	int i, ret;
+#if defined(CONFIG_REGEX)
+	struct slre slre;
+	char regex[strlen(name) + 3];
+
+	/* Compile each regex just once, for all the names */
+	sprintf(regex, "^%s$", name);
+	if (!slre_compile(&slre, regex)) {
+		printf("Error compiling regex: %s\n", slre.err_str);
+		return -EINVAL;
+	}
+#endif
+
+	for (i = 0; i < lap->count; i++) {
+#if defined(CONFIG_REGEX)
+		struct cap caps[slre.num_caps + 2];
+
+		if (!slre_match(&slre, lap->names[i], strlen(lap->names[i]),
+				caps))
+			continue;
+#else
+		if (strcmp(name, lap->names[i]))
+			continue;
+#endif
+		ret = set_attributes(&lap->attributes[i], attributes);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int lookup_all(const char *attr_list, int count,
+		      const char *const names[], char *attributes[])
+{
+	struct lookup_all_priv priv;
+	int i, ret;
+
+	priv.count = count;
+	priv.names = names;
+	priv.attributes = attributes;
+	ret = env_attr_walk(attr_list, lookup_all_callback, &priv);
+	if (ret) {
+		/* as for env_attr_lookup(), nothing is found */
+		for (i = 0; i < count; i++) {
+			free(attributes[i]);
+			attributes[i] = NULL;
+		}
+	}
+
+	return ret == -ENOMEM ? ret : 0;
+}
+
+/*
+ * Retrieve the attributes of many names, walking each list only once
+ */
+int env_attr_lookup_all(const char *attr_list, const char *static_list,
+			int count, const char *const names[],
+			char *attributes[])
+{
+	char **static_attrs;
+	int i, ret;
+
+	for (i = 0; i < count; i++)
+		attributes[i] = NULL;
+	if (attr_list) {
+		ret = lookup_all(attr_list, count, names, attributes);
+		if (ret)
+			return ret;
+	}
+
+	static_attrs = calloc(count, sizeof(*static_attrs));
+	if (!static_attrs) {
+		ret = -ENOMEM;
+		goto err;
+	}
+	ret = lookup_all(static_list, count, names, static_attrs);
+	for (i = 0; i < count; i++) {
+		if (attributes[i])
+			free(static_attrs[i]);
+		else
+			attributes[i] = static_attrs[i];
+	}
+	free(static_attrs);
+	if (!ret)
+		return 0;
+
+err:
+	/* Leave nothing for the caller to free */
+	for (i = 0; i < count; i++) {
+		free(attributes[i]);
+		attributes[i] = NULL;
+	}
+
+	return ret;
+}
+#endif
@@ -7,6 +7,7 @@
 #include <common.h>
 #include <env.h>
 #include <env_internal.h>
+#include <malloc.h>
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
 DECLARE_GLOBAL_DATA_PTR;
@@ -76,6 +77,54 @@ void env_callback_init(struct env_entry *var_entry)
 	}
 }
 
+/*
+ * Look for possible callbacks for many newly added variables, walking the
+ * lists once rather than once for each variable
+ */
+int env_callback_init_all(struct env_entry *entries[], int count)
+{
+	struct env_clbk_tbl *clbkp;
+	const char **names;
+	char **callback_names;
+	int i, ret = -ENOMEM;
+
+	if (first_call) {
+		callback_list = env_get(ENV_CALLBACK_VAR);
+		first_call = 0;
+	}
+
+	names = calloc(count, sizeof(*names));
+	callback_names = calloc(count, sizeof(*callback_names));
+	if (!names || !callback_names)
+		goto err;
+	for (i = 0; i < count; i++)
+		names[i] = entries[i]->key;
+	ret = env_attr_lookup_all(callback_list, ENV_CALLBACK_LIST_STATIC,
+				  count, names, callback_names);
+	if (ret)
+		goto err;
+
+	for (i = 0; i < count; i++) {
+		if (!callback_names[i])
+			continue;
+		clbkp = NULL;
+		if (strlen(callback_names[i]))
+			clbkp = find_env_callback(callback_names[i]);
+		if (clbkp != NULL)
+#if defined(CONFIG_NEEDS_MANUAL_RELOC)
+			entries[i]->callback = clbkp->callback + gd->reloc_off;
+#else
+			entries[i]->callback = clbkp->callback;
+#endif
+		free(callback_names[i]);
+	}
+err:
+	free(callback_names);
+	free(names);
+
+	return ret;
+}
+
 /*
  * Called on each existing env var prior to the blanket update since removing
  * a callback association should remove its callback.
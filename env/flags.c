@@ -20,6 +20,7 @@
 #else
 #include <common.h>
 #include <env_internal.h>
+#include <malloc.h>
 #endif
 
 #ifdef CONFIG_CMD_NET
@@ -437,6 +438,44 @@ void env_flags_init(struct env_entry *var_entry)
 		var_entry->flags = env_parse_flags_to_bin(flags);
 }
 
+/*
+ * Look for possible flags for many newly added variables, walking the lists
+ * once rather than once for each variable
+ */
+int env_flags_init_all(struct env_entry *entries[], int count)
+{
+	const char **names;
+	char **flags;
+	int i, ret = -ENOMEM;
+
+	if (first_call) {
+		flags_list = env_get(ENV_FLAGS_VAR);
+		first_call = 0;
+	}
+
+	names = calloc(count, sizeof(*names));
+	flags = calloc(count, sizeof(*flags));
+	if (!names || !flags)
+		goto err;
+	for (i = 0; i < count; i++)
+		names[i] = entries[i]->key;
+	ret = env_attr_lookup_all(flags_list, ENV_FLAGS_LIST_STATIC, count,
+				  names, flags);
+	if (ret)
+		goto err;
+
+	for (i = 0; i < count; i++) {
+		if (flags[i] && strlen(flags[i]))
+			entries[i]->flags = env_parse_flags_to_bin(flags[i]);
+		free(flags[i]);
+	}
+err:
+	free(flags);
+	free(names);
+
+	return ret;
+}
+
 /*
  * Called on each existing env var prior to the blanket update since removing
  * a flag in the flag list should remove its flags.
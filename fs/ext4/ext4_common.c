@@ -1639,6 +1639,76 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
+/*
+ * Look up @fileblock in the extent tree of @inode and return the number of
+ * blocks, up to @count, which follow it contiguously on disk. The first disk
+ * block is returned in @blknrp, or 0 if @fileblock is in a hole, in which case
+ * the count is the size of the hole. The extent leaf is kept in @cache so that
+ * the next lookup in the same leaf does not need to read it again.
+ */
+static long int ext4fs_extent_run(struct ext2_inode *inode, int fileblock,
+				  int count, struct ext_block_cache *cache,
+				  long int *blknrp)
+{
+	long int startblock, endblock;
+	struct ext_block_cache *c, cd;
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	unsigned long long start;
+	long int run;
+	int log2_blksz;
+	int i;
+
+	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
+		- get_fs()->dev_desc->log2blksz;
+
+	if (cache) {
+		c = cache;
+	} else {
+		c = &cd;
+		ext_cache_init(c);
+	}
+	ext_block =
+		ext4fs_get_extent_block(ext4fs_root, c,
+					(struct ext4_extent_header *)
+					inode->b.blocks.dir_blocks,
+					fileblock, log2_blksz);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		if (!cache)
+			ext_cache_fini(c);
+		return -EINVAL;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+
+	/* Past the end of this leaf, only the next block is known */
+	*blknrp = 0;
+	run = 1;
+	for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
+		startblock = le32_to_cpu(extent[i].ee_block);
+		endblock = startblock + le16_to_cpu(extent[i].ee_len);
+
+		if (startblock > fileblock) {
+			/* Sparse file */
+			run = startblock - fileblock;
+			break;
+
+		} else if (fileblock < endblock) {
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			*blknrp = (fileblock - startblock) + start;
+			run = endblock - fileblock;
+			break;
+		}
+	}
+
+	if (!cache)
+		ext_cache_fini(c);
+	return min(run, (long int)count);
+}
+
 long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			      struct ext_block_cache *cache)
 {
@@ -1649,62 +1719,19 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 	long int rblock;
 	long int perblock_parent;
 	long int perblock_child;
-	unsigned long long start;
 	/* get the blocksize of the filesystem */
 	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
 	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
 		- get_fs()->dev_desc->log2blksz;
 
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		long int startblock, endblock;
-		struct ext_block_cache *c, cd;
-		struct ext4_extent_header *ext_block;
-		struct ext4_extent *extent;
-		int i;
-
-		if (cache) {
-			c = cache;
-		} else {
-			c = &cd;
-			ext_cache_init(c);
-		}
-		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, c,
-						(struct ext4_extent_header *)
-						inode->b.blocks.dir_blocks,
-						fileblock, log2_blksz);
-		if (!ext_block) {
-			printf("invalid extent block\n");
-			if (!cache)
-				ext_cache_fini(c);
-			return -EINVAL;
-		}
-
-		extent = (struct ext4_extent *)(ext_block + 1);
-
-		for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
-			startblock = le32_to_cpu(extent[i].ee_block);
-			endblock = startblock + le16_to_cpu(extent[i].ee_len);
-
-			if (startblock > fileblock) {
-				/* Sparse file */
-				if (!cache)
-					ext_cache_fini(c);
-				return 0;
+		long int ret;
 
-			} else if (fileblock < endblock) {
-				start = le16_to_cpu(extent[i].ee_start_hi);
-				start = (start << 32) +
-					le32_to_cpu(extent[i].ee_start_lo);
-				if (!cache)
-					ext_cache_fini(c);
-				return (fileblock - startblock) + start;
-			}
-		}
+		ret = ext4fs_extent_run(inode, fileblock, 1, cache, &blknr);
+		if (ret < 0)
+			return ret;
 
-		if (!cache)
-			ext_cache_fini(c);
-		return 0;
+		return blknr;
 	}
 
 	/* Direct blocks. */
@@ -1992,6 +2019,22 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 	return blknr;
 }
 
+long int read_allocated_run(struct ext2_inode *inode, int fileblock,
+			    int count, struct ext_block_cache *cache,
+			    long int *blknrp)
+{
+	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL)
+		return ext4fs_extent_run(inode, fileblock, count, cache,
+					 blknrp);
+
+	/* Block maps are resolved one block at a time */
+	*blknrp = read_allocated_block(inode, fileblock, cache);
+	if (*blknrp < 0)
+		return *blknrp;
+
+	return 1;
+}
+
 /**
  * ext4fs_reinit_global() - Reinitialize values of ext4 write implementation's
  *			    global pointers
@@ -25,6 +25,11 @@
 #include <ext4fs.h>
 #include "ext4_common.h"
 #include <div64.h>
+#include <image.h>
+#include <linux/sizes.h>
+
+/* Largest single device read issued by ext4fs_read_file() */
+#define EXT4_MAX_READ_SIZE	SZ_1G
 
 int ext4fs_symlinknest;
 struct ext_filesystem ext_fs;
@@ -44,6 +49,13 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
  * reads into one potentially more efficient larger sequential read action
+ *
+ * Blocks are mapped a run at a time with read_allocated_run(), so an extent
+ * is looked up once rather than once per block. Physically contiguous runs
+ * are merged into one device read of up to EXT4_MAX_READ_SIZE bytes; block
+ * drivers split that further if their controller needs it. While a FIT is
+ * being loaded, reads are kept to CONFIG_FIT_STREAM_CHUNK_SIZE and each is
+ * reported with fit_stream_written().
  */
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		loff_t len, char *buf, loff_t *actread)
@@ -55,13 +67,13 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
 	int blocksize = (1 << (log2_fs_blocksize + log2blksz));
 	unsigned int filesize = le32_to_cpu(node->inode.size);
-	lbaint_t previous_block_number = -1;
+	int firstblock;
+	long int run, maxrun, maxread;
 	lbaint_t delayed_start = 0;
 	lbaint_t delayed_extent = 0;
 	lbaint_t delayed_skipfirst = 0;
 	lbaint_t delayed_next = 0;
 	char *delayed_buf = NULL;
-	char *start_buf = buf;
 	short status;
 	struct ext_block_cache cache;
 
@@ -77,92 +89,68 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	}
 
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
+	firstblock = lldiv(pos, blocksize);
+	maxread = fit_stream_chunk_size() ?: EXT4_MAX_READ_SIZE;
+	maxrun = max(maxread / blocksize, 1L);
 
-	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
+	for (i = firstblock; i < blockcnt; i += run) {
 		long int blknr;
-		int blockoff = pos - (blocksize * i);
-		int blockend = blocksize;
+		lbaint_t blockend;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&node->inode, i, &cache);
-		if (blknr < 0) {
+
+		run = read_allocated_run(&node->inode, i,
+					 min((long int)(blockcnt - i), maxrun),
+					 &cache, &blknr);
+		if (run <= 0) {
 			ext_cache_fini(&cache);
 			return -1;
 		}
 
 		blknr = blknr << log2_fs_blocksize;
+		blockend = (lbaint_t)blocksize * run;
 
 		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) - (blocksize * i);
-
-			/* The last portion is exactly blocksize. */
-			if (!blockend)
-				blockend = blocksize;
-		}
+		if (i + run == blockcnt)
+			blockend = (len + pos) - ((loff_t)blocksize * i);
 
 		/* First block. */
-		if (i == lldiv(pos, blocksize)) {
-			skipfirst = blockoff;
+		if (i == firstblock) {
+			skipfirst = pos - ((loff_t)blocksize * i);
 			blockend -= skipfirst;
 		}
-		if (blknr) {
-			int status;
-
-			if (previous_block_number != -1) {
-				if (delayed_next == blknr) {
-					delayed_extent += blockend;
-					delayed_next += blockend >> log2blksz;
-				} else {	/* spill */
-					status = ext4fs_devread(delayed_start,
-							delayed_skipfirst,
-							delayed_extent,
-							delayed_buf);
-					if (status == 0) {
-						ext_cache_fini(&cache);
-						return -1;
-					}
-					previous_block_number = blknr;
-					delayed_start = blknr;
-					delayed_extent = blockend;
-					delayed_skipfirst = skipfirst;
-					delayed_buf = buf;
-					delayed_next = blknr +
-						(blockend >> log2blksz);
-				}
-			} else {
-				previous_block_number = blknr;
-				delayed_start = blknr;
-				delayed_extent = blockend;
-				delayed_skipfirst = skipfirst;
-				delayed_buf = buf;
-				delayed_next = blknr +
-					(blockend >> log2blksz);
-			}
-		} else {
-			int n;
-			int n_left;
-			if (previous_block_number != -1) {
-				/* spill */
-				status = ext4fs_devread(delayed_start,
-							delayed_skipfirst,
-							delayed_extent,
-							delayed_buf);
-				if (status == 0) {
-					ext_cache_fini(&cache);
-					return -1;
-				}
-				previous_block_number = -1;
+
+		if (delayed_extent &&
+		    (!blknr || delayed_next != blknr ||
+		     delayed_extent + blockend > maxread)) {
+			/* spill */
+			status = ext4fs_devread(delayed_start,
+						delayed_skipfirst,
+						delayed_extent, delayed_buf);
+			if (status == 0) {
+				ext_cache_fini(&cache);
+				return -1;
 			}
+			fit_stream_written(delayed_buf, delayed_extent);
+			delayed_extent = 0;
+		}
+
+		if (!blknr) {
 			/* Zero no more than `len' bytes. */
-			n = blocksize - skipfirst;
-			n_left = len - ( buf - start_buf );
-			if (n > n_left)
-				n = n_left;
-			memset(buf, 0, n);
+			memset(buf, 0, blockend);
+			fit_stream_written(buf, blockend);
+		} else if (delayed_extent) {
+			delayed_extent += blockend;
+			delayed_next = blknr + (run << log2_fs_blocksize);
+		} else {
+			delayed_start = blknr;
+			delayed_extent = blockend;
+			delayed_skipfirst = skipfirst;
+			delayed_buf = buf;
+			delayed_next = blknr + (run << log2_fs_blocksize);
 		}
-		buf += blocksize - skipfirst;
+		buf += blockend;
 	}
-	if (previous_block_number != -1) {
+	if (delayed_extent) {
 		/* spill */
 		status = ext4fs_devread(delayed_start,
 					delayed_skipfirst, delayed_extent,
@@ -171,7 +159,7 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 			ext_cache_fini(&cache);
 			return -1;
 		}
-		previous_block_number = -1;
+		fit_stream_written(delayed_buf, delayed_extent);
 	}
 
 	*actread  = len;
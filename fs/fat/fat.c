@@ -14,6 +14,7 @@
 #include <exports.h>
 #include <fat.h>
 #include <fs.h>
+#include <image.h>
 #include <asm/byteorder.h>
 #include <part.h>
 #include <malloc.h>
@@ -37,6 +38,13 @@ static void downcase(char *str, size_t len)
 static struct blk_desc *cur_dev;
 static disk_partition_t cur_part_info;
 
+/* Memory for caching FAT windows, see fat_cache_window() */
+#if defined(CONFIG_FS_FAT_CACHE_SIZE) && !defined(CONFIG_SPL_BUILD)
+#define FAT_CACHE_SIZE	(CONFIG_FS_FAT_CACHE_SIZE * 1024)
+#else
+#define FAT_CACHE_SIZE	0
+#endif
+
 #define DOS_BOOT_MAGIC_OFFSET	0x1fe
 #define DOS_FS_TYPE_OFFSET	0x36
 #define DOS_FS32_TYPE_OFFSET	0x52
@@ -155,6 +163,51 @@ int flush_dirty_fat_buffer(fsdata *mydata)
 }
 #endif
 
+/*
+ * Read window 'bufnum' of the FAT, FATBUFBLOCKS sectors long, into 'bufptr'.
+ * Return 0 on success, -1 otherwise.
+ */
+static int read_fat_window(fsdata *mydata, __u32 bufnum, __u8 *bufptr)
+{
+	__u32 getsize = FATBUFBLOCKS;
+	__u32 fatlength = mydata->fatlength;
+	__u32 startblock = bufnum * FATBUFBLOCKS;
+
+	/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
+	if (startblock + getsize > fatlength)
+		getsize = fatlength - startblock;
+
+	startblock += mydata->fat_sect;	/* Offset from start of disk */
+
+	mydata->fat_reads++;
+	if (disk_read(startblock, getsize, bufptr) < 0) {
+		debug("Error reading FAT blocks\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Return the cached copy of FAT window 'bufnum', reading it if needed.
+ * The cache is direct-mapped, so if it has a slot for every window the
+ * whole table ends up in memory. On failure NULL is returned.
+ */
+static __u8 *fat_cache_window(fsdata *mydata, __u32 bufnum)
+{
+	int slot = bufnum % mydata->fatcache_slots;
+	__u8 *bufptr = mydata->fatcache + slot * FATBUFSIZE;
+
+	if (mydata->fatcache_num[slot] != (int)bufnum) {
+		mydata->fatcache_num[slot] = -1;
+		if (read_fat_window(mydata, bufnum, bufptr) < 0)
+			return NULL;
+		mydata->fatcache_num[slot] = bufnum;
+	}
+
+	return bufptr;
+}
+
 /*
  * Get the entry at index 'entry' in a FAT (12/16/32) table.
  * On failure 0x00 is returned.
@@ -164,6 +217,7 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	__u32 bufnum;
 	__u32 offset, off8;
 	__u32 ret = 0x00;
+	__u8 *fatbuf;
 
 	if (CHECK_CLUST(entry, mydata->fatsize)) {
 		printf("Error: Invalid FAT entry: 0x%08x\n", entry);
@@ -192,42 +246,41 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	debug("FAT%d: entry: 0x%08x = %d, offset: 0x%04x = %d\n",
 	       mydata->fatsize, entry, entry, offset, offset);
 
-	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		__u32 getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
-		if (startblock + getsize > fatlength)
-			getsize = fatlength - startblock;
-
-		startblock += mydata->fat_sect;	/* Offset from start of disk */
+	/*
+	 * The window in fatbuf may have been modified by fat_write, so it
+	 * takes precedence over the cache.
+	 */
+	if (bufnum == mydata->fatbufnum) {
+		fatbuf = mydata->fatbuf;
+	} else if (mydata->fatcache_slots) {
+		fatbuf = fat_cache_window(mydata, bufnum);
+		if (!fatbuf)
+			return ret;
+	} else {
+		/* Read a new block of FAT entries into the cache. */
+		fatbuf = mydata->fatbuf;
 
 		/* Write back the fatbuf to the disk */
 		if (flush_dirty_fat_buffer(mydata) < 0)
 			return -1;
 
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
+		if (read_fat_window(mydata, bufnum, fatbuf) < 0)
 			return ret;
-		}
 		mydata->fatbufnum = bufnum;
 	}
 
 	/* Get the actual entry from the table */
 	switch (mydata->fatsize) {
 	case 32:
-		ret = FAT2CPU32(((__u32 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU32(((__u32 *)fatbuf)[offset]);
 		break;
 	case 16:
-		ret = FAT2CPU16(((__u16 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU16(((__u16 *)fatbuf)[offset]);
 		break;
 	case 12:
 		off8 = (offset * 3) / 2;
 		/* fatbut + off8 may be unaligned, read in byte granularity */
-		ret = mydata->fatbuf[off8] + (mydata->fatbuf[off8 + 1] << 8);
+		ret = fatbuf[off8] + (fatbuf[off8 + 1] << 8);
 
 		if (offset & 0x1)
 			ret >>= 4;
@@ -264,6 +317,7 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 		debug("FAT: Misaligned buffer address (%p)\n", buffer);
 
 		while (size >= mydata->sect_size) {
+			mydata->data_reads++;
 			ret = disk_read(startsect++, 1, tmpbuf);
 			if (ret != 1) {
 				debug("Error reading data (got %d)\n", ret);
@@ -276,6 +330,7 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 		}
 	} else {
 		idx = size / mydata->sect_size;
+		mydata->data_reads++;
 		ret = disk_read(startsect, idx, buffer);
 		if (ret != idx) {
 			debug("Error reading data (got %d)\n", ret);
@@ -289,6 +344,7 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	if (size) {
 		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
 
+		mydata->data_reads++;
 		ret = disk_read(startsect, 1, tmpbuf);
 		if (ret != 1) {
 			debug("Error reading data (got %d)\n", ret);
@@ -301,6 +357,29 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/*
+ * Follow the cluster chain from 'clust' for as long as it is contiguous on
+ * disk, up to 'maxclust' clusters. Return the number of clusters in the run
+ * and store the cluster which follows it in '*next'.
+ */
+static __u32 get_cluster_run(fsdata *mydata, __u32 clust, __u32 maxclust,
+			     __u32 *next)
+{
+	__u32 count = 1;
+	__u32 newclust;
+
+	while (1) {
+		newclust = get_fatent(mydata, clust);
+		if (count >= maxclust || newclust != clust + 1)
+			break;
+		clust = newclust;
+		count++;
+	}
+	*next = newclust;
+
+	return count;
+}
+
 /*
  * Read at most 'maxsize' bytes from 'pos' in the file associated with 'dentptr'
  * into 'buffer'.
@@ -312,7 +391,8 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
+	__u32 nclust, newclust, maxclust;
+	ulong chunk;
 	loff_t actsize;
 
 	*gotsize = 0;
@@ -379,50 +459,36 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 		}
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return 0;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
-		}
-
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+	/*
+	 * read one contiguous run of clusters at a time, or less if a FIT
+	 * is being loaded and hashed as it arrives
+	 */
+	while (1) {
+		maxclust = ((__u32)filesize - 1) / bytesperclust + 1;
+		chunk = fit_stream_chunk_size();
+		if (chunk)
+			maxclust = min(maxclust,
+				       max_t(__u32, chunk / bytesperclust, 1));
+		nclust = get_cluster_run(mydata, curclust, maxclust, &newclust);
+		actsize = min(filesize, (loff_t)nclust * bytesperclust);
+		if (get_cluster(mydata, curclust, buffer, actsize) != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
+		fit_stream_written(buffer, actsize);
 		*gotsize += actsize;
-		return 0;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += (int)actsize;
 		filesize -= actsize;
+		if (!filesize)
+			return 0;
 		buffer += actsize;
 
-		curclust = get_fatent(mydata, endclust);
+		curclust = newclust;
 		if (CHECK_CLUST(curclust, mydata->fatsize)) {
 			debug("curclust: 0x%x\n", curclust);
 			printf("Invalid FAT entry\n");
 			return 0;
 		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	}
 }
 
 /*
@@ -546,6 +612,7 @@ static int get_fs_info(fsdata *mydata)
 {
 	boot_sector bs;
 	volume_info volinfo;
+	int slots, i;
 	int ret;
 
 	ret = read_bootsectandvi(&bs, &volinfo, &mydata->fatsize);
@@ -613,11 +680,28 @@ static int get_fs_info(fsdata *mydata)
 
 	mydata->fatbufnum = -1;
 	mydata->fat_dirty = 0;
-	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
+	mydata->fat_reads = 0;
+	mydata->data_reads = 0;
+
+	/* The FAT cache slots and their tags follow fatbuf */
+	slots = min((__u32)(FAT_CACHE_SIZE / FATBUFSIZE),
+		    DIV_ROUND_UP(mydata->fatlength, FATBUFBLOCKS));
+	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE * (1 + slots) +
+					      slots * sizeof(int));
+	if (mydata->fatbuf == NULL && slots) {
+		debug("FAT: no memory for %d cache slots\n", slots);
+		slots = 0;
+		mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
+	}
 	if (mydata->fatbuf == NULL) {
 		debug("Error: allocating memory\n");
 		return -1;
 	}
+	mydata->fatcache_slots = slots;
+	mydata->fatcache = mydata->fatbuf + FATBUFSIZE;
+	mydata->fatcache_num = (int *)(mydata->fatcache + slots * FATBUFSIZE);
+	for (i = 0; i < slots; i++)
+		mydata->fatcache_num[i] = -1;
 
 	debug("FAT%d, fat_sect: %d, fatlength: %d\n",
 	       mydata->fatsize, mydata->fat_sect, mydata->fatlength);
@@ -1175,6 +1259,9 @@ int file_fat_read_at(const char *filename, loff_t pos, void *buffer,
 	dir_entry *dentptr = itr->dent;
 
 	ret = get_contents(&fsdata, dentptr, pos, buffer, maxsize, actread);
+	debug("read %llu bytes: %u data reads, %u FAT reads (%d cache slots)\n",
+	      *actread, fsdata.data_reads, fsdata.fat_reads,
+	      fsdata.fatcache_slots);
 
 out_free_both:
 	free(fsdata.fatbuf);
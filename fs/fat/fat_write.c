@@ -137,6 +137,15 @@ static int flush_dirty_fat_buffer(fsdata *mydata)
 	}
 	mydata->fat_dirty = 0;
 
+	/* Keep any cached copy of this window in step */
+	if (mydata->fatcache_slots) {
+		int slot = mydata->fatbufnum % mydata->fatcache_slots;
+
+		if (mydata->fatcache_num[slot] == mydata->fatbufnum)
+			memcpy(mydata->fatcache + slot * FATBUFSIZE, bufptr,
+			       FATBUFSIZE);
+	}
+
 	return 0;
 }
 
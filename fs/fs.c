@@ -12,6 +12,7 @@
 #include <ext4fs.h>
 #include <fat.h>
 #include <fs.h>
+#include <image.h>
 #include <sandboxfs.h>
 #include <ubifs_uboot.h>
 #include <btrfs.h>
@@ -707,7 +708,18 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 			(argc > 4) ? argv[4] : "");
 #endif
 	time = get_timer(0);
+	/*
+	 * FAT and ext4 report each piece of a FIT as it is read, so that its
+	 * hashes can be checked along the way. Anything else is hashed here.
+	 */
+	if (!pos)
+		fit_stream_start(addr);
 	ret = _fs_read(filename, addr, pos, bytes, 1, &len_read);
+	if (!pos) {
+		if (ret >= 0)
+			fit_stream_data(len_read);
+		fit_stream_end();
+	}
 	time = get_timer(time);
 	if (ret < 0)
 		return 1;
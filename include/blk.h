@@ -154,13 +154,27 @@ void blkcache_fill(int iftype, int dev,
  */
 void blkcache_invalidate(int iftype, int dev);
 
+/**
+ * blkcache_invalidate_range() - discard any cached copy of a range of
+ * blocks because it is being written or erased.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number
+ * @param blkcnt - number of blocks
+ */
+void blkcache_invalidate_range(int iftype, int dev,
+			       lbaint_t start, lbaint_t blkcnt);
+
 /**
  * blkcache_configure() - configure block cache
  *
  * @param blocks - maximum blocks per entry
  * @param entries - maximum entries in cache
+ * @param dev_entries - maximum entries for any one device (0 for no limit)
  */
-void blkcache_configure(unsigned blocks, unsigned entries);
+void blkcache_configure(unsigned blocks, unsigned entries,
+			unsigned dev_entries);
 
 /*
  * statistics of the block cache
@@ -171,15 +185,42 @@ struct block_cache_stats {
 	unsigned entries; /* current entry count */
 	unsigned max_blocks_per_entry;
 	unsigned max_entries;
+	unsigned max_dev_entries; /* per-device limit, 0 if none */
+	unsigned sets; /* number of sets, 0 until the first fill */
+	unsigned ways; /* entries per set */
+	u64 bytes_saved; /* bytes returned from cache */
+};
+
+/*
+ * statistics of the block cache for one device
+ */
+struct block_cache_dev_stats {
+	int iftype;
+	int devnum;
+	unsigned hits;
+	unsigned misses;
+	unsigned entries; /* current entry count */
+	u64 bytes_saved; /* bytes returned from cache */
 };
 
 /**
  * get_blkcache_stats() - return statistics and reset
  *
+ * This resets the per-device hit/miss counters too.
+ *
  * @param stats - statistics are copied here
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/**
+ * blkcache_dev_stats() - return statistics for a device
+ *
+ * @param index - index of the device, in the order first seen by the cache
+ * @param stats - statistics are copied here
+ * @return 0 if OK, -ENOENT if there is no device with that index
+ */
+int blkcache_dev_stats(int index, struct block_cache_dev_stats *stats);
+
 #else
 
 static inline int blkcache_read(int iftype, int dev,
@@ -195,6 +236,10 @@ static inline void blkcache_fill(int iftype, int dev,
 
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
+static inline void blkcache_invalidate_range(int iftype, int dev,
+					     lbaint_t start,
+					     lbaint_t blkcnt) {}
+
 #endif
 
 #if CONFIG_IS_ENABLED(BLK)
@@ -449,14 +494,16 @@ static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 static inline ulong blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt, const void *buffer)
 {
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	blkcache_invalidate_range(block_dev->if_type, block_dev->devnum,
+				  start, blkcnt);
 	return block_dev->block_write(block_dev, start, blkcnt, buffer);
 }
 
 static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt)
 {
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	blkcache_invalidate_range(block_dev->if_type, block_dev->devnum,
+				  start, blkcnt);
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
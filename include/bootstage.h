@@ -338,6 +338,26 @@ int bootstage_stash(void *base, int size);
  */
 int bootstage_unstash(const void *base, int size);
 
+/**
+ * bootstage_check() - Check boot time against budgets and a baseline
+ *
+ * This prints the time taken by each boot stage: the time since the previous
+ * mark for a mark, or the total time for an accumulated record. Budgets for
+ * stages come from the 'bootstage_budget' environment variable or else the
+ * 'u-boot,bootstage-budget' property of /config in the device tree, as a
+ * list of <stage>:<us> where <stage> is a bootstage ID or record name.
+ *
+ * If @baseline is given, each stage is compared with the same stage of an
+ * earlier boot, as written by bootstage_stash().
+ *
+ * @baseline:	Stash from an earlier boot, or NULL for none
+ * @size:	Size of @baseline buffer (-1 if unknown)
+ * @json:	true to print JSON for use by tools, false to print a table
+ * @return number of stages over budget, or -ve error reading @baseline
+ *	(see bootstage_unstash())
+ */
+int bootstage_check(const void *baseline, int size, bool json);
+
 /**
  * bootstage_get_size() - Get the size of the bootstage data
  *
@@ -414,6 +434,11 @@ static inline int bootstage_unstash(const void *base, int size)
 	return 0;	/* Pretend to succeed */
 }
 
+static inline int bootstage_check(const void *baseline, int size, bool json)
+{
+	return 0;
+}
+
 static inline int bootstage_get_size(void)
 {
 	return 0;
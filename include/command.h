@@ -182,6 +182,16 @@ int cmd_process(int flag, int argc, char * const argv[],
 
 void fixup_cmdtable(cmd_tbl_t *cmdtp, int size);
 
+/**
+ * cmd_get_count() - Get the number of commands which have been started
+ *
+ * This lets something set up by one command be trusted only by the command
+ * which runs straight after it.
+ *
+ * @return number of commands started so far, including the current one
+ */
+ulong cmd_get_count(void);
+
 /**
  * board_run_command() - Fallback function to execute a command
  *
@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Decompressing data as it arrives
+ */
+
+#ifndef __DECOMP_STREAM_H
+#define __DECOMP_STREAM_H
+
+#include <linux/types.h>
+
+/**
+ * struct decomp_stream - State of a streaming decompression
+ *
+ * The compressed data is passed in as it arrives, in pieces which follow on
+ * from each other in memory, as when a file is loaded front to back. A
+ * decompressor which needs more data than it has been given to make progress
+ * simply leaves the rest in place until the next piece arrives, so nothing is
+ * copied. The output goes straight to a single buffer, which also serves as
+ * the history window.
+ *
+ * @comp:	Compression type (IH_COMP_...)
+ * @dst:	Output buffer
+ * @dst_len:	Size of output buffer
+ * @out:	Number of bytes written to @dst so far
+ * @src:	Start of the compressed data, NULL until the first piece
+ * @src_len:	Number of bytes of compressed data passed in so far
+ * @used:	Number of bytes of compressed data consumed so far
+ * @done:	true once the end of the compressed data has been seen
+ * @err:	First error returned by decomp_stream_feed(), 0 if none
+ * @state:	Algorithm-specific progress, 0 at the start
+ * @priv:	Algorithm-specific context, if any
+ */
+struct decomp_stream {
+	int comp;
+	void *dst;
+	size_t dst_len;
+	size_t out;
+	const void *src;
+	size_t src_len;
+	size_t used;
+	bool done;
+	int err;
+	int state;
+	void *priv;
+};
+
+/**
+ * decomp_stream_supported() - Check if a compression type can be streamed
+ *
+ * @comp:	Compression type (IH_COMP_...)
+ * @return true if decomp_stream_init() accepts @comp
+ */
+bool decomp_stream_supported(int comp);
+
+/**
+ * decomp_stream_init() - Start decompressing a stream
+ *
+ * Whatever the outcome of later calls, decomp_stream_finish() must be called
+ * to free the stream once this has succeeded.
+ *
+ * @ds:		Stream to set up
+ * @comp:	Compression type (IH_COMP_...)
+ * @dst:	Output buffer
+ * @dst_len:	Size of output buffer
+ * @return 0 if OK, -ENOSYS if @comp cannot be streamed, -ENOMEM if out of
+ *	memory
+ */
+int decomp_stream_init(struct decomp_stream *ds, int comp, void *dst,
+		       size_t dst_len);
+
+/**
+ * decomp_stream_feed() - Decompress the next piece of compressed data
+ *
+ * Data after the end of the compressed stream is ignored.
+ *
+ * @ds:		Stream to feed
+ * @src:	Compressed data, which must directly follow the data passed in
+ *		the previous call
+ * @len:	Number of bytes at @src
+ * @return 0 if OK, -EINVAL if @src does not follow on, -ENOBUFS if the output
+ *	buffer is full, other -ve value on a decompression error. Once an
+ *	error is returned, the stream stays in error.
+ */
+int decomp_stream_feed(struct decomp_stream *ds, const void *src, size_t len);
+
+/**
+ * decomp_stream_finish() - Finish decompressing a stream and free it
+ *
+ * @ds:		Stream to finish
+ * @out_lenp:	Returns the number of bytes decompressed
+ * @return 0 if OK, -EINVAL if the compressed data ended early, other -ve
+ *	value if a previous decomp_stream_feed() failed
+ */
+int decomp_stream_finish(struct decomp_stream *ds, size_t *out_lenp);
+
+/**
+ * decomp_stream_buf() - Decompress a buffer in one go
+ *
+ * @comp:	Compression type (IH_COMP_...)
+ * @dst:	Output buffer
+ * @dst_lenp:	On entry, size of output buffer. On exit, number of bytes
+ *		decompressed
+ * @src:	Compressed data
+ * @src_len:	Number of bytes at @src
+ * @return 0 if OK, -ve on error
+ */
+int decomp_stream_buf(int comp, void *dst, size_t *dst_lenp, const void *src,
+		      size_t src_len);
+
+/*
+ * Each algorithm's part of the stream. @ds->src, @ds->src_len and @ds->comp
+ * are set up by the caller. feed() consumes as much of the data between
+ * @ds->used and @ds->src_len as it can, and finish() frees anything that
+ * init() allocated, whether or not the stream completed.
+ */
+int gunzip_stream_init(struct decomp_stream *ds);
+int gunzip_stream_feed(struct decomp_stream *ds);
+void gunzip_stream_finish(struct decomp_stream *ds);
+
+int lz4_stream_init(struct decomp_stream *ds);
+int lz4_stream_feed(struct decomp_stream *ds);
+void lz4_stream_finish(struct decomp_stream *ds);
+
+int lzma_stream_init(struct decomp_stream *ds);
+int lzma_stream_feed(struct decomp_stream *ds);
+void lzma_stream_finish(struct decomp_stream *ds);
+
+#endif /* __DECOMP_STREAM_H */
@@ -35,4 +35,18 @@ int env_attr_walk(const char *attr_list,
  */
 int env_attr_lookup(const char *attr_list, const char *name, char *attributes);
 
+/*
+ * env_attr_lookup_all does the same as env_attr_lookup for each of the
+ * "count" strings in "names", but walks each list only once. The
+ * attributes of a name are looked up in "attr_list" (which may be NULL),
+ * or if not found there, in "static_list". For each name, "attributes" is
+ * set to an allocated copy of its attributes, or NULL if it is not found.
+ * The caller must free these.
+ * Returns 0 on success, -ENOMEM if out of memory, in which case every
+ * element of "attributes" is NULL.
+ */
+int env_attr_lookup_all(const char *attr_list, const char *static_list,
+			int count, const char *const names[],
+			char *attributes[]);
+
 #endif /* __ENV_ATTR_H__ */
@@ -74,4 +74,11 @@
 
 void env_callback_init(struct env_entry *var_entry);
 
+/*
+ * Look for possible callbacks for many newly added variables at once, as
+ * env_callback_init() does for one. Returns 0 on success, -ENOMEM if out of
+ * memory (in which case nothing is set).
+ */
+int env_callback_init_all(struct env_entry *entries[], int count);
+
 #endif /* __ENV_CALLBACK_H__ */
@@ -155,6 +155,13 @@ int env_flags_validate_env_set_params(char *name, char *const val[], int count);
  */
 void env_flags_init(struct env_entry *var_entry);
 
+/*
+ * Look for possible flags for many newly added variables at once, as
+ * env_flags_init() does for one. Returns 0 on success, -ENOMEM if out of
+ * memory (in which case nothing is set).
+ */
+int env_flags_init_all(struct env_entry *entries[], int count);
+
 /*
  * Validate the newval for to conform with the requirements defined by its flags
  */
@@ -175,6 +175,11 @@ typedef struct {
 	__u32	root_cluster;	/* First cluster of root dir for FAT32 */
 	u32	total_sect;	/* Number of sectors */
 	int	fats;		/* Number of FATs */
+	__u8	*fatcache;	/* Cached FAT windows, allocated with fatbuf */
+	int	*fatcache_num;	/* Window held by each cache slot, or -1 */
+	int	fatcache_slots;	/* Number of cache slots, 0 if disabled */
+	unsigned int fat_reads;	 /* FAT windows read from disk */
+	unsigned int data_reads; /* Data reads issued by get_cluster() */
 } fsdata;
 
 static inline u32 clust_to_sect(fsdata *fsdata, u32 clust)
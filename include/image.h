@@ -303,6 +303,7 @@ enum {
 	IH_COMP_LZMA,			/* lzma  Compression Used	*/
 	IH_COMP_LZO,			/* lzo   Compression Used	*/
 	IH_COMP_LZ4,			/* lz4   Compression Used	*/
+	IH_COMP_ZSTD,			/* zstd  Compression Used	*/
 
 	IH_COMP_COUNT,
 };
@@ -956,6 +957,123 @@ int booti_setup(ulong image, ulong *relocated_addr, ulong *size,
 
 #define FIT_MAX_HASH_LEN	HASH_MAX_DIGEST_SIZE
 
+#ifdef USE_HOSTCC
+# define IMAGE_ENABLE_STREAM_VERIFY	0
+# define IMAGE_ENABLE_STREAM_DECOMP	0
+# define IMAGE_ENABLE_PARALLEL_VERIFY	0
+#else
+# define IMAGE_ENABLE_STREAM_VERIFY	CONFIG_IS_ENABLED(FIT_STREAM_VERIFY)
+# define IMAGE_ENABLE_STREAM_DECOMP	CONFIG_IS_ENABLED(FIT_STREAM_DECOMP)
+# define IMAGE_ENABLE_PARALLEL_VERIFY	CONFIG_IS_ENABLED(MP_JOBS)
+#endif
+
+#if IMAGE_ENABLE_STREAM_VERIFY
+/**
+ * fit_stream_start() - Start checking a FIT while it is being loaded
+ *
+ * This forgets any images verified by the previous load.
+ *
+ * @addr:	Address that the file is being loaded to
+ */
+void fit_stream_start(ulong addr);
+
+/**
+ * fit_stream_data() - Report how much of the file is now in memory
+ *
+ * The file must be loaded in order, from the start address onwards.
+ *
+ * @size:	Number of bytes from the start address which have been loaded
+ */
+void fit_stream_data(ulong size);
+
+/**
+ * fit_stream_written() - Report that a loader has written part of the file
+ *
+ * This is for loaders which do not know where the file started. It is
+ * ignored unless @buf is just past the data reported so far.
+ *
+ * @buf:	Where the data was written
+ * @len:	Number of bytes written
+ */
+void fit_stream_written(const void *buf, ulong len);
+
+/**
+ * fit_stream_chunk_size() - Get how much to load between reports
+ *
+ * @return the number of bytes which should be loaded before reporting them,
+ * so that they can be hashed while they are still in the cache, or 0 if no
+ * FIT is being loaded
+ */
+ulong fit_stream_chunk_size(void);
+
+/**
+ * fit_stream_end() - Finish checking a FIT once it is fully loaded
+ *
+ * The sub-images whose hashes all matched are not hashed again by
+ * fit_image_load().
+ */
+void fit_stream_end(void);
+
+/**
+ * fit_stream_active() - Check if the file being loaded is a FIT
+ *
+ * @return true if the file looks like a FIT so far, false once it is known
+ * not to be, or if no load is in progress
+ */
+bool fit_stream_active(void);
+#else
+static inline void fit_stream_start(ulong addr) {}
+static inline void fit_stream_data(ulong size) {}
+static inline void fit_stream_written(const void *buf, ulong len) {}
+static inline ulong fit_stream_chunk_size(void)
+{
+	return 0;
+}
+static inline void fit_stream_end(void) {}
+static inline bool fit_stream_active(void)
+{
+	return false;
+}
+#endif
+
+#if IMAGE_ENABLE_STREAM_DECOMP
+/**
+ * fit_stream_decompressed() - Check if a kernel was decompressed while loading
+ *
+ * This only succeeds once for each load, since anything may be loaded over
+ * the kernel after it has been booted or given up on.
+ *
+ * @comp:	Compression type (IH_COMP_...)
+ * @load:	Load address of the kernel
+ * @image_start: Address of the compressed data
+ * @image_len:	Size of the compressed data
+ * @load_end:	Returns the end address of the decompressed kernel
+ * @return true if this kernel is already at its load address
+ */
+bool fit_stream_decompressed(int comp, ulong load, ulong image_start,
+			     ulong image_len, ulong *load_end);
+#else
+static inline bool fit_stream_decompressed(int comp, ulong load,
+					   ulong image_start, ulong image_len,
+					   ulong *load_end)
+{
+	return false;
+}
+#endif
+
+#if IMAGE_ENABLE_STREAM_VERIFY || IMAGE_ENABLE_PARALLEL_VERIFY
+/**
+ * fit_verified_clear() - Forget the images which were verified ahead of time
+ *
+ * Images verified while loading or on all cores are only trusted until the
+ * boot they were verified for has found all of its images, since anything
+ * may be loaded over them after that.
+ */
+void fit_verified_clear(void);
+#else
+static inline void fit_verified_clear(void) {}
+#endif
+
 #if IMAGE_ENABLE_FIT
 /* cmdline argument format parsing */
 int fit_parse_conf(const char *spec, ulong addr_curr,
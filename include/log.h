@@ -9,6 +9,7 @@
 #ifndef __LOG_H
 #define __LOG_H
 
+#include <stdarg.h>
 #include <dm/uclass-id.h>
 #include <linux/list.h>
 
@@ -243,7 +244,9 @@ void __assert_fail(const char *assertion, const char *file, unsigned int line,
  * @file: Name of file where the log record was generated (not allocated)
  * @line: Line number where the log record was generated
  * @func: Function where the log record was generated (not allocated)
- * @msg: Log message (allocated)
+ * @msg: Log message (allocated), or NULL for a driver with LOGDF_RAW set
+ * @fmt: printf() format string for the message (not allocated)
+ * @args: Arguments for @fmt, which are only valid during emit()
  */
 struct log_rec {
 	enum log_category_t cat;
@@ -252,17 +255,37 @@ struct log_rec {
 	int line;
 	const char *func;
 	const char *msg;
+	const char *fmt;
+	va_list *args;
 };
 
 struct log_device;
 
+enum log_driver_flags {
+	/*
+	 * The driver uses the format string and arguments of each record,
+	 * so the message need not be formatted for it
+	 */
+	LOGDF_RAW	= 1 << 0,
+};
+
 /**
  * struct log_driver - a driver which accepts and processes log records
  *
  * @name: Name of driver
+ * @flags: Flags for this driver (LOGDF_...)
  */
 struct log_driver {
 	const char *name;
+	int flags;
+	/**
+	 * probe() - set up a log device (optional)
+	 *
+	 * Called by log_init() once the device has been added, e.g. to add
+	 * filters or allocate memory. Since log_init() is called both before
+	 * and after relocation, this is too.
+	 */
+	int (*probe)(struct log_device *ldev);
 	/**
 	 * emit() - emit a log record
 	 *
@@ -406,6 +429,29 @@ int log_add_filter(const char *drv_name, enum log_category_t cat_list[],
  */
 int log_remove_filter(const char *drv_name, int filter_num);
 
+/**
+ * log_ring_dump() - Print the records held in the log ring buffer
+ *
+ * The messages are only formatted now, using the format set by 'log format'.
+ * Each line starts with the time at which the record was generated.
+ *
+ * @return 0 if OK, -ENOENT if the ring buffer is not set up
+ */
+int log_ring_dump(void);
+
+/**
+ * log_ring_fdt_fixup() - Pass the log ring buffer to the OS
+ *
+ * The records are formatted into a new region of memory, which is added to
+ * the device tree as a ramoops console region under /reserved-memory. Linux
+ * then shows the messages in /sys/fs/pstore/console-ramoops-0.
+ *
+ * @blob: Device tree to update
+ * @return 0 if OK, -ENOENT if the ring buffer is not set up, -ENOMEM if
+ *	there is no memory for the region, other -ve value on device tree error
+ */
+int log_ring_fdt_fixup(void *blob);
+
 #if CONFIG_IS_ENABLED(LOG)
 /**
  * log_init() - Set up the log system ready for use
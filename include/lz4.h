@@ -0,0 +1,145 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Decoding LZ4 frames a block at a time
+ */
+
+#ifndef __LZ4_H
+#define __LZ4_H
+
+#include <linux/types.h>
+
+/**
+ * struct lz4_frame - An LZ4 frame being decoded
+ *
+ * When the blocks are independent, each one can be decoded on its own, in
+ * any order, given where its output goes. Every block but the last normally
+ * decompresses to exactly @block_max bytes, which fixes that position.
+ *
+ * @src:		Start of the frame
+ * @src_len:		Number of bytes of the frame available at @src
+ * @pos:		Offset of the next block in @src
+ * @block_max:		Maximum decompressed size of a block
+ * @content_size:	Decompressed size of the frame, 0 if not recorded
+ * @content_checksum:	xxh32 of the decompressed data, valid once @done is set
+ *			if @has_content_checksum
+ * @blocks:		Number of blocks returned by lz4_frame_next() so far
+ * @independent:	true if no block refers back into an earlier one
+ * @has_block_checksum:	true if each block is followed by its xxh32
+ * @has_content_checksum: true if the frame ends with the xxh32 of the
+ *			decompressed data
+ * @done:		true once the end of the frame has been reached
+ */
+struct lz4_frame {
+	const void *src;
+	size_t src_len;
+	size_t pos;
+	u32 block_max;
+	u64 content_size;
+	u32 content_checksum;
+	int blocks;
+	bool independent;
+	bool has_block_checksum;
+	bool has_content_checksum;
+	bool done;
+};
+
+/**
+ * struct lz4_block - A block of an LZ4 frame
+ *
+ * @data:	Block data as stored in the frame
+ * @size:	Number of bytes at @data
+ * @compressed:	true if @data is compressed, false if it is stored as is
+ * @checksum:	xxh32 of @data, if the frame has block checksums
+ * @dst_offset:	Offset of the decompressed data in the frame's output, if
+ *		every earlier block is full (@block_max bytes)
+ */
+struct lz4_block {
+	const void *data;
+	u32 size;
+	bool compressed;
+	u32 checksum;
+	size_t dst_offset;
+};
+
+/**
+ * lz4_frame_init() - Start decoding an LZ4 frame
+ *
+ * This reads the frame header. With CONFIG_LZ4_CHECKSUM its checksum is
+ * verified.
+ *
+ * @f:		Frame to set up
+ * @src:	Start of the frame
+ * @src_len:	Number of bytes available at @src
+ * @return 0 if OK, -EAGAIN if @src_len does not cover the header,
+ *	-EPROTONOSUPPORT if this is not an LZ4 frame, -EINVAL if the header is
+ *	invalid, -EBADMSG on a checksum mismatch
+ */
+int lz4_frame_init(struct lz4_frame *f, const void *src, size_t src_len);
+
+/**
+ * lz4_frame_next() - Get the next block of an LZ4 frame
+ *
+ * @f->src_len may be increased between calls, as more of the frame arrives.
+ *
+ * @f:		Frame being decoded
+ * @blk:	Returns the block
+ * @return 1 if a block was returned, 0 at the end of the frame, -EAGAIN if
+ *	@f->src_len does not cover the whole of the next block, -EPROTO if the
+ *	frame is corrupt
+ */
+int lz4_frame_next(struct lz4_frame *f, struct lz4_block *blk);
+
+/**
+ * lz4_block_decode() - Decompress a block of an LZ4 frame
+ *
+ * This needs nothing but @f and @blk, so blocks of an independent frame may
+ * be decoded at the same time on different cores. Otherwise they must be
+ * decoded in order, one after the other. With CONFIG_LZ4_CHECKSUM the block
+ * checksum is verified, if there is one.
+ *
+ * @f:		Frame which the block belongs to
+ * @blk:	Block to decompress
+ * @dst:	Start of the output of the whole frame, which blocks of a frame
+ *		which is not independent refer back into
+ * @offset:	Offset from @dst to decompress the block to
+ * @dst_len:	Size of the output buffer at @dst
+ * @return number of bytes decompressed if OK, -ENOBUFS if the output buffer
+ *	is too small, -EPROTO if the block is corrupt, -EBADMSG on a checksum
+ *	mismatch
+ */
+int lz4_block_decode(const struct lz4_frame *f, const struct lz4_block *blk,
+		     void *dst, size_t offset, size_t dst_len);
+
+/**
+ * lz4_frame_check() - Check the output of a fully decoded LZ4 frame
+ *
+ * This checks the content size if the frame records it and, with
+ * CONFIG_LZ4_CHECKSUM, the content checksum if there is one.
+ *
+ * @f:		Frame, with @f->done set
+ * @dst:	Decompressed data
+ * @len:	Number of bytes at @dst
+ * @return 0 if OK, -EPROTO if the size is wrong, -EBADMSG on a checksum
+ *	mismatch
+ */
+int lz4_frame_check(const struct lz4_frame *f, const void *dst, size_t len);
+
+/**
+ * lz4_frame_decode_mp() - Decode the blocks of an independent frame on all cores
+ *
+ * Each block is decoded at the offset it has if every earlier block is full.
+ * If one turns out not to be, the output is not usable and the frame must be
+ * decoded again in order, one block after the other.
+ *
+ * @f:		Frame to decode, as set up by lz4_frame_init()
+ * @dst:	Output buffer, which must not overlap the frame
+ * @dst_len:	Size of the output buffer at @dst
+ * @out_lenp:	Returns the number of bytes decompressed, if OK
+ * @return 0 if OK, -EAGAIN if a block other than the last is short, else
+ *	an error from lz4_block_decode() or lz4_frame_check(), or -EINVAL if
+ *	the frame is truncated
+ */
+int lz4_frame_decode_mp(struct lz4_frame *f, void *dst, size_t dst_len,
+			size_t *out_lenp);
+
+#endif /* __LZ4_H */
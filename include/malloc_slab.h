@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Small allocations served from per-size slabs
+ */
+
+#ifndef __MALLOC_SLAB_H
+#define __MALLOC_SLAB_H
+
+#include <linux/types.h>
+
+/* Largest allocation served from a slab */
+#define SLAB_MAX_SIZE		512
+
+/**
+ * struct slab_stats - Statistics for one size class
+ *
+ * @size:	Size of each object in the class
+ * @pages:	Number of slab pages the class holds
+ * @objects:	Number of objects which fit in those pages
+ * @used:	Number of objects allocated
+ * @allocs:	Number of allocations served so far
+ * @frees:	Number of objects freed so far
+ * @misses:	Number of allocations passed on to dlmalloc because no slab
+ *		page could be allocated
+ */
+struct slab_stats {
+	uint size;
+	uint pages;
+	uint objects;
+	uint used;
+	ulong allocs;
+	ulong frees;
+	ulong misses;
+};
+
+/**
+ * slab_init() - Set up the slabs in a new malloc() pool
+ *
+ * This is called by mem_malloc_init(), and reserves space at the start of
+ * the pool to track which pages are slabs. Everything else comes from
+ * dlmalloc as it is needed.
+ *
+ * @start:	Start of the pool
+ * @size:	Size of the pool in bytes
+ * @return number of bytes reserved at @start
+ */
+size_t slab_init(ulong start, size_t size);
+
+/**
+ * slab_alloc() - Allocate a small object
+ *
+ * @bytes:	Number of bytes needed, at most SLAB_MAX_SIZE
+ * @return pointer to the object, or NULL if dlmalloc should allocate it
+ */
+void *slab_alloc(size_t bytes);
+
+/**
+ * slab_free() - Free an object, if it is in a slab
+ *
+ * @mem:	Object to free
+ * @return true if @mem was in a slab and is now free, false if it belongs to
+ *	dlmalloc
+ */
+bool slab_free(void *mem);
+
+/**
+ * slab_usable_size() - Get the usable size of an object, if it is in a slab
+ *
+ * @mem:	Object to check
+ * @return size of the object, or 0 if it belongs to dlmalloc
+ */
+size_t slab_usable_size(const void *mem);
+
+/**
+ * slab_get_stats() - Get the statistics for a size class
+ *
+ * @class:	Size class number, from 0
+ * @stats:	Returns the statistics
+ * @return 0 if OK, -ENOENT if there is no such class
+ */
+int slab_get_stats(int class, struct slab_stats *stats);
+
+#endif /* __MALLOC_SLAB_H */
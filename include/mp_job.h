@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Running self-contained jobs on the secondary cores
+ */
+
+#ifndef __MP_JOB_H
+#define __MP_JOB_H
+
+#include <linux/string.h>
+#include <linux/types.h>
+
+/**
+ * struct mp_job - A piece of work which may run on any core
+ *
+ * The function runs with the primary core's page tables and global data
+ * pointer, but it must not use the console, timers, drivers, the watchdog or
+ * malloc(), since none of these expect to be used from two cores at once.
+ * Plain memory and the hash/crc library functions are fine.
+ *
+ * @func:	Function to run
+ * @arg:	Argument to pass to @func
+ * @ret:	Return value of @func, valid once mp_job_run() returns
+ */
+struct mp_job {
+	int (*func)(void *arg);
+	void *arg;
+	int ret;
+};
+
+#if CONFIG_IS_ENABLED(MP_JOBS)
+/**
+ * mp_job_cores() - Get the number of cores which can run jobs
+ *
+ * @return number of cores including the primary one, 1 if jobs can only run
+ *	on the primary core
+ */
+int mp_job_cores(void);
+
+/**
+ * mp_job_run() - Run a batch of jobs spread over all available cores
+ *
+ * The primary core runs a share of the jobs itself. This returns once every
+ * job has finished and all secondary cores are back in the spin table.
+ *
+ * @jobs:	Jobs to run
+ * @count:	Number of jobs
+ * @return 0 if all jobs returned 0, else the first non-zero job return value
+ */
+int mp_job_run(struct mp_job *jobs, int count);
+
+/**
+ * mp_memcpy() - Copy memory, using all available cores
+ *
+ * The areas must not overlap.
+ *
+ * @dest:	Destination address
+ * @src:	Source address
+ * @len:	Number of bytes to copy
+ * @return @dest
+ */
+void *mp_memcpy(void *dest, const void *src, size_t len);
+
+/**
+ * mp_memset() - Fill memory, using all available cores
+ *
+ * @s:		Address to fill
+ * @c:		Byte value to fill with
+ * @len:	Number of bytes to fill
+ * @return @s
+ */
+void *mp_memset(void *s, int c, size_t len);
+#else
+static inline int mp_job_cores(void)
+{
+	return 1;
+}
+
+static inline int mp_job_run(struct mp_job *jobs, int count)
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		jobs[i].ret = jobs[i].func(jobs[i].arg);
+		if (jobs[i].ret && !ret)
+			ret = jobs[i].ret;
+	}
+
+	return ret;
+}
+
+static inline void *mp_memcpy(void *dest, const void *src, size_t len)
+{
+	return memcpy(dest, src, len);
+}
+
+static inline void *mp_memset(void *s, int c, size_t len)
+{
+	return memset(s, c, len);
+}
+#endif
+
+#endif /* __MP_JOB_H */
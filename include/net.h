@@ -124,6 +124,19 @@ enum eth_recv_flags {
  * free_pkt: Give the driver an opportunity to manage its packet buffer memory
  *	     when the network stack is finished processing it. This will only be
  *	     called when no error was returned from recv - optional
+ * recv_batch: Like recv, but return a burst of up to "count" packets at once,
+ *	       filling in the packetp and lenp arrays. Returns the number of
+ *	       packets received, 0 if the receive FIFO is empty, or an error.
+ *	       If present, this is used instead of recv/free_pkt - optional
+ * free_batch: Hand back all the packet buffers returned by the previous
+ *	       recv_batch call once the network stack is finished with them.
+ *	       This is only called when recv_batch returned packets - optional
+ * recv_into: Have a later packet, ideally the next one, received straight
+ *	      into "buf" instead of a driver buffer. It is returned by
+ *	      recv_batch as usual, with its packetp entry set to "buf". There
+ *	      is room for PKTSIZE_ALIGN bytes at "buf". A NULL "buf" cancels
+ *	      the request. Returns -EINVAL if the hardware cannot use "buf",
+ *	      e.g. due to its alignment - optional
  * stop: Stop the hardware from looking for packets - may be called even if
  *	 state == PASSIVE
  * mcast: Join or leave a multicast group (for TFTP) - optional
@@ -142,6 +155,11 @@ struct eth_ops {
 	int (*send)(struct udevice *dev, void *packet, int length);
 	int (*recv)(struct udevice *dev, int flags, uchar **packetp);
 	int (*free_pkt)(struct udevice *dev, uchar *packet, int length);
+	int (*recv_batch)(struct udevice *dev, int flags, uchar **packetp,
+			  int *lenp, int count);
+	int (*free_batch)(struct udevice *dev, uchar **packetp, int *lenp,
+			  int count);
+	int (*recv_into)(struct udevice *dev, uchar *buf);
 	void (*stop)(struct udevice *dev);
 	int (*mcast)(struct udevice *dev, const u8 *enetaddr, int join);
 	int (*write_hwaddr)(struct udevice *dev);
@@ -283,6 +301,7 @@ int eth_receive(void *packet, int length); /* Receive a packet*/
 extern void (*push_packet)(void *packet, int length);
 #endif
 int eth_rx(void);			/* Check for received packets */
+int eth_recv_into(uchar *buf);		/* Receive next packet into buf */
 void eth_halt(void);			/* stop SCC */
 const char *eth_get_name(void);		/* get name of current device */
 int eth_mcast_join(struct in_addr mcast_addr, int join);
@@ -346,6 +365,7 @@ struct vlan_ethernet_hdr {
 #define PROT_PPP_SES	0x8864		/* PPPoE session messages	*/
 
 #define IPPROTO_ICMP	 1	/* Internet Control Message Protocol	*/
+#define IPPROTO_TCP	 6	/* Transmission Control Protocol	*/
 #define IPPROTO_UDP	17	/* User Datagram Protocol		*/
 
 /*
@@ -395,6 +415,45 @@ struct ip_udp_hdr {
 #define IP_UDP_HDR_SIZE		(sizeof(struct ip_udp_hdr))
 #define UDP_HDR_SIZE		(IP_UDP_HDR_SIZE - IP_HDR_SIZE)
 
+/*
+ *	Internet Protocol (IP) + TCP header, without options.
+ */
+struct ip_tcp_hdr {
+	u8		ip_hl_v;	/* header length and version	*/
+	u8		ip_tos;		/* type of service		*/
+	u16		ip_len;		/* total length			*/
+	u16		ip_id;		/* identification		*/
+	u16		ip_off;		/* fragment offset field	*/
+	u8		ip_ttl;		/* time to live			*/
+	u8		ip_p;		/* protocol			*/
+	u16		ip_sum;		/* checksum			*/
+	struct in_addr	ip_src;		/* Source IP address		*/
+	struct in_addr	ip_dst;		/* Destination IP address	*/
+	u16		tcp_src;	/* TCP source port		*/
+	u16		tcp_dst;	/* TCP destination port		*/
+	u32		tcp_seq;	/* Sequence number		*/
+	u32		tcp_ack;	/* Acknowledgment number	*/
+	u8		tcp_hlen;	/* Header length, in top 4 bits	*/
+	u8		tcp_flags;	/* Control bits			*/
+	u16		tcp_win;	/* Receive window		*/
+	u16		tcp_xsum;	/* Checksum			*/
+	u16		tcp_urg;	/* Urgent pointer		*/
+} __attribute__((packed));
+
+#define IP_TCP_HDR_SIZE		(sizeof(struct ip_tcp_hdr))
+#define TCP_HDR_SIZE		(IP_TCP_HDR_SIZE - IP_HDR_SIZE)
+
+#define TCP_FIN			0x01
+#define TCP_SYN			0x02
+#define TCP_RST			0x04
+#define TCP_PUSH		0x08
+#define TCP_ACK			0x10
+
+#define TCP_OPT_END		0
+#define TCP_OPT_NOP		1
+#define TCP_OPT_MSS		2
+#define TCP_OPT_WSCALE		3
+
 /*
  *	Address Resolution Protocol (ARP) header.
  */
@@ -529,9 +588,32 @@ extern ushort		net_native_vlan;	/* Our Native VLAN */
 
 extern int		net_restart_wrap;	/* Tried all network devices */
 
+/**
+ * struct net_stats - Network counters, shown by the netstat command
+ *
+ * @rx_packets:		Packets received
+ * @tx_packets:		Packets sent
+ * @frag_rx:		IP fragments received
+ * @frag_reassembled:	IP datagrams put back together from their fragments
+ * @frag_dropped:	IP fragments which could not be used, plus datagrams
+ *			given up half-done to make room for a newer one
+ * @frag_timed_out:	IP datagrams given up because the rest of their
+ *			fragments did not arrive in time
+ */
+struct net_stats {
+	ulong rx_packets;
+	ulong tx_packets;
+	ulong frag_rx;
+	ulong frag_reassembled;
+	ulong frag_dropped;
+	ulong frag_timed_out;
+};
+
+extern struct net_stats	net_stats;
+
 enum proto_t {
 	BOOTP, RARP, ARP, TFTPGET, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
-	TFTPSRV, TFTPPUT, LINKLOCAL, FASTBOOT, WOL
+	TFTPSRV, TFTPPUT, LINKLOCAL, FASTBOOT, WOL, WGET
 };
 
 extern char	net_boot_file_name[1024];/* Boot File name */
@@ -628,6 +710,22 @@ void net_set_udp_handler(rxhand_f *);	/* Set UDP RX packet handler */
 rxhand_f *net_get_arp_handler(void);	/* Get ARP RX packet handler */
 void net_set_arp_handler(rxhand_f *);	/* Set ARP RX packet handler */
 bool arp_is_waiting(void);		/* Waiting for ARP reply? */
+
+/**
+ * arp_cache_lookup() - Look up a neighbour's MAC address in the ARP cache
+ *
+ * Addresses found by ARP are kept between commands, so that scripts which
+ * fetch several files do not have to find the server again each time.
+ *
+ * @dest:	IP address to send to; if it is not on our subnet, the gateway
+ *		is looked up instead
+ * @ethaddr:	Set to the MAC address, if found
+ * @return true if found, false if ARP is needed
+ */
+bool arp_cache_lookup(struct in_addr dest, uchar *ethaddr);
+
+/* Forget all the MAC addresses in the ARP cache */
+void arp_cache_flush(void);
 void net_set_icmp_handler(rxhand_icmp_f *f); /* Set ICMP RX handler */
 void net_set_timeout_handler(ulong, thand_f *);/* Set timeout handler */
 
@@ -659,11 +757,12 @@ static inline void net_send_packet(uchar *pkt, int len)
 {
 	/* Currently no way to return errors from eth_send() */
 	(void) eth_send(pkt, len);
+	net_stats.tx_packets++;
 }
 
 /*
  * Transmit "net_tx_packet" as UDP packet, performing ARP request if needed
- *  (ether will be populated)
+ *  (ether will be populated, from the ARP cache if possible)
  *
  * @param ether Raw packet buffer
  * @param dest IP address to send the datagram to
@@ -680,6 +779,30 @@ int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport,
 /* Processes a received packet */
 void net_process_received_packet(uchar *in_packet, int len);
 
+/* Most header bytes net_rx_direct() can place in front of the destination */
+#define NET_RX_DIRECT_MAX_HDR	256
+
+/**
+ * net_rx_direct() - Have the next packet received in place
+ *
+ * Asks the Ethernet driver to receive the next packet into memory, placing
+ * its headers in the @hdr_len bytes in front of @dest so that a payload
+ * following exactly @hdr_len bytes of headers lands at @dest. Those bytes are
+ * saved first and put back once the packet has been processed, so the
+ * protocol handler finds the payload already stored if it was the expected
+ * packet, and must copy it otherwise. Note that the driver may write up to
+ * PKTSIZE_ALIGN bytes from @dest - @hdr_len.
+ *
+ * This only affects the next received packet; a new call replaces an earlier
+ * request and passing a NULL @dest cancels it.
+ *
+ * @dest:	Where to receive the payload
+ * @hdr_len:	Number of header bytes in front of the payload
+ * @return 0 if OK, -ENOSYS if the driver does not support this, other -ve on
+ *	error
+ */
+int net_rx_direct(uchar *dest, int hdr_len);
+
 #if defined(CONFIG_NETCONSOLE) && !defined(CONFIG_SPL_BUILD)
 void nc_start(void);
 int nc_input_packet(uchar *pkt, struct in_addr src_ip, unsigned dest_port,
@@ -79,6 +79,39 @@ struct trace_call {
 
 int trace_list_calls(void *buff, size_t buff_size, size_t *needed);
 
+/**
+ * Write the call trace into a buffer as folded stacks
+ *
+ * This is the text format taken by flame graph tools: one line for each
+ * chain of calls seen, with the address of each function separated by ';',
+ * outermost first, then a space and the number of microseconds spent in the
+ * last function itself (not in the functions it called). The addresses can
+ * be looked up in System.map or with addr2line.
+ *
+ * Like trace_list_calls(), the 'needed' parameter returns the number of
+ * bytes needed, which may be more than buff_size.
+ *
+ * @param buff		Buffer in which to place data, or NULL to count size
+ * @param buff_size	Size of buffer
+ * @param needed	Returns number of bytes used / needed
+ * @return 0 if ok, -ENOSPC if the buffer is too small, -ENOMEM if there is
+ *	not enough memory to build the call tree
+ */
+int trace_list_folded(void *buff, size_t buff_size, size_t *needed);
+
+/**
+ * Print the functions which took most time in the call trace
+ *
+ * For each function this shows the number of calls, the total time spent
+ * in the function including everything it called, and the time spent in
+ * the function itself. The list is sorted by the latter.
+ *
+ * @param count		Maximum number of functions to print
+ * @return 0 if ok, -ENOENT if tracing is not set up, -ENOMEM if there is not
+ *	enough memory to build the call tree
+ */
+int trace_print_hot(int count);
+
 /**
  * Turn function tracing on and off
  *
@@ -88,6 +121,18 @@ int trace_list_calls(void *buff, size_t buff_size, size_t *needed);
  */
 void trace_set_enabled(int enabled);
 
+/**
+ * Limit the call trace to a window of time
+ *
+ * Calls made outside the window are still counted in the function list, but
+ * are not added to the call trace. This allows a trace buffer of modest size
+ * to cover the part of boot which is of interest.
+ *
+ * @param start_us	Start of the window, as a timer_get_us() value
+ * @param end_us	End of the window, or 0 for no end
+ */
+void trace_set_window(ulong start_us, ulong end_us);
+
 int trace_early_init(void);
 
 /**
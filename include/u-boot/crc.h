@@ -45,4 +45,30 @@ void crc32_wd_buf(const unsigned char *input, uint ilen,
 void crc32c_init(uint32_t *, uint32_t);
 uint32_t crc32c_cal(uint32_t, const char *, int, uint32_t *);
 
+/**
+ * crc32_ce_process() - Update a CRC32 using CPU instructions
+ *
+ * This is provided by the architecture when CONFIG_ARMV8_CE_CRC32 is
+ * enabled, and is used by crc32_no_comp() in place of the tables.
+ *
+ * @crc:	CRC to update, without the ones complement
+ * @buf:	Data to add to the CRC
+ * @len:	Length of data in bytes
+ * @return 0 if OK, -ENOSYS if the CPU does not support it
+ */
+int crc32_ce_process(uint32_t *crc, const uint8_t *buf, uint len);
+
+/**
+ * crc32c_ce_process() - Update a CRC32C using CPU instructions
+ *
+ * Like crc32_ce_process(), but with the Castagnoli polynomial, as used by
+ * crc32c_cal()
+ *
+ * @crc:	CRC to update
+ * @buf:	Data to add to the CRC
+ * @len:	Length of data in bytes
+ * @return 0 if OK, -ENOSYS if the CPU does not support it
+ */
+int crc32c_ce_process(uint32_t *crc, const uint8_t *buf, uint len);
+
 #endif /* _UBOOT_CRC_H */
@@ -101,6 +101,20 @@ void sha1_hmac(const unsigned char *key, int keylen,
  */
 int sha1_self_test( void );
 
+/**
+ * sha1_ce_process() - Hash whole blocks using CPU instructions
+ *
+ * This is provided by the architecture when CONFIG_ARMV8_CE_SHA1 is
+ * enabled, and is used by sha1_update() in place of the C block function.
+ *
+ * @ctx:	SHA-1 context to update
+ * @data:	Data to hash
+ * @blocks:	Number of 64-byte blocks to hash, at least 1
+ * @return 0 if OK, -ENOSYS if the CPU does not support it
+ */
+int sha1_ce_process(sha1_context *ctx, const unsigned char *data,
+		    unsigned int blocks);
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,4 +22,18 @@ void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+/**
+ * sha256_ce_process() - Hash whole blocks using CPU instructions
+ *
+ * This is provided by the architecture when CONFIG_ARMV8_CE_SHA256 is
+ * enabled, and is used by sha256_update() in place of the C block function.
+ *
+ * @ctx:	SHA-256 context to update
+ * @data:	Data to hash
+ * @blocks:	Number of 64-byte blocks to hash, at least 1
+ * @return 0 if OK, -ENOSYS if the CPU does not support it
+ */
+int sha256_ce_process(sha256_context *ctx, const uint8_t *data,
+		      unsigned int blocks);
+
 #endif /* _SHA256_H */
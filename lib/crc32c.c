@@ -12,10 +12,20 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <u-boot/crc.h>
+
+/* Bit-reflected Castagnoli polynomial, which crc32c_table[128] holds */
+#define CRC32C_POLY	0x82f63b78
 
 uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 		    uint32_t *crc32c_table)
 {
+#ifdef CONFIG_ARMV8_CE_CRC32
+	/* The CRC32C instructions only know the Castagnoli polynomial */
+	if (length > 0 && crc32c_table[128] == CRC32C_POLY &&
+	    !crc32c_ce_process(&crc, (const uint8_t *)data, length))
+		return crc;
+#endif
 	while (length--)
 		crc = crc32c_table[(u8)(crc ^ *data++)] ^ (crc >> 8);
 
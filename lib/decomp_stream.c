@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Decompressing data as it arrives
+ */
+
+#include <common.h>
+#include <decomp_stream.h>
+#include <image.h>
+#include <malloc.h>
+#include <linux/zstd.h>
+
+#if CONFIG_IS_ENABLED(ZSTD)
+/*
+ * zstd has a buffer-less interface which asks for exactly the number of
+ * bytes it needs next, and decodes each block straight into the output
+ * buffer, using the output already written as its window.
+ *
+ * The frame header normally records the decompressed size, so an output
+ * buffer which is too small is refused before anything is decoded, rather
+ * than after filling it.
+ */
+#define ZSTD_STREAM_HEADER_CHECKED	1
+struct zstd_stream {
+	ZSTD_DCtx *dctx;
+	char workspace[];	/* The context is allocated in here */
+};
+
+static int zstd_stream_init(struct decomp_stream *ds)
+{
+	size_t wsize = ZSTD_DCtxWorkspaceBound();
+	struct zstd_stream *zs;
+
+	zs = malloc(sizeof(*zs) + wsize);
+	if (!zs)
+		return -ENOMEM;
+	zs->dctx = ZSTD_initDCtx(zs->workspace, wsize);
+	if (!zs->dctx || ZSTD_isError(ZSTD_decompressBegin(zs->dctx))) {
+		free(zs);
+		return -EINVAL;
+	}
+	ds->priv = zs;
+
+	return 0;
+}
+
+static int zstd_stream_feed(struct decomp_stream *ds)
+{
+	struct zstd_stream *zs = ds->priv;
+	ZSTD_frameParams params;
+	size_t need, ret;
+
+	if (!(ds->state & ZSTD_STREAM_HEADER_CHECKED)) {
+		ret = ZSTD_getFrameParams(&params, ds->src + ds->used,
+					  ds->src_len - ds->used);
+		if (ZSTD_isError(ret))
+			return -EPROTO;
+		if (ret)
+			return 0;	/* wait for the rest of the header */
+		/*
+		 * A size of 0 means that it is not recorded, and a skippable
+		 * frame (window size 0) records its own length there instead
+		 */
+		if (params.windowSize && params.frameContentSize > ds->dst_len)
+			return -ENOBUFS;
+		ds->state |= ZSTD_STREAM_HEADER_CHECKED;
+	}
+
+	while (!ds->done) {
+		need = ZSTD_nextSrcSizeToDecompress(zs->dctx);
+		if (!need) {
+			ds->done = true;
+			break;
+		}
+		if (ds->src_len - ds->used < need)
+			break;
+		ret = ZSTD_decompressContinue(zs->dctx, ds->dst + ds->out,
+					      ds->dst_len - ds->out,
+					      ds->src + ds->used, need);
+		if (ZSTD_isError(ret)) {
+			if (ZSTD_getErrorCode(ret) == ZSTD_error_dstSize_tooSmall)
+				return -ENOBUFS;
+			return -EPROTO;
+		}
+		ds->used += need;
+		ds->out += ret;
+	}
+
+	return 0;
+}
+
+static void zstd_stream_finish(struct decomp_stream *ds)
+{
+	free(ds->priv);
+}
+#endif /* ZSTD */
+
+struct decomp_stream_ops {
+	int comp;
+	int (*init)(struct decomp_stream *ds);
+	int (*feed)(struct decomp_stream *ds);
+	void (*finish)(struct decomp_stream *ds);
+};
+
+static const struct decomp_stream_ops decomp_stream_ops[] = {
+#if CONFIG_IS_ENABLED(GZIP)
+	{ IH_COMP_GZIP, gunzip_stream_init, gunzip_stream_feed,
+	  gunzip_stream_finish },
+#endif
+#if CONFIG_IS_ENABLED(LZ4)
+	{ IH_COMP_LZ4, lz4_stream_init, lz4_stream_feed, lz4_stream_finish },
+#endif
+#if CONFIG_IS_ENABLED(LZMA)
+	{ IH_COMP_LZMA, lzma_stream_init, lzma_stream_feed,
+	  lzma_stream_finish },
+#endif
+#if CONFIG_IS_ENABLED(ZSTD)
+	{ IH_COMP_ZSTD, zstd_stream_init, zstd_stream_feed,
+	  zstd_stream_finish },
+#endif
+};
+
+static const struct decomp_stream_ops *decomp_stream_get_ops(int comp)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(decomp_stream_ops); i++) {
+		if (decomp_stream_ops[i].comp == comp)
+			return &decomp_stream_ops[i];
+	}
+
+	return NULL;
+}
+
+bool decomp_stream_supported(int comp)
+{
+	return decomp_stream_get_ops(comp);
+}
+
+int decomp_stream_init(struct decomp_stream *ds, int comp, void *dst,
+		       size_t dst_len)
+{
+	const struct decomp_stream_ops *ops = decomp_stream_get_ops(comp);
+
+	if (!ops)
+		return -ENOSYS;
+	memset(ds, '\0', sizeof(*ds));
+	ds->comp = comp;
+	ds->dst = dst;
+	ds->dst_len = dst_len;
+
+	return ops->init(ds);
+}
+
+int decomp_stream_feed(struct decomp_stream *ds, const void *src, size_t len)
+{
+	const struct decomp_stream_ops *ops = decomp_stream_get_ops(ds->comp);
+
+	if (ds->src && src != ds->src + ds->src_len)
+		ds->err = -EINVAL;
+	if (ds->err)
+		return ds->err;
+
+	if (!ds->src)
+		ds->src = src;
+	ds->src_len += len;
+	if (!ds->done)
+		ds->err = ops->feed(ds);
+
+	return ds->err;
+}
+
+int decomp_stream_finish(struct decomp_stream *ds, size_t *out_lenp)
+{
+	const struct decomp_stream_ops *ops = decomp_stream_get_ops(ds->comp);
+
+	ops->finish(ds);
+	*out_lenp = ds->out;
+	if (ds->err)
+		return ds->err;
+
+	return ds->done ? 0 : -EINVAL;
+}
+
+int decomp_stream_buf(int comp, void *dst, size_t *dst_lenp, const void *src,
+		      size_t src_len)
+{
+	struct decomp_stream ds;
+	int ret;
+
+	ret = decomp_stream_init(&ds, comp, dst, *dst_lenp);
+	if (ret)
+		return ret;
+	decomp_stream_feed(&ds, src, src_len);
+
+	return decomp_stream_finish(&ds, dst_lenp);
+}
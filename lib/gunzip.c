@@ -7,6 +7,7 @@
 #include <common.h>
 #include <command.h>
 #include <console.h>
+#include <decomp_stream.h>
 #include <div64.h>
 #include <gzip.h>
 #include <image.h>
@@ -42,32 +43,59 @@ void gzfree(void *x, void *addr, unsigned nb)
 	free (addr);
 }
 
-int gzip_parse_header(const unsigned char *src, unsigned long len)
+/*
+ * Work out the length of a gzip header, returning -EAGAIN if @len bytes are
+ * not enough to tell
+ */
+static int gzip_header_len(const unsigned char *src, unsigned long len)
 {
-	int i, flags;
+	unsigned long i;
+	int flags;
+
+	if (len < 10)
+		return -EAGAIN;
 
 	/* skip header */
 	i = 10;
 	flags = src[3];
-	if (src[2] != DEFLATED || (flags & RESERVED) != 0) {
-		puts ("Error: Bad gzipped data\n");
-		return (-1);
-	}
-	if ((flags & EXTRA_FIELD) != 0)
+	if (src[2] != DEFLATED || (flags & RESERVED) != 0)
+		return -EINVAL;
+	if ((flags & EXTRA_FIELD) != 0) {
+		if (len < 12)
+			return -EAGAIN;
 		i = 12 + src[10] + (src[11] << 8);
-	if ((flags & ORIG_NAME) != 0)
-		while (src[i++] != 0)
-			;
-	if ((flags & COMMENT) != 0)
-		while (src[i++] != 0)
-			;
+	}
+	if ((flags & ORIG_NAME) != 0) {
+		while (i < len && src[i] != 0)
+			i++;
+		i++;
+	}
+	if ((flags & COMMENT) != 0) {
+		while (i < len && src[i] != 0)
+			i++;
+		i++;
+	}
 	if ((flags & HEAD_CRC) != 0)
 		i += 2;
-	if (i >= len) {
+	if (i >= len)
+		return -EAGAIN;
+
+	return i;
+}
+
+int gzip_parse_header(const unsigned char *src, unsigned long len)
+{
+	int ret = gzip_header_len(src, len);
+
+	if (ret == -EINVAL) {
+		puts ("Error: Bad gzipped data\n");
+		return (-1);
+	}
+	if (ret < 0) {
 		puts ("Error: gunzip out of data in header\n");
 		return (-1);
 	}
-	return i;
+	return ret;
 }
 
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
@@ -306,3 +334,71 @@ int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 
 	return err;
 }
+
+/* Progress of a gunzip stream */
+enum {
+	GUNZIP_STREAM_HEADER,		/* Waiting for the whole gzip header */
+	GUNZIP_STREAM_DATA,		/* Inflating */
+};
+
+int gunzip_stream_init(struct decomp_stream *ds)
+{
+	z_stream *s;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return -ENOMEM;
+	s->zalloc = gzalloc;
+	s->zfree = gzfree;
+	if (inflateInit2(s, -MAX_WBITS) != Z_OK) {
+		free(s);
+		return -ENOMEM;
+	}
+	s->next_out = ds->dst;
+	s->avail_out = ds->dst_len;
+	ds->priv = s;
+	ds->state = GUNZIP_STREAM_HEADER;
+
+	return 0;
+}
+
+int gunzip_stream_feed(struct decomp_stream *ds)
+{
+	z_stream *s = ds->priv;
+	int ret;
+
+	if (ds->state == GUNZIP_STREAM_HEADER) {
+		ret = gzip_header_len(ds->src, ds->src_len);
+		if (ret == -EAGAIN)
+			return 0;
+		if (ret < 0)
+			return ret;
+		ds->used = ret;
+		ds->state = GUNZIP_STREAM_DATA;
+	}
+
+	s->next_in = (unsigned char *)ds->src + ds->used;
+	s->avail_in = ds->src_len - ds->used;
+	ret = inflate(s, Z_NO_FLUSH);
+	/* The end of the stream may still turn up with the output full */
+	if (ret == Z_OK && !s->avail_out && s->avail_in)
+		ret = inflate(s, Z_NO_FLUSH);
+	ds->used = s->next_in - (unsigned char *)ds->src;
+	ds->out = s->next_out - (unsigned char *)ds->dst;
+	if (ret == Z_STREAM_END) {
+		ds->done = true;
+		return 0;
+	}
+	if (ret != Z_OK && ret != Z_BUF_ERROR)
+		return -EPROTO;
+	if (!s->avail_out && s->avail_in)
+		return -ENOBUFS;
+
+	return 0;
+}
+
+void gunzip_stream_finish(struct decomp_stream *ds)
+{
+	inflateEnd(ds->priv);
+	free(ds->priv);
+}
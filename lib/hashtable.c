@@ -36,7 +36,7 @@
 #ifndef	CONFIG_ENV_MIN_ENTRIES	/* minimum number of entries */
 #define	CONFIG_ENV_MIN_ENTRIES 64
 #endif
-#ifndef	CONFIG_ENV_MAX_ENTRIES	/* maximum number of entries */
+#ifndef	CONFIG_ENV_MAX_ENTRIES	/* maximum initial number of entries */
 #define	CONFIG_ENV_MAX_ENTRIES 512
 #endif
 
@@ -61,6 +61,7 @@
 
 struct env_entry_node {
 	int used;
+	unsigned int hash;	/* hash of entry.key, see hash_key() */
 	struct env_entry entry;
 };
 
@@ -118,6 +119,7 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 
 	htab->size = nel;
 	htab->filled = 0;
+	htab->deleted = 0;
 
 	/* allocate memory and zero out */
 	htab->table = (struct env_entry_node *)calloc(htab->size + 1,
@@ -164,6 +166,97 @@ void hdestroy_r(struct hsearch_data *htab)
 	htab->table = NULL;
 }
 
+/*
+ * Hash a key with FNV-1a. Every character of the key affects the result, so
+ * that generated names such as "var_00001", "var_00002", ... spread evenly
+ * over the table.
+ */
+static unsigned int hash_key(const char *key)
+{
+	unsigned int hash = 2166136261U;
+
+	while (*key) {
+		hash ^= (unsigned char)*key++;
+		hash *= 16777619;
+	}
+
+	return hash;
+}
+
+/* First index tried for a hash: the modulus, but never zero */
+static unsigned int first_index(struct hsearch_data *htab, unsigned int hash)
+{
+	unsigned int hval = hash % htab->size;
+
+	return hval ? hval : 1;
+}
+
+/* Next index tried after 'idx', for a key whose first index is 'hval' */
+static unsigned int next_index(struct hsearch_data *htab, unsigned int hval,
+			       unsigned int idx)
+{
+	/* Second hash function: as suggested in [Knuth] */
+	unsigned int hval2 = 1 + hval % (htab->size - 2);
+
+	/* Because SIZE is prime this guarantees to step through all indices */
+	if (idx <= hval2)
+		return htab->size + idx - hval2;
+
+	return idx - hval2;
+}
+
+/*
+ * Move the entries to a new table of (at least) the given size. The keys
+ * are not hashed again, nor compared, since each is known to be unique.
+ * Slots of deleted entries are dropped along the way.
+ */
+static int hresize_r(struct hsearch_data *htab, size_t nel)
+{
+	struct env_entry_node *old = htab->table;
+	unsigned int old_size = htab->size;
+	struct hsearch_data new = *htab;
+	unsigned int i, idx, hval;
+
+	new.table = NULL;
+	if (hcreate_r(nel, &new) == 0)
+		return 0;
+
+	for (i = 1; i <= old_size; ++i) {
+		if (old[i].used <= 0)
+			continue;
+		hval = first_index(&new, old[i].hash);
+		for (idx = hval; new.table[idx].used;)
+			idx = next_index(&new, hval, idx);
+		new.table[idx] = old[i];
+		new.table[idx].used = hval;
+	}
+	debug("Resize Hash Table: %p N=%u -> %u\n", htab, old_size, new.size);
+	free(old);
+	htab->table = new.table;
+	htab->size = new.size;
+	htab->deleted = 0;
+
+	return 1;
+}
+
+/*
+ * Make room before adding an entry, so that probe sequences stay short:
+ * grow the table when it is three quarters full, counting deleted slots,
+ * which also clears those out. If this fails, the current table is used
+ * until it is completely full.
+ */
+static void hmake_room(struct hsearch_data *htab)
+{
+	size_t nel = htab->size;
+
+	if (htab->busy || (htab->filled + htab->deleted + 1) * 4 <
+	    htab->size * 3)
+		return;
+	if ((htab->filled + 1) * 2 > htab->size)
+		nel = htab->size * 2;
+	hresize_r(htab, nel);
+}
+
 /*
  * hsearch()
  */
@@ -171,17 +264,19 @@ void hdestroy_r(struct hsearch_data *htab)
 /*
  * This is the search function. It uses double hashing with open addressing.
  * The argument item.key has to be a pointer to an zero terminated, most
- * probably strings of chars. The function for generating a number of the
- * strings is simple but fast. It can be replaced by a more complex function
- * like ajw (see [Aho,Sethi,Ullman]) if the needs are shown.
+ * probably strings of chars. The strings are hashed with hash_key().
  *
  * We use an trick to speed up the lookup. The table is created by hcreate
  * with one more element available. This enables us to use the index zero
  * special. This index will never be used because we store the first hash
  * index in the field used where zero means not used. Every other value
- * means used. The used field can be used as a first fast comparison for
- * equality of the stored and the parameter value. This helps to prevent
- * unnecessary expensive calls of strcmp.
+ * means used. The used field, and then the full hash kept with each entry,
+ * can be used as a first fast comparison for equality of the stored and the
+ * parameter value. This helps to prevent unnecessary expensive calls of
+ * strcmp.
+ *
+ * The table is made larger when it is three quarters full, so it never
+ * fills up unless memory runs out.
  *
  * This implementation differs from the standard library version of
  * this function in a number of ways:
@@ -221,6 +316,39 @@ int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
 	return 0;
 }
 
+/*
+ * Ask whether a change may be made, and call the entry's callback. The table
+ * is kept where it is meanwhile, since these may set other variables while
+ * the caller still has the index of this entry.
+ */
+static int hchange_ok(struct hsearch_data *htab, const struct env_entry *ep,
+		      const char *newval, enum env_op op, int flag)
+{
+	int ret;
+
+	if (htab->change_ok == NULL)
+		return 0;
+	htab->busy++;
+	ret = htab->change_ok(ep, newval, op, flag);
+	htab->busy--;
+
+	return ret;
+}
+
+static int hcallback(struct hsearch_data *htab, const struct env_entry *ep,
+		     const char *newval, enum env_op op, int flag)
+{
+	int ret;
+
+	if (!ep->callback)
+		return 0;
+	htab->busy++;
+	ret = ep->callback(ep->key, newval, op, flag);
+	htab->busy--;
+
+	return ret;
+}
+
 /*
  * Compare an existing entry with the desired key, and overwrite if the action
  * is ENV_ENTER.  This is simply a helper function for hsearch_r().
@@ -228,16 +356,16 @@ int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
 static inline int _compare_and_overwrite_entry(struct env_entry item,
 		enum env_action action, struct env_entry **retval,
 		struct hsearch_data *htab, int flag, unsigned int hval,
-		unsigned int idx)
+		unsigned int hash, unsigned int idx, bool defer)
 {
-	if (htab->table[idx].used == hval
+	if (htab->table[idx].used == hval && htab->table[idx].hash == hash
 	    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
 		/* Overwrite existing value? */
 		if (action == ENV_ENTER && item.data) {
 			/* check for permission */
-			if (htab->change_ok != NULL && htab->change_ok(
-			    &htab->table[idx].entry, item.data,
-			    env_op_overwrite, flag)) {
+			if (!defer && hchange_ok(htab, &htab->table[idx].entry,
+						 item.data, env_op_overwrite,
+						 flag)) {
 				debug("change_ok() rejected setting variable "
 					"%s, skipping it!\n", item.key);
 				__set_errno(EPERM);
@@ -246,9 +374,9 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 			}
 
 			/* If there is a callback, call it */
-			if (htab->table[idx].entry.callback &&
-			    htab->table[idx].entry.callback(item.key,
-			    item.data, env_op_overwrite, flag)) {
+			if (!defer && hcallback(htab, &htab->table[idx].entry,
+						item.data, env_op_overwrite,
+						flag)) {
 				debug("callback() rejected setting variable "
 					"%s, skipping it!\n", item.key);
 				__set_errno(EINVAL);
@@ -272,31 +400,29 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 	return -1;
 }
 
-int hsearch_r(struct env_entry item, enum env_action action,
-	      struct env_entry **retval, struct hsearch_data *htab, int flag)
+/*
+ * With 'defer' set, a new entry is only added to the table: its callback
+ * and flags are not looked up, and neither change_ok() nor any callback is
+ * called, for it or for an existing entry which is overwritten. himport_r()
+ * does all that once the whole environment has been read.
+ */
+static int _hsearch_r(struct env_entry item, enum env_action action,
+		      struct env_entry **retval, struct hsearch_data *htab,
+		      int flag, bool defer)
 {
+	unsigned int hash;
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
 	unsigned int idx;
 	unsigned int first_deleted = 0;
 	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
+	if (action == ENV_ENTER)
+		hmake_room(htab);
 
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	hash = hash_key(item.key);
+
+	/* First hash function: simply take the modulus but prevent zero */
+	hval = first_index(htab, hash);
 
 	/* The first index tried. */
 	idx = hval;
@@ -306,32 +432,17 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		 * Further action might be required according to the
 		 * action value.
 		 */
-		unsigned hval2;
-
 		if (htab->table[idx].used == USED_DELETED
 		    && !first_deleted)
 			first_deleted = idx;
 
 		ret = _compare_and_overwrite_entry(item, action, retval, htab,
-			flag, hval, idx);
+			flag, hval, hash, idx, defer);
 		if (ret != -1)
 			return ret;
 
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
-
 		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
+			idx = next_index(htab, hval, idx);
 
 			/*
 			 * If we visited all entries leave the loop
@@ -346,7 +457,7 @@ int hsearch_r(struct env_entry item, enum env_action action,
 
 			/* If entry is found use it. */
 			ret = _compare_and_overwrite_entry(item, action, retval,
-				htab, flag, hval, idx);
+				htab, flag, hval, hash, idx, defer);
 			if (ret != -1)
 				return ret;
 		}
@@ -369,10 +480,13 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		 * Create new entry;
 		 * create copies of item.key and item.data
 		 */
-		if (first_deleted)
+		if (first_deleted) {
 			idx = first_deleted;
+			--htab->deleted;
+		}
 
 		htab->table[idx].used = hval;
+		htab->table[idx].hash = hash;
 		htab->table[idx].entry.key = strdup(item.key);
 		htab->table[idx].entry.data = strdup(item.data);
 		if (!htab->table[idx].entry.key ||
@@ -384,14 +498,19 @@ int hsearch_r(struct env_entry item, enum env_action action,
 
 		++htab->filled;
 
+		if (defer) {
+			*retval = &htab->table[idx].entry;
+			return idx;
+		}
+
 		/* This is a new entry, so look up a possible callback */
 		env_callback_init(&htab->table[idx].entry);
 		/* Also look for flags */
 		env_flags_init(&htab->table[idx].entry);
 
 		/* check for permission */
-		if (htab->change_ok != NULL && htab->change_ok(
-		    &htab->table[idx].entry, item.data, env_op_create, flag)) {
+		if (hchange_ok(htab, &htab->table[idx].entry, item.data,
+			       env_op_create, flag)) {
 			debug("change_ok() rejected setting variable "
 				"%s, skipping it!\n", item.key);
 			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
@@ -401,9 +520,8 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		}
 
 		/* If there is a callback, call it */
-		if (htab->table[idx].entry.callback &&
-		    htab->table[idx].entry.callback(item.key, item.data,
-		    env_op_create, flag)) {
+		if (hcallback(htab, &htab->table[idx].entry, item.data,
+			      env_op_create, flag)) {
 			debug("callback() rejected setting variable "
 				"%s, skipping it!\n", item.key);
 			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
@@ -422,6 +540,12 @@ int hsearch_r(struct env_entry item, enum env_action action,
 	return 0;
 }
 
+int hsearch_r(struct env_entry item, enum env_action action,
+	      struct env_entry **retval, struct hsearch_data *htab, int flag)
+{
+	return _hsearch_r(item, action, retval, htab, flag, false);
+}
+
 
 /*
  * hdelete()
@@ -445,6 +569,7 @@ static void _hdelete(const char *key, struct hsearch_data *htab,
 	htab->table[idx].used = USED_DELETED;
 
 	--htab->filled;
+	++htab->deleted;
 }
 
 int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
@@ -463,8 +588,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	}
 
 	/* Check for permission */
-	if (htab->change_ok != NULL &&
-	    htab->change_ok(ep, NULL, env_op_delete, flag)) {
+	if (hchange_ok(htab, ep, NULL, env_op_delete, flag)) {
 		debug("change_ok() rejected deleting variable "
 			"%s, skipping it!\n", key);
 		__set_errno(EPERM);
@@ -472,8 +596,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	}
 
 	/* If there is a callback, call it */
-	if (htab->table[idx].entry.callback &&
-	    htab->table[idx].entry.callback(key, NULL, env_op_delete, flag)) {
+	if (hcallback(htab, ep, NULL, env_op_delete, flag)) {
 		debug("callback() rejected deleting variable "
 			"%s, skipping it!\n", key);
 		__set_errno(EINVAL);
@@ -746,6 +869,25 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
 	return res;
 }
 
+/*
+ * Count the "name=value" entries in linearized data, or a little more when
+ * values contain escaped separators.
+ */
+static size_t himport_count(const char *data, size_t size, const char sep)
+{
+	const char *p = data, *end = data + size;
+	size_t count = 0;
+
+	while (p < end && *p) {
+		count++;
+		while (p < end && *p && *p != sep)
+			p++;
+		p++;
+	}
+
+	return count;
+}
+
 /*
  * Import linearized data into hash table.
  *
@@ -782,6 +924,11 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
  *
  * In theory, arbitrary separator characters can be used, but only
  * '\0' and '\n' have really been tested.
+ *
+ * When a whole new table is created, it is made large enough for all the
+ * data at once and the entries are only added to it while the data is read.
+ * Their callbacks and flags are then set up, and change_ok() and the
+ * callbacks called, in the order the entries were given.
  */
 
 int himport_r(struct hsearch_data *htab,
@@ -790,7 +937,10 @@ int himport_r(struct hsearch_data *htab,
 {
 	char *data, *sp, *dp, *name, *value;
 	char *localvars[nvars];
-	int i;
+	unsigned int *pending = NULL;
+	struct env_entry **entries = NULL;
+	size_t count = 0, npending = 0;
+	int i, j;
 
 	/* Test for correct arguments.  */
 	if (htab == NULL) {
@@ -836,6 +986,11 @@ int himport_r(struct hsearch_data *htab,
 	 * On the other hand we need to add some more entries for free
 	 * space when importing very small buffers. Both boundaries can
 	 * be overwritten in the board config file if needed.
+	 *
+	 * These only set the initial size: a bulk import makes room for
+	 * all of its entries from the start, even past
+	 * CONFIG_ENV_MAX_ENTRIES, and the table grows later on as
+	 * entries are added.
 	 */
 
 	if (!htab->table) {
@@ -844,9 +999,17 @@ int himport_r(struct hsearch_data *htab,
 		if (nent > CONFIG_ENV_MAX_ENTRIES)
 			nent = CONFIG_ENV_MAX_ENTRIES;
 
+		/* Bulk import, with room for every entry from the start */
+		count = himport_count(data, size, sep);
+		if (count)
+			pending = malloc(count * sizeof(*pending));
+		if (pending && nent < count * 2)
+			nent = count * 2;
+
 		debug("Create Hash Table: N=%d\n", nent);
 
 		if (hcreate_r(nent, htab) == 0) {
+			free(pending);
 			free(data);
 			return 0;
 		}
@@ -856,6 +1019,8 @@ int himport_r(struct hsearch_data *htab,
 		free(data);
 		return 1;		/* everything OK */
 	}
+	if (pending)
+		htab->busy++;	/* keep the pending indexes valid */
 	if(crlf_is_lf) {
 		/* Remove Carriage Returns in front of Line Feeds */
 		unsigned ignored_crs = 0;
@@ -900,9 +1065,26 @@ int himport_r(struct hsearch_data *htab,
 			if (!drop_var_from_set(name, nvars, localvars))
 				continue;
 
-			if (hdelete_r(name, htab, flag) == 0)
-				debug("DELETE ERROR ##############################\n");
+			if (!pending) {
+				if (hdelete_r(name, htab, flag) == 0)
+					debug("DELETE ERROR ##############################\n");
+				continue;
+			}
 
+			/*
+			 * Everything in a new table was added by this import
+			 * and has not been checked yet, so drop it quietly,
+			 * keeping the others in order
+			 */
+			e.key = name;
+			i = hsearch_r(e, ENV_FIND, &rv, htab, 0);
+			if (rv)
+				_hdelete(name, htab, rv, i);
+			for (i = 0, j = 0; i < npending; i++) {
+				if (htab->table[pending[i]].used > 0)
+					pending[j++] = pending[i];
+			}
+			npending = j;
 			continue;
 		}
 		*dp++ = '\0';	/* terminate name */
@@ -919,6 +1101,9 @@ int himport_r(struct hsearch_data *htab,
 		if (*name == 0) {
 			debug("INSERT: unable to use an empty key\n");
 			__set_errno(EINVAL);
+			if (pending)
+				htab->busy--;
+			free(pending);
 			free(data);
 			return 0;
 		}
@@ -931,7 +1116,16 @@ int himport_r(struct hsearch_data *htab,
 		e.key = name;
 		e.data = value;
 
-		hsearch_r(e, ENV_ENTER, &rv, htab, flag);
+		if (pending) {
+			unsigned int filled = htab->filled;
+			int idx;
+
+			idx = _hsearch_r(e, ENV_ENTER, &rv, htab, flag, true);
+			if (rv && htab->filled != filled && npending < count)
+				pending[npending++] = idx;
+		} else {
+			hsearch_r(e, ENV_ENTER, &rv, htab, flag);
+		}
 		if (rv == NULL)
 			printf("himport_r: can't insert \"%s=%s\" into hash table\n",
 				name, value);
@@ -944,6 +1138,42 @@ int himport_r(struct hsearch_data *htab,
 	debug("INSERT: free(data = %p)\n", data);
 	free(data);
 
+	/*
+	 * Finish adding the entries of a bulk import, looking up the
+	 * attributes of all of them in one go
+	 */
+	if (npending)
+		entries = calloc(npending, sizeof(*entries));
+	if (entries) {
+		for (i = 0; i < npending; i++)
+			entries[i] = &htab->table[pending[i]].entry;
+		if (env_callback_init_all(entries, npending) ||
+		    env_flags_init_all(entries, npending)) {
+			free(entries);
+			entries = NULL;
+		}
+	}
+	for (i = 0; i < npending; i++) {
+		struct env_entry *ep = &htab->table[pending[i]].entry;
+
+		if (htab->table[pending[i]].used <= 0)
+			continue;	/* deleted by a callback */
+		if (!entries) {
+			env_callback_init(ep);
+			env_flags_init(ep);
+		}
+		if (hchange_ok(htab, ep, ep->data, env_op_create, flag) ||
+		    hcallback(htab, ep, ep->data, env_op_create, flag)) {
+			printf("himport_r: can't insert \"%s=%s\" into hash table\n",
+			       ep->key, ep->data);
+			_hdelete(ep->key, htab, ep, pending[i]);
+		}
+	}
+	if (pending)
+		htab->busy--;
+	free(entries);
+	free(pending);
+
 	if (flag & H_NOCLEAR)
 		goto end;
 
@@ -5,9 +5,15 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <decomp_stream.h>
 #include <image.h>
+#include <lz4.h>
+#include <malloc.h>
+#include <mp_job.h>
+#include <asm/unaligned.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
+#include <linux/xxhash.h>
 
 static u16 LZ4_readLE16(const void *src) { return le16_to_cpu(*(u16 *)src); }
 static void LZ4_copy4(void *dst, const void *src) { *(u32 *)dst = *(u32 *)src; }
@@ -61,77 +67,317 @@ struct lz4_block_header {
 	/* + u32 block_checksum iff has_block_checksum is set */
 } __packed;
 
-int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+/* Smallest valid max_block_size, for 64KB blocks */
+#define LZ4_BLOCK_MAX_MIN	4
+
+/* Most blocks handed to the other cores at once */
+#define LZ4_MP_MAX_JOBS		16
+
+/* Checksums cost time, so they are only verified if asked for */
+static int lz4_check_xxh32(const void *data, size_t len, u32 checksum)
+{
+	if (!CONFIG_IS_ENABLED(LZ4_CHECKSUM))
+		return 0;
+
+	return xxh32(data, len, 0) == checksum ? 0 : -EBADMSG;
+}
+
+int lz4_frame_init(struct lz4_frame *f, const void *src, size_t src_len)
+{
+	/* With in-place decompression the header may become invalid later. */
+	const struct lz4_frame_header *h = src;
+	size_t len = sizeof(*h);
+	u8 checksum;
+
+	if (src_len < sizeof(*h))
+		return -EAGAIN;
+
+	/* We assume there's always only a single, standard frame. */
+	if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
+		return -EPROTONOSUPPORT;	/* unknown format */
+	if (h->reserved0 || h->reserved1 || h->reserved2)
+		return -EINVAL;	/* reserved must be zero */
+	if (h->max_block_size < LZ4_BLOCK_MAX_MIN)
+		return -EINVAL;
+
+	memset(f, '\0', sizeof(*f));
+	if (h->has_content_size) {
+		if (src_len < len + sizeof(u64))
+			return -EAGAIN;
+		f->content_size = get_unaligned_le64(src + len);
+		len += sizeof(u64);
+	}
+	if (src_len < len + sizeof(checksum))
+		return -EAGAIN;
+
+	/* The header checksum covers everything after the magic number */
+	checksum = *(u8 *)(src + len);
+	if (CONFIG_IS_ENABLED(LZ4_CHECKSUM) &&
+	    (u8)(xxh32(src + sizeof(h->magic), len - sizeof(h->magic), 0) >> 8)
+	    != checksum)
+		return -EBADMSG;
+	len += sizeof(checksum);
+
+	f->src = src;
+	f->src_len = src_len;
+	f->pos = len;
+	f->block_max = 1 << (2 * h->max_block_size + 8);
+	f->independent = h->independent_blocks;
+	f->has_block_checksum = h->has_block_checksum;
+	f->has_content_checksum = h->has_content_checksum;
+
+	return 0;
+}
+
+int lz4_frame_next(struct lz4_frame *f, struct lz4_block *blk)
+{
+	const void *in = f->src + f->pos;
+	size_t avail = f->src_len - f->pos;
+	struct lz4_block_header b;
+	size_t len;
+
+	if (f->done)
+		return 0;
+	if (avail < sizeof(b))
+		return -EAGAIN;
+	b.raw = get_unaligned_le32(in);
+	len = sizeof(b);
+
+	if (!b.size) {
+		if (f->has_content_checksum) {
+			if (avail < len + sizeof(u32))
+				return -EAGAIN;
+			f->content_checksum = get_unaligned_le32(in + len);
+			len += sizeof(u32);
+		}
+		f->pos += len;
+		f->done = true;
+
+		return 0;
+	}
+
+	if (b.size > f->block_max)
+		return -EPROTO;
+	len += b.size;
+	if (f->has_block_checksum)
+		len += sizeof(u32);
+	if (avail < len)
+		return -EAGAIN;
+
+	blk->data = in + sizeof(b);
+	blk->size = b.size;
+	blk->compressed = !b.not_compressed;
+	blk->checksum = 0;
+	if (f->has_block_checksum)
+		blk->checksum = get_unaligned_le32(blk->data + b.size);
+	blk->dst_offset = (size_t)f->blocks * f->block_max;
+	f->blocks++;
+	f->pos += len;
+
+	return 1;
+}
+
+int lz4_block_decode(const struct lz4_frame *f, const struct lz4_block *blk,
+		     void *dst, size_t offset, size_t dst_len)
 {
-	const void *end = dst + *dstn;
-	const void *in = src;
-	void *out = dst;
-	int has_block_checksum;
+	void *out = dst + offset;
+	size_t space;
 	int ret;
-	*dstn = 0;
-
-	{ /* With in-place decompression the header may become invalid later. */
-		const struct lz4_frame_header *h = in;
-
-		if (srcn < sizeof(*h) + sizeof(u64) + sizeof(u8))
-			return -EINVAL;	/* input overrun */
-
-		/* We assume there's always only a single, standard frame. */
-		if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
-			return -EPROTONOSUPPORT;	/* unknown format */
-		if (h->reserved0 || h->reserved1 || h->reserved2)
-			return -EINVAL;	/* reserved must be zero */
-		if (!h->independent_blocks)
-			return -EPROTONOSUPPORT; /* we can't support this yet */
-		has_block_checksum = h->has_block_checksum;
-
-		in += sizeof(*h);
-		if (h->has_content_size)
-			in += sizeof(u64);
-		in += sizeof(u8);
+
+	if (offset > dst_len)
+		return -ENOBUFS;
+	space = min_t(size_t, dst_len - offset, f->block_max);
+
+	/* Check the block before in-place decompression overwrites it */
+	if (f->has_block_checksum) {
+		ret = lz4_check_xxh32(blk->data, blk->size, blk->checksum);
+		if (ret)
+			return ret;
 	}
 
-	while (1) {
-		struct lz4_block_header b;
+	if (!blk->compressed) {
+		if (blk->size > space)
+			return -ENOBUFS;	/* output overrun */
+		memmove(out, blk->data, blk->size);
+
+		return blk->size;
+	}
+
+	/*
+	 * constant folding essential, do not touch params! Linked blocks may
+	 * refer back as far as the start of the output.
+	 */
+	ret = LZ4_decompress_generic(blk->data, out, blk->size, space,
+				     endOnInputSize, full, 0, noDict,
+				     f->independent ? out : dst, NULL, 0);
+	if (ret < 0)
+		return -EPROTO;	/* decompression error */
+
+	return ret;
+}
+
+int lz4_frame_check(const struct lz4_frame *f, const void *dst, size_t len)
+{
+	if (f->content_size && f->content_size != len)
+		return -EPROTO;
+	if (f->has_content_checksum)
+		return lz4_check_xxh32(dst, len, f->content_checksum);
+
+	return 0;
+}
 
-		b.raw = le32_to_cpu(*(u32 *)in);
-		in += sizeof(struct lz4_block_header);
+/* Progress of an lz4 stream, in decomp_stream.state */
+#define LZ4_STREAM_STARTED		BIT(0)	/* Frame header read */
 
-		if (in - src + b.size > srcn) {
-			ret = -EINVAL;		/* input overrun */
+int lz4_stream_init(struct decomp_stream *ds)
+{
+	ds->priv = malloc(sizeof(struct lz4_frame));
+	if (!ds->priv)
+		return -ENOMEM;
+	ds->state = 0;
+
+	return 0;
+}
+
+int lz4_stream_feed(struct decomp_stream *ds)
+{
+	struct lz4_frame *f = ds->priv;
+	struct lz4_block blk;
+	int ret;
+
+	if (!(ds->state & LZ4_STREAM_STARTED)) {
+		ret = lz4_frame_init(f, ds->src, ds->src_len);
+		if (ret == -EAGAIN)
+			return 0;	/* wait for more input */
+		if (ret)
+			return ret;
+		ds->state |= LZ4_STREAM_STARTED;
+	}
+	f->src_len = ds->src_len;
+
+	/* Only decode a block once all of it has arrived */
+	while (!ds->done) {
+		ret = lz4_frame_next(f, &blk);
+		if (ret == -EAGAIN)
 			break;
+		if (ret < 0)
+			return ret;
+		if (!ret) {
+			ret = lz4_frame_check(f, ds->dst, ds->out);
+			if (ret)
+				return ret;
+			ds->done = true;	/* decompression successful */
+		} else {
+			ret = lz4_block_decode(f, &blk, ds->dst, ds->out,
+					       ds->dst_len);
+			if (ret < 0)
+				return ret;
+			ds->out += ret;
 		}
+		ds->used = f->pos;
+	}
+
+	return 0;
+}
+
+void lz4_stream_finish(struct decomp_stream *ds)
+{
+	free(ds->priv);
+}
+
+struct lz4_block_job {
+	const struct lz4_frame *f;
+	struct lz4_block blk;
+	void *dst;
+	size_t dst_len;
+	int out;
+};
+
+static int lz4_block_job(void *arg)
+{
+	struct lz4_block_job *bj = arg;
+
+	bj->out = lz4_block_decode(bj->f, &bj->blk, bj->dst, bj->blk.dst_offset,
+				   bj->dst_len);
 
-		if (!b.size) {
-			ret = 0;	/* decompression successful */
+	return bj->out < 0 ? bj->out : 0;
+}
+
+int lz4_frame_decode_mp(struct lz4_frame *f, void *dst, size_t dst_len,
+			size_t *out_lenp)
+{
+	struct lz4_block_job bj[LZ4_MP_MAX_JOBS];
+	struct mp_job jobs[LZ4_MP_MAX_JOBS];
+	size_t out = 0;
+	int count, ret, i;
+
+	do {
+		for (count = 0; count < LZ4_MP_MAX_JOBS; count++) {
+			ret = lz4_frame_next(f, &bj[count].blk);
+			if (ret <= 0)
+				break;
+			bj[count].f = f;
+			bj[count].dst = dst;
+			bj[count].dst_len = dst_len;
+			jobs[count].func = lz4_block_job;
+			jobs[count].arg = &bj[count];
+		}
+		if (ret < 0)
+			return ret == -EAGAIN ? -EINVAL : ret;	/* input overrun */
+		if (!count)
 			break;
+
+		/*
+		 * A block after a short one was decoded at the wrong offset,
+		 * so its result, even an error, means nothing
+		 */
+		mp_job_run(jobs, count);
+		for (i = 0; i < count; i++) {
+			if (bj[i].blk.dst_offset != out)
+				return -EAGAIN;	/* an earlier block was short */
+			if (bj[i].out < 0)
+				return bj[i].out;
+			out += bj[i].out;
 		}
+	} while (!f->done);
+	*out_lenp = out;
 
-		if (b.not_compressed) {
-			size_t size = min((ptrdiff_t)b.size, end - out);
-			memcpy(out, in, size);
-			out += size;
-			if (size < b.size) {
-				ret = -ENOBUFS;	/* output overrun */
-				break;
-			}
-		} else {
-			/* constant folding essential, do not touch params! */
-			ret = LZ4_decompress_generic(in, out, b.size,
-					end - out, endOnInputSize,
-					full, 0, noDict, out, NULL, 0);
-			if (ret < 0) {
-				ret = -EPROTO;	/* decompression error */
-				break;
-			}
-			out += ret;
+	return lz4_frame_check(f, dst, out);
+}
+
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	struct lz4_frame f;
+	struct lz4_block blk;
+	size_t out = 0;
+	int ret;
+
+	ret = lz4_frame_init(&f, src, srcn);
+	if (ret)
+		return ret == -EAGAIN ? -EINVAL : ret;	/* input overrun */
+
+	/* In-place decompression needs the blocks to be decoded in order */
+	if (f.independent && mp_job_cores() > 1 &&
+	    (dst >= src + srcn || dst + *dstn <= src)) {
+		ret = lz4_frame_decode_mp(&f, dst, *dstn, &out);
+		if (ret != -EAGAIN) {
+			*dstn = out;
+			return ret;
 		}
+		lz4_frame_init(&f, src, srcn);
+	}
 
-		in += b.size;
-		if (has_block_checksum)
-			in += sizeof(u32);
+	while ((ret = lz4_frame_next(&f, &blk)) > 0) {
+		ret = lz4_block_decode(&f, &blk, dst, out, *dstn);
+		if (ret < 0)
+			break;
+		out += ret;
 	}
+	if (ret == -EAGAIN)
+		ret = -EINVAL;		/* input overrun */
+	else if (!ret)
+		ret = lz4_frame_check(&f, dst, out);
+	*dstn = out;
 
-	*dstn = out - dst;
 	return ret;
 }
@@ -30,6 +30,7 @@
 #include "LzmaTools.h"
 #include "LzmaDec.h"
 
+#include <decomp_stream.h>
 #include <linux/string.h>
 #include <malloc.h>
 
@@ -120,4 +121,96 @@ int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
     return res;
 }
 
+/* A stream decoded straight into the output buffer, used as the dictionary */
+struct lzma_stream {
+    CLzmaDec dec;
+    SizeT outSizeFull;  /* From the header, (SizeT)-1 if unknown */
+    ISzAlloc alloc;
+};
+
+int lzma_stream_init(struct decomp_stream *ds)
+{
+    struct lzma_stream *ls;
+
+    ls = calloc(1, sizeof(*ls));
+    if (!ls)
+        return -ENOMEM;
+    ls->alloc.Alloc = SzAlloc;
+    ls->alloc.Free = SzFree;
+    LzmaDec_Construct(&ls->dec);
+    ds->priv = ls;
+
+    return 0;
+}
+
+/* Read the properties and size, as lzmaBuffToBuffDecompress() does */
+static int lzma_stream_header(struct decomp_stream *ds, struct lzma_stream *ls)
+{
+    const unsigned char *inStream = ds->src;
+    UInt64 outSize = 0;
+    int i;
+
+    for (i = 0; i < 8; i++)
+        outSize |= (UInt64)inStream[LZMA_SIZE_OFFSET + i] << (i * 8);
+    if (outSize == (UInt64)-1)
+        ls->outSizeFull = (SizeT)-1;
+    else if ((SizeT)outSize != outSize)
+        return -EFBIG;
+    else
+        ls->outSizeFull = outSize;
+
+    if (LzmaDec_AllocateProbs(&ls->dec, inStream, LZMA_PROPS_SIZE,
+                              &ls->alloc) != SZ_OK)
+        return -ENOMEM;
+    ls->dec.dic = ds->dst;
+    ls->dec.dicBufSize = ds->dst_len;
+    LzmaDec_Init(&ls->dec);
+    ds->used = LZMA_DATA_OFFSET;
+    ds->state = 1;
+
+    return 0;
+}
+
+int lzma_stream_feed(struct decomp_stream *ds)
+{
+    struct lzma_stream *ls = ds->priv;
+    ELzmaStatus status;
+    SizeT dicLimit;
+    SizeT inLen;
+    int ret;
+
+    if (!ds->state) {
+        if (ds->src_len < LZMA_DATA_OFFSET)
+            return 0;
+        ret = lzma_stream_header(ds, ls);
+        if (ret)
+            return ret;
+    }
+
+    /* Partial input is held in the decoder, so everything is consumed */
+    dicLimit = min(ls->outSizeFull, (SizeT)ds->dst_len);
+    inLen = ds->src_len - ds->used;
+    if (LzmaDec_DecodeToDic(&ls->dec, dicLimit, ds->src + ds->used, &inLen,
+                            LZMA_FINISH_ANY, &status) != SZ_OK)
+        return -EPROTO;
+    ds->used += inLen;
+    ds->out = ls->dec.dicPos;
+
+    if (status == LZMA_STATUS_FINISHED_WITH_MARK ||
+        ds->out == ls->outSizeFull)
+        ds->done = true;
+    else if (ds->out == ds->dst_len)
+        return -ENOBUFS;
+
+    return 0;
+}
+
+void lzma_stream_finish(struct decomp_stream *ds)
+{
+    struct lzma_stream *ls = ds->priv;
+
+    LzmaDec_FreeProbs(&ls->dec, &ls->alloc);
+    free(ls);
+}
+
 #endif
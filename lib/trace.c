@@ -4,6 +4,7 @@
  */
 
 #include <common.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <trace.h>
 #include <asm/io.h>
@@ -32,6 +33,11 @@ struct trace_hdr {
 	ulong ftrace_size;	/* Num. of ftrace records we have space for */
 	ulong ftrace_count;	/* Num. of ftrace records written */
 	ulong ftrace_too_deep_count;	/* Functions that were too deep */
+	ulong ftrace_outside_count;	/* Functions outside the time window */
+
+	/* Time window to record calls in (timer_get_us()), end 0 for none */
+	ulong window_start;
+	ulong window_end;
 
 	int depth;
 	int depth_limit;
@@ -102,16 +108,30 @@ static void __attribute__((no_instrument_function)) trace_swap_gd(void)
 static void __attribute__((no_instrument_function)) add_ftrace(void *func_ptr,
 				void *caller, ulong flags)
 {
+	bool windowed = hdr->window_start || hdr->window_end;
+	ulong now = 0;
+
 	if (hdr->depth > hdr->depth_limit) {
 		hdr->ftrace_too_deep_count++;
 		return;
 	}
+	/* Only read the timer when the call needs it, it may be slow */
+	if (windowed) {
+		now = timer_get_us();
+		if (now < hdr->window_start ||
+		    (hdr->window_end && now >= hdr->window_end)) {
+			hdr->ftrace_outside_count++;
+			return;
+		}
+	}
 	if (hdr->ftrace_count < hdr->ftrace_size) {
 		struct trace_call *rec = &hdr->ftrace[hdr->ftrace_count];
 
+		if (!windowed)
+			now = timer_get_us();
 		rec->func = func_ptr_to_num(func_ptr);
 		rec->caller = func_ptr_to_num(caller);
-		rec->flags = flags | (timer_get_us() & FUNCF_TIMESTAMP_MASK);
+		rec->flags = flags | (now & FUNCF_TIMESTAMP_MASK);
 	}
 	hdr->ftrace_count++;
 }
@@ -280,6 +300,292 @@ int trace_list_calls(void *buff, size_t buff_size, size_t *needed)
 	return 0;
 }
 
+/*
+ * A node in the call tree. There is one node for each distinct chain of calls
+ * leading to a function, so a function called from two places has two nodes.
+ * Node 0 is the root, standing for whatever was running before the trace
+ * started.
+ */
+struct trace_node {
+	uint32_t func;		/* Function offset (in FUNC_SITE_SIZE units) */
+	int parent;		/* Index of the caller's node */
+	int child;		/* Index of the first callee's node, or 0 */
+	int sibling;		/* Index of the caller's next callee, or 0 */
+	ulong calls;		/* Number of calls */
+	uint32_t start;		/* Timestamp of the call in progress */
+	u64 child_us;		/* Time in callees during the call in progress */
+	u64 incl_us;		/* Total time in the function and its callees */
+	u64 excl_us;		/* Total time in the function itself */
+};
+
+struct trace_tree {
+	struct trace_node *node;
+	int count;		/* Number of nodes in use */
+	int size;		/* Number of nodes allocated */
+};
+
+static int trace_tree_child(struct trace_tree *tree, int parent, uint32_t func)
+{
+	struct trace_node *node;
+	int i;
+
+	for (i = tree->node[parent].child; i; i = tree->node[i].sibling) {
+		if (tree->node[i].func == func)
+			return i;
+	}
+	if (tree->count == tree->size) {
+		node = realloc(tree->node, tree->size * 2 * sizeof(*node));
+		if (!node)
+			return -ENOMEM;
+		tree->node = node;
+		tree->size *= 2;
+	}
+	i = tree->count++;
+	node = &tree->node[i];
+	memset(node, '\0', sizeof(*node));
+	node->func = func;
+	node->parent = parent;
+	node->sibling = tree->node[parent].child;
+	tree->node[parent].child = i;
+
+	return i;
+}
+
+/* Finish the call in progress at node @i, returning the caller's node */
+static int trace_tree_exit(struct trace_tree *tree, int i, uint32_t timestamp)
+{
+	struct trace_node *node = &tree->node[i];
+	u64 us = (timestamp - node->start) & FUNCF_TIMESTAMP_MASK;
+
+	node->incl_us += us;
+	node->excl_us += us > node->child_us ? us - node->child_us : 0;
+	tree->node[node->parent].child_us += us;
+
+	return node->parent;
+}
+
+/**
+ * trace_tree_build() - Build a call tree from the function call trace
+ *
+ * Timestamps only have 30 bits, so a call must not take more than about 17
+ * minutes. Exits without a matching entry (e.g. when the trace starts part
+ * way down the stack) are ignored, and calls still in progress at the end of
+ * the trace finish with the last record.
+ *
+ * @tree:	Returns the tree, which the caller must free
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+static int trace_tree_build(struct trace_tree *tree)
+{
+	uint32_t timestamp = 0;
+	size_t rec, count;
+	int cur = 0;
+	int i;
+
+	tree->size = 256;
+	tree->count = 1;
+	tree->node = calloc(tree->size, sizeof(*tree->node));
+	if (!tree->node)
+		return -ENOMEM;
+
+	count = min(hdr->ftrace_count, hdr->ftrace_size);
+	for (rec = 0; rec < count; rec++) {
+		struct trace_call *call = &hdr->ftrace[rec];
+
+		timestamp = call->flags & FUNCF_TIMESTAMP_MASK;
+		switch (TRACE_CALL_TYPE(call)) {
+		case FUNCF_ENTRY:
+			i = trace_tree_child(tree, cur, call->func);
+			if (i < 0) {
+				free(tree->node);
+				return i;
+			}
+			tree->node[i].calls++;
+			tree->node[i].start = timestamp;
+			tree->node[i].child_us = 0;
+			cur = i;
+			break;
+		case FUNCF_EXIT:
+			/* Records for callees may have been dropped */
+			for (i = cur; i && tree->node[i].func != call->func;)
+				i = tree->node[i].parent;
+			if (!i)
+				break;
+			do {
+				cur = trace_tree_exit(tree, cur, timestamp);
+			} while (cur != tree->node[i].parent);
+			break;
+		}
+	}
+	while (cur)
+		cur = trace_tree_exit(tree, cur, timestamp);
+
+	return 0;
+}
+
+static ulong trace_func_addr(uint32_t func)
+{
+	return CONFIG_SYS_TEXT_BASE + func * FUNC_SITE_SIZE;
+}
+
+struct trace_text {
+	char *ptr;		/* Next byte to write */
+	char *end;		/* End of the buffer, NULL if none */
+	size_t len;		/* Number of bytes needed so far */
+};
+
+static void trace_text_add(struct trace_text *text, const char *str)
+{
+	size_t len = strlen(str);
+
+	if (text->ptr && text->ptr + len <= text->end) {
+		memcpy(text->ptr, str, len);
+		text->ptr += len;
+	} else {
+		text->ptr = NULL;
+	}
+	text->len += len;
+}
+
+static void trace_text_add_stack(struct trace_text *text,
+				 struct trace_tree *tree, int i)
+{
+	struct trace_node *node = &tree->node[i];
+	char str[20];
+
+	if (node->parent) {
+		trace_text_add_stack(text, tree, node->parent);
+		trace_text_add(text, ";");
+	}
+	snprintf(str, sizeof(str), "%lx", trace_func_addr(node->func));
+	trace_text_add(text, str);
+}
+
+int trace_list_folded(void *buff, size_t buff_size, size_t *needed)
+{
+	struct trace_text text;
+	struct trace_tree tree;
+	char str[24];
+	int was_enabled = trace_enabled;
+	int ret;
+	int i;
+
+	*needed = 0;
+	/* Don't trace ourselves, since this may take a while */
+	trace_enabled = 0;
+	ret = trace_tree_build(&tree);
+	if (ret)
+		goto out;
+
+	text.ptr = buff;
+	text.end = buff ? buff + buff_size : NULL;
+	text.len = 0;
+	for (i = 1; i < tree.count; i++) {
+		if (!tree.node[i].excl_us)
+			continue;
+		trace_text_add_stack(&text, &tree, i);
+		snprintf(str, sizeof(str), " %llu\n", tree.node[i].excl_us);
+		trace_text_add(&text, str);
+	}
+	free(tree.node);
+
+	*needed = text.len;
+	if (text.len > buff_size)
+		ret = -ENOSPC;
+out:
+	trace_enabled = was_enabled;
+
+	return ret;
+}
+
+/* Time spent in a function, totalled over all the places it is called from */
+struct trace_func_time {
+	uint32_t func;
+	ulong calls;
+	u64 incl_us;
+	u64 excl_us;
+};
+
+static int trace_cmp_func(const void *v1, const void *v2)
+{
+	const struct trace_func_time *f1 = v1, *f2 = v2;
+
+	return f1->func < f2->func ? -1 : f1->func > f2->func;
+}
+
+static int trace_cmp_excl(const void *v1, const void *v2)
+{
+	const struct trace_func_time *f1 = v1, *f2 = v2;
+
+	return f1->excl_us < f2->excl_us ? 1 : -(f1->excl_us > f2->excl_us);
+}
+
+int trace_print_hot(int count)
+{
+	struct trace_func_time *ft;
+	struct trace_tree tree;
+	int was_enabled = trace_enabled;
+	int nfuncs, ret;
+	int i, j;
+
+	if (!trace_inited) {
+		printf("Trace is disabled\n");
+		return -ENOENT;
+	}
+	trace_enabled = 0;
+	ret = trace_tree_build(&tree);
+	if (ret)
+		goto out;
+	ft = calloc(tree.count, sizeof(*ft));
+	if (!ft) {
+		free(tree.node);
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	/*
+	 * Add up the nodes for each function. The inclusive time of a
+	 * recursive call is already part of that of the outer call.
+	 */
+	for (i = 1; i < tree.count; i++) {
+		struct trace_node *node = &tree.node[i];
+
+		ft[i].func = node->func;
+		ft[i].calls = node->calls;
+		ft[i].excl_us = node->excl_us;
+		for (j = node->parent; j; j = tree.node[j].parent) {
+			if (tree.node[j].func == node->func)
+				break;
+		}
+		if (!j)
+			ft[i].incl_us = node->incl_us;
+	}
+	qsort(ft + 1, tree.count - 1, sizeof(*ft), trace_cmp_func);
+	for (i = 1, nfuncs = 0; i < tree.count; i++) {
+		if (nfuncs && ft[nfuncs - 1].func == ft[i].func) {
+			ft[nfuncs - 1].calls += ft[i].calls;
+			ft[nfuncs - 1].incl_us += ft[i].incl_us;
+			ft[nfuncs - 1].excl_us += ft[i].excl_us;
+		} else {
+			ft[nfuncs++] = ft[i];
+		}
+	}
+	qsort(ft, nfuncs, sizeof(*ft), trace_cmp_excl);
+
+	printf("%10s %15s %15s  %s\n", "calls", "inclusive us", "exclusive us",
+	       "function");
+	for (i = 0; i < min(count, nfuncs); i++) {
+		printf("%10lu %15llu %15llu  %lx\n", ft[i].calls, ft[i].incl_us,
+		       ft[i].excl_us, trace_func_addr(ft[i].func));
+	}
+	free(ft);
+	free(tree.node);
+out:
+	trace_enabled = was_enabled;
+
+	return ret;
+}
+
 /* Print basic information about tracing */
 void trace_print_stats(void)
 {
@@ -311,6 +617,13 @@ void trace_print_stats(void)
 	printf("%15d call depth limit\n", hdr->depth_limit);
 	print_grouped_ull(hdr->ftrace_too_deep_count, 10);
 	puts(" calls not traced due to depth\n");
+	if (hdr->window_start || hdr->window_end) {
+		print_grouped_ull(hdr->ftrace_outside_count, 10);
+		printf(" calls not traced outside %lu..", hdr->window_start);
+		if (hdr->window_end)
+			printf("%lu", hdr->window_end);
+		puts(" us\n");
+	}
 }
 
 void __attribute__((no_instrument_function)) trace_set_enabled(int enabled)
@@ -318,6 +631,15 @@ void __attribute__((no_instrument_function)) trace_set_enabled(int enabled)
 	trace_enabled = enabled != 0;
 }
 
+void __attribute__((no_instrument_function)) trace_set_window(
+		ulong start_us, ulong end_us)
+{
+	if (hdr) {
+		hdr->window_start = start_us;
+		hdr->window_end = end_us;
+	}
+}
+
 /**
  * Init the tracing system ready for used, and enable it
  *
@@ -377,6 +699,8 @@ int __attribute__((no_instrument_function)) trace_init(void *buff,
 
 	puts("trace: enabled\n");
 	hdr->depth_limit = CONFIG_TRACE_CALL_DEPTH_LIMIT;
+	if (was_disabled)
+		trace_set_window(CONFIG_TRACE_WINDOW_START, CONFIG_TRACE_WINDOW_END);
 	trace_enabled = 1;
 	trace_inited = 1;
 
@@ -411,6 +735,7 @@ int __attribute__((no_instrument_function)) trace_early_init(void)
 	hdr->ftrace_size = (buff_size - needed) / sizeof(*hdr->ftrace);
 	add_textbase();
 	hdr->depth_limit = CONFIG_TRACE_EARLY_CALL_DEPTH_LIMIT;
+	trace_set_window(CONFIG_TRACE_WINDOW_START, CONFIG_TRACE_WINDOW_END);
 	printf("trace: early enable at %08x\n", CONFIG_TRACE_EARLY_ADDR);
 
 	trace_enabled = 1;
@@ -1066,7 +1066,7 @@ size_t ZSTD_execSequence(BYTE *op, BYTE *const oend, seq_t sequence, const BYTE
 	op += 8;
 	match += 8;
 
-	if (oMatchEnd > oend - (16 - MINMATCH)) {
+	if (oMatchEnd > oend - (WILDCOPY_OVERLENGTH + 8 - MINMATCH)) {
 		if (op < oend_w) {
 			ZSTD_wildcopy(op, match, oend_w - op);
 			match += oend_w - op;
@@ -1321,7 +1321,7 @@ size_t ZSTD_execSequenceLong(BYTE *op, BYTE *const oend, seq_t sequence, const B
 	op += 8;
 	match += 8;
 
-	if (oMatchEnd > oend - (16 - MINMATCH)) {
+	if (oMatchEnd > oend - (WILDCOPY_OVERLENGTH + 8 - MINMATCH)) {
 		if (op < oend_w) {
 			ZSTD_wildcopy(op, match, oend_w - op);
 			match += oend_w - op;
@@ -14,6 +14,9 @@
 #include <compiler.h>
 #include <linux/string.h> /* memcpy */
 #include <linux/types.h>  /* size_t, ptrdiff_t */
+#if CONFIG_IS_ENABLED(ZSTD_NEON)
+#include <arm_neon.h>
+#endif
 
 /*-****************************************
 *  Compiler specifics
@@ -51,7 +54,16 @@ ZSTD_STATIC U16 ZSTD_read16(const void *memPtr) { return get_unaligned((const U1
 
 ZSTD_STATIC U32 ZSTD_read32(const void *memPtr) { return get_unaligned((const U32 *)memPtr); }
 
+#if CONFIG_IS_ENABLED(ZSTD_NEON)
+/*
+ * U-Boot is built with -mstrict-align, so get_unaligned() reads a byte at a
+ * time. vld1_u8() is emitted as an LDR of a D register, which may be
+ * unaligned on Normal memory, so load the bit container that way instead.
+ */
+ZSTD_STATIC U64 ZSTD_read64(const void *memPtr) { return vget_lane_u64(vreinterpret_u64_u8(vld1_u8((const BYTE *)memPtr)), 0); }
+#else
 ZSTD_STATIC U64 ZSTD_read64(const void *memPtr) { return get_unaligned((const U64 *)memPtr); }
+#endif
 
 ZSTD_STATIC size_t ZSTD_readST(const void *memPtr) { return get_unaligned((const size_t *)memPtr); }
 
@@ -79,7 +91,13 @@ ZSTD_STATIC U32 ZSTD_readLE32(const void *memPtr) { return get_unaligned_le32(me
 
 ZSTD_STATIC void ZSTD_writeLE32(void *memPtr, U32 val32) { put_unaligned_le32(val32, memPtr); }
 
-ZSTD_STATIC U64 ZSTD_readLE64(const void *memPtr) { return get_unaligned_le64(memPtr); }
+ZSTD_STATIC U64 ZSTD_readLE64(const void *memPtr)
+{
+	if (ZSTD_isLittleEndian())
+		return ZSTD_read64(memPtr);
+	else
+		return get_unaligned_le64(memPtr);
+}
 
 ZSTD_STATIC void ZSTD_writeLE64(void *memPtr, U64 val64) { put_unaligned_le64(val64, memPtr); }
 
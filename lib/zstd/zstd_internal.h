@@ -116,12 +116,29 @@ static const U32 OF_defaultNormLog = OF_DEFAULTNORMLOG;
 /*-*******************************************
 *  Shared functions to include for inlining
 *********************************************/
+#if CONFIG_IS_ENABLED(ZSTD_NEON)
+/*
+ * With -mstrict-align, memcpy() of unknown alignment is done a byte at a time.
+ * These become LDR/STR of D and Q registers, which may be unaligned on Normal
+ * memory.
+ */
+ZSTD_STATIC void ZSTD_copy8(void *dst, const void *src) {
+	vst1_u8((BYTE *)dst, vld1_u8((const BYTE *)src));
+}
+ZSTD_STATIC void ZSTD_copy16(void *dst, const void *src) {
+	vst1q_u8((BYTE *)dst, vld1q_u8((const BYTE *)src));
+}
+/*! ZSTD_wildcopy() :
+*   custom version of memcpy(), can copy up to 15 bytes too many (8 bytes if length==0) */
+#define WILDCOPY_OVERLENGTH 16
+#else
 ZSTD_STATIC void ZSTD_copy8(void *dst, const void *src) {
 	memcpy(dst, src, 8);
 }
 /*! ZSTD_wildcopy() :
 *   custom version of memcpy(), can copy up to 7 bytes too many (8 bytes if length==0) */
 #define WILDCOPY_OVERLENGTH 8
+#endif
 ZSTD_STATIC void ZSTD_wildcopy(void *dst, const void *src, ptrdiff_t length)
 {
 	const BYTE* ip = (const BYTE*)src;
@@ -134,6 +151,17 @@ ZSTD_STATIC void ZSTD_wildcopy(void *dst, const void *src, ptrdiff_t length)
 	 */
 	if (length <= 8)
 		return ZSTD_copy8(dst, src);
+#if CONFIG_IS_ENABLED(ZSTD_NEON)
+	/* A match less than 16 bytes back overlaps each 16-byte copy */
+	if ((uPtrDiff)op - (uPtrDiff)ip >= 16) {
+		do {
+			ZSTD_copy16(op, ip);
+			op += 16;
+			ip += 16;
+		} while (op < oend);
+		return;
+	}
+#endif
 	do {
 		ZSTD_copy8(op, ip);
 		op += 8;
@@ -37,6 +37,26 @@ int		arp_wait_try;
 uchar	       *arp_tx_packet; /* THE ARP transmit packet */
 static uchar	arp_tx_packet_buf[PKTSIZE_ALIGN + PKTALIGN];
 
+#ifdef CONFIG_NET_ARP_CACHE
+/**
+ * struct arp_entry - A neighbour whose MAC address is known
+ *
+ * @ip:		IP address, 0 if the entry is free
+ * @ethaddr:	MAC address
+ * @time:	When the address was last confirmed, from get_timer()
+ */
+struct arp_entry {
+	struct in_addr ip;
+	uchar ethaddr[ARP_HLEN];
+	ulong time;
+};
+
+static struct arp_entry arp_cache[CONFIG_NET_ARP_CACHE_SIZE];
+/* Our own addresses when the entries were learnt */
+static struct in_addr arp_cache_ip;
+static uchar arp_cache_ethaddr[ARP_HLEN];
+#endif
+
 void arp_init(void)
 {
 	/* XXX problem with bss workaround */
@@ -48,6 +68,116 @@ void arp_init(void)
 	arp_tx_packet -= (ulong)arp_tx_packet % PKTALIGN;
 }
 
+/* Work out which address to ask for to reach @dest */
+static struct in_addr arp_next_hop(struct in_addr dest)
+{
+	if ((dest.s_addr & net_netmask.s_addr) !=
+	    (net_ip.s_addr & net_netmask.s_addr) && net_gateway.s_addr)
+		return net_gateway;
+
+	return dest;
+}
+
+#ifdef CONFIG_NET_ARP_CACHE
+void arp_cache_flush(void)
+{
+	memset(arp_cache, '\0', sizeof(arp_cache));
+}
+
+/* Forget everything if we have moved to another interface or address */
+static bool arp_cache_check_owner(void)
+{
+	if (arp_cache_ip.s_addr == net_ip.s_addr &&
+	    !memcmp(arp_cache_ethaddr, net_ethaddr, ARP_HLEN))
+		return true;
+
+	arp_cache_flush();
+	arp_cache_ip = net_ip;
+	memcpy(arp_cache_ethaddr, net_ethaddr, ARP_HLEN);
+
+	return false;
+}
+
+static struct arp_entry *arp_cache_find(struct in_addr ip)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NET_ARP_CACHE_SIZE; i++) {
+		if (arp_cache[i].ip.s_addr == ip.s_addr)
+			return &arp_cache[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * Record the MAC address of a neighbour, if it is already known or
+ * @create is true, replacing the oldest entry if the cache is full
+ */
+static void arp_cache_update(struct in_addr ip, const uchar *ethaddr,
+			     bool create)
+{
+	struct arp_entry *entry;
+	int i;
+
+	if (!ip.s_addr || ip.s_addr == 0xFFFFFFFF)
+		return;
+	arp_cache_check_owner();
+
+	entry = arp_cache_find(ip);
+	if (!entry) {
+		if (!create)
+			return;
+		entry = &arp_cache[0];
+		for (i = 0; i < CONFIG_NET_ARP_CACHE_SIZE; i++) {
+			if (!arp_cache[i].ip.s_addr) {
+				entry = &arp_cache[i];
+				break;
+			}
+			if (get_timer(arp_cache[i].time) > get_timer(entry->time))
+				entry = &arp_cache[i];
+		}
+		entry->ip = ip;
+	}
+	debug_cond(DEBUG_DEV_PKT, "ARP cache: %pI4 is %pM\n", &ip, ethaddr);
+	memcpy(entry->ethaddr, ethaddr, ARP_HLEN);
+	entry->time = get_timer(0);
+}
+
+bool arp_cache_lookup(struct in_addr dest, uchar *ethaddr)
+{
+	struct in_addr ip = arp_next_hop(dest);
+	struct arp_entry *entry;
+
+	if (!arp_cache_check_owner())
+		return false;
+	entry = arp_cache_find(ip);
+	if (!entry)
+		return false;
+	if (get_timer(entry->time) > CONFIG_NET_ARP_CACHE_TIMEOUT * 1000UL) {
+		entry->ip.s_addr = 0;
+		return false;
+	}
+	memcpy(ethaddr, entry->ethaddr, ARP_HLEN);
+
+	return true;
+}
+#else
+static inline void arp_cache_update(struct in_addr ip, const uchar *ethaddr,
+				    bool create)
+{
+}
+
+void arp_cache_flush(void)
+{
+}
+
+bool arp_cache_lookup(struct in_addr dest, uchar *ethaddr)
+{
+	return false;
+}
+#endif
+
 void arp_raw_request(struct in_addr source_ip, const uchar *target_ethaddr,
 	struct in_addr target_ip)
 {
@@ -81,16 +211,9 @@ void arp_raw_request(struct in_addr source_ip, const uchar *target_ethaddr,
 void arp_request(void)
 {
 	if ((net_arp_wait_packet_ip.s_addr & net_netmask.s_addr) !=
-	    (net_ip.s_addr & net_netmask.s_addr)) {
-		if (net_gateway.s_addr == 0) {
-			puts("## Warning: gatewayip needed but not set\n");
-			net_arp_wait_reply_ip = net_arp_wait_packet_ip;
-		} else {
-			net_arp_wait_reply_ip = net_gateway;
-		}
-	} else {
-		net_arp_wait_reply_ip = net_arp_wait_packet_ip;
-	}
+	    (net_ip.s_addr & net_netmask.s_addr) && net_gateway.s_addr == 0)
+		puts("## Warning: gatewayip needed but not set\n");
+	net_arp_wait_reply_ip = arp_next_hop(net_arp_wait_packet_ip);
 
 	arp_raw_request(net_ip, net_null_ethaddr, net_arp_wait_reply_ip);
 }
@@ -155,6 +278,14 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 	if (net_ip.s_addr == 0)
 		return;
 
+	/*
+	 * Any ARP packet, including a gratuitous one, refreshes the entry
+	 * for a neighbour we already know about
+	 */
+	arp_cache_update(net_read_ip(&arp->ar_spa), &arp->ar_sha,
+			 net_read_ip(&arp->ar_tpa).s_addr == net_ip.s_addr &&
+			 ntohs(arp->ar_op) == ARPOP_REQUEST);
+
 	if (net_read_ip(&arp->ar_tpa).s_addr != net_ip.s_addr)
 		return;
 
@@ -209,6 +340,7 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 				   arp->ar_data);
 
 			/* save address for later use */
+			arp_cache_update(reply_ip_addr, &arp->ar_sha, true);
 			if (arp_wait_packet_ethaddr != NULL)
 				memcpy(arp_wait_packet_ethaddr,
 				       &arp->ar_sha, ARP_HLEN);
@@ -235,6 +235,9 @@ static int on_ethaddr(const char *name, const char *value, enum env_op op,
 		}
 	}
 
+	/* neighbours may have learnt the old address */
+	arp_cache_flush();
+
 	return 0;
 }
 U_BOOT_ENV_CALLBACK(ethaddr, on_ethaddr);
@@ -352,6 +355,37 @@ int eth_send(void *packet, int length)
 	return ret;
 }
 
+/* Maximum number of packets processed by one call to eth_rx() */
+#define ETH_RX_MAX_PACKETS	32
+
+/*
+ * Drain a burst of packets from a driver which supports recv_batch(), so that
+ * the driver can hand back all the buffers in one go rather than once for
+ * every packet
+ */
+static int eth_rx_batch(struct udevice *current)
+{
+	struct eth_ops *ops = eth_get_ops(current);
+	uchar *packets[ETH_RX_MAX_PACKETS];
+	int lengths[ETH_RX_MAX_PACKETS];
+	int ret;
+	int i;
+
+	ret = ops->recv_batch(current, ETH_RECV_CHECK_DEVICE, packets, lengths,
+			      ETH_RX_MAX_PACKETS);
+	if (ret <= 0)
+		return ret;
+
+	for (i = 0; i < ret; i++) {
+		if (lengths[i] > 0)
+			net_process_received_packet(packets[i], lengths[i]);
+	}
+	if (ops->free_batch)
+		ops->free_batch(current, packets, lengths, ret);
+
+	return ret;
+}
+
 int eth_rx(void)
 {
 	struct udevice *current;
@@ -367,9 +401,14 @@ int eth_rx(void)
 	if (!eth_is_active(current))
 		return -EINVAL;
 
+	if (eth_get_ops(current)->recv_batch) {
+		ret = eth_rx_batch(current);
+		goto out;
+	}
+
 	/* Process up to 32 packets at one time */
 	flags = ETH_RECV_CHECK_DEVICE;
-	for (i = 0; i < 32; i++) {
+	for (i = 0; i < ETH_RX_MAX_PACKETS; i++) {
 		ret = eth_get_ops(current)->recv(current, flags, &packet);
 		flags = 0;
 		if (ret > 0)
@@ -379,6 +418,7 @@ int eth_rx(void)
 		if (ret <= 0)
 			break;
 	}
+out:
 	if (ret == -EAGAIN)
 		ret = 0;
 	if (ret < 0) {
@@ -388,6 +428,23 @@ int eth_rx(void)
 	return ret;
 }
 
+int eth_recv_into(uchar *buf)
+{
+	struct udevice *current;
+
+	current = eth_get_dev();
+	if (!current)
+		return -ENODEV;
+
+	if (!eth_is_active(current))
+		return -EINVAL;
+
+	if (!eth_get_ops(current)->recv_into)
+		return -ENOSYS;
+
+	return eth_get_ops(current)->recv_into(current, buf);
+}
+
 int eth_initialize(void)
 {
 	int num_devices = 0;
@@ -499,6 +556,12 @@ static int eth_post_probe(struct udevice *dev)
 			ops->recv += gd->reloc_off;
 		if (ops->free_pkt)
 			ops->free_pkt += gd->reloc_off;
+		if (ops->recv_batch)
+			ops->recv_batch += gd->reloc_off;
+		if (ops->free_batch)
+			ops->free_batch += gd->reloc_off;
+		if (ops->recv_into)
+			ops->recv_into += gd->reloc_off;
 		if (ops->stop)
 			ops->stop += gd->reloc_off;
 		if (ops->mcast)
@@ -127,6 +127,9 @@ static int on_ethaddr(const char *name, const char *value, enum env_op op,
 		dev = dev->next;
 	} while (dev != eth_devices);
 
+	/* neighbours may have learnt the old address */
+	arp_cache_flush();
+
 	return 0;
 }
 U_BOOT_ENV_CALLBACK(ethaddr, on_ethaddr);
@@ -374,6 +377,12 @@ int eth_rx(void)
 	return eth_current->recv(eth_current);
 }
 
+int eth_recv_into(uchar *buf)
+{
+	/* Legacy drivers always receive into their own buffers */
+	return -ENOSYS;
+}
+
 #ifdef CONFIG_API
 static void eth_save_packet(void *packet, int length)
 {
@@ -118,6 +118,12 @@
 #if defined(CONFIG_CMD_SNTP)
 #include "sntp.h"
 #endif
+#if defined(CONFIG_PROT_TCP)
+#include "tcp.h"
+#endif
+#if defined(CONFIG_CMD_WGET)
+#include "wget.h"
+#endif
 #if defined(CONFIG_CMD_WOL)
 #include "wol.h"
 #endif
@@ -180,6 +186,8 @@ bool net_boot_file_name_explicit;
 u32 net_boot_file_size;
 /* Boot file size in blocks as reported by the DHCP server */
 u32 net_boot_file_expected_size_in_blocks;
+/* Counters for the netstat command */
+struct net_stats net_stats;
 
 #if defined(CONFIG_CMD_SNTP)
 /* NTP server IP address */
@@ -191,6 +199,11 @@ int		net_ntp_time_offset;
 static uchar net_pkt_buf[(PKTBUFSRX+1) * PKTSIZE_ALIGN + PKTALIGN];
 /* Receive packets */
 uchar *net_rx_packets[PKTBUFSRX];
+/* Buffer the next packet is received into, see net_rx_direct() */
+static uchar *net_rx_direct_buf;
+/* Bytes overwritten by the headers of that packet */
+static uchar net_rx_direct_save[NET_RX_DIRECT_MAX_HDR];
+static int net_rx_direct_len;
 /* Current UDP RX packet handler */
 static rxhand_f *udp_packet_handler;
 /* Current ARP RX packet handler */
@@ -223,6 +236,7 @@ static int on_ipaddr(const char *name, const char *value, enum env_op op,
 		return 0;
 
 	net_ip = string_to_ip(value);
+	arp_cache_flush();
 
 	return 0;
 }
@@ -368,6 +382,7 @@ static void net_clear_handlers(void)
 static void net_cleanup_loop(void)
 {
 	net_clear_handlers();
+	net_rx_direct(NULL, 0);
 }
 
 void net_init(void)
@@ -530,6 +545,11 @@ restart:
 		case WOL:
 			wol_start();
 			break;
+#endif
+#if defined(CONFIG_CMD_WGET)
+		case WGET:
+			wget_start();
+			break;
 #endif
 		default:
 			break;
@@ -840,6 +860,9 @@ int net_send_ip_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 	/* if broadcast, make the ether address a broadcast and don't do ARP */
 	if (dest.s_addr == 0xFFFFFFFF)
 		ether = (uchar *)net_bcast_ethaddr;
+	/* otherwise the MAC address may be known from an earlier command */
+	else if (memcmp(ether, net_null_ethaddr, 6) == 0)
+		arp_cache_lookup(dest, ether);
 
 	pkt = (uchar *)net_tx_packet;
 
@@ -851,6 +874,14 @@ int net_send_ip_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 				   payload_len);
 		pkt_hdr_size = eth_hdr_size + IP_UDP_HDR_SIZE;
 		break;
+#if defined(CONFIG_PROT_TCP)
+	case IPPROTO_TCP:
+		pkt_hdr_size = eth_hdr_size +
+			tcp_set_tcp_header(pkt + eth_hdr_size, dest, dport,
+					   sport, payload_len, action,
+					   tcp_seq_num, tcp_ack_num);
+		break;
+#endif
 	default:
 		return -EINVAL;
 	}
@@ -904,37 +935,102 @@ struct hole {
 	u16 unused;
 };
 
+/*
+ * A datagram being reassembled, from the source, ID and protocol of its
+ * fragments. Each one has its own buffer, so fragments of several datagrams
+ * can arrive interleaved.
+ */
+struct ip_defrag {
+	bool busy;
+	struct in_addr src;
+	u16 id;			/* network order, as in the header */
+	u8 proto;
+	u16 first_hole, total_len;
+	ulong start;		/* time the first fragment arrived */
+	uchar pkt_buff[IP_PKTSIZE] __aligned(PKTALIGN);
+};
+
+static struct ip_defrag ip_defrag[CONFIG_NET_DEFRAG_SLOTS];
+
+/*
+ * Find the datagram @ip belongs to, or start a new one. Datagrams which have
+ * taken too long are given up on the way. If there is no room, the one
+ * started longest ago is given up for the new one.
+ */
+static struct ip_defrag *ip_defrag_find(struct ip_udp_hdr *ip)
+{
+	struct in_addr src = net_read_ip(&ip->ip_src);
+	struct ip_defrag *d, *found = NULL, *oldest = NULL;
+	ulong now = get_timer(0);
+	struct hole *payload;
+
+	for (d = ip_defrag; d < ip_defrag + ARRAY_SIZE(ip_defrag); d++) {
+		if (d->busy && now - d->start > CONFIG_NET_DEFRAG_TIMEOUT) {
+			d->busy = false;
+			net_stats.frag_timed_out++;
+		}
+		if (d->busy && d->id == ip->ip_id && d->proto == ip->ip_p &&
+		    d->src.s_addr == src.s_addr)
+			found = d;
+		/* prefer a free slot, then the datagram started first */
+		if (!oldest || (oldest->busy && (!d->busy ||
+		    now - d->start > now - oldest->start)))
+			oldest = d;
+	}
+	if (found)
+		return found;
+
+	d = oldest;
+	if (d->busy)
+		net_stats.frag_dropped++;
+	d->busy = true;
+	d->src = src;
+	d->id = ip->ip_id;
+	d->proto = ip->ip_p;
+	d->start = now;
+	d->total_len = 0xffff;
+	d->first_hole = 0;
+	payload = (struct hole *)(d->pkt_buff + IP_HDR_SIZE);
+	payload[0].last_byte = ~0;
+	payload[0].next_hole = 0;
+	payload[0].prev_hole = 0;
+	/* any IP header will work, copy the first we received */
+	memcpy(d->pkt_buff, ip, IP_HDR_SIZE);
+
+	return d;
+}
+
 static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 {
-	static uchar pkt_buff[IP_PKTSIZE] __aligned(PKTALIGN);
-	static u16 first_hole, total_len;
+	struct ip_defrag *d;
 	struct hole *payload, *thisfrag, *h, *newh;
-	struct ip_udp_hdr *localip = (struct ip_udp_hdr *)pkt_buff;
+	struct ip_udp_hdr *localip;
 	uchar *indata = (uchar *)ip;
 	int offset8, start, len, done = 0;
 	u16 ip_off = ntohs(ip->ip_off);
+	bool first;
 
-	/* payload starts after IP header, this fragment is in there */
-	payload = (struct hole *)(pkt_buff + IP_HDR_SIZE);
+	net_stats.frag_rx++;
 	offset8 =  (ip_off & IP_OFFS);
-	thisfrag = payload + offset8;
 	start = offset8 * 8;
 	len = ntohs(ip->ip_len) - IP_HDR_SIZE;
 
-	if (start + len > IP_MAXUDP) /* fragment extends too far */
+	/*
+	 * Fragments other than the last carry a multiple of 8 bytes, which
+	 * also keeps the hole descriptors after them in the buffer
+	 */
+	if (start + len > IP_MAXUDP ||	/* fragment extends too far */
+	    ((ip_off & IP_FLAGS_MFRAG) && (!len || len % 8))) {
+		net_stats.frag_dropped++;
 		return NULL;
-
-	if (!total_len || localip->ip_id != ip->ip_id) {
-		/* new (or different) packet, reset structs */
-		total_len = 0xffff;
-		payload[0].last_byte = ~0;
-		payload[0].next_hole = 0;
-		payload[0].prev_hole = 0;
-		first_hole = 0;
-		/* any IP header will work, copy the first we received */
-		memcpy(localip, ip, IP_HDR_SIZE);
 	}
 
+	d = ip_defrag_find(ip);
+	localip = (struct ip_udp_hdr *)d->pkt_buff;
+	/* payload starts after IP header, this fragment is in there */
+	payload = (struct hole *)(d->pkt_buff + IP_HDR_SIZE);
+	thisfrag = payload + offset8;
+
 	/*
 	 * What follows is the reassembly algorithm. We use the payload
 	 * array as a linked list of hole descriptors, as each hole starts
@@ -942,10 +1038,11 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	 * so it is represented as byte count, not as 8-byte blocks.
 	 */
 
-	h = payload + first_hole;
+	h = payload + d->first_hole;
 	while (h->last_byte < start) {
 		if (!h->next_hole) {
 			/* no hole that far away */
+			net_stats.frag_dropped++;
 			return NULL;
 		}
 		h = payload + h->next_hole;
@@ -954,12 +1051,13 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	/* last fragment may be 1..7 bytes, the "+7" forces acceptance */
 	if (offset8 + ((len + 7) / 8) <= h - payload) {
 		/* no overlap with holes (dup fragment?) */
+		net_stats.frag_dropped++;
 		return NULL;
 	}
 
 	if (!(ip_off & IP_FLAGS_MFRAG)) {
 		/* no more fragmentss: truncate this (last) hole */
-		total_len = start + len;
+		d->total_len = start + len;
 		h->last_byte = start + len;
 	}
 
@@ -967,16 +1065,20 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	 * There is some overlap: fix the hole list. This code doesn't
 	 * deal with a fragment that overlaps with two different holes
 	 * (thus being a superset of a previously-received fragment).
+	 *
+	 * A prev_hole of 0 may also be the hole at the start, once the
+	 * first fragment has been left out, so check against first_hole.
 	 */
+	first = h - payload == d->first_hole;
 
 	if ((h >= thisfrag) && (h->last_byte <= start + len)) {
 		/* complete overlap with hole: remove hole */
-		if (!h->prev_hole && !h->next_hole) {
+		if (first && !h->next_hole) {
 			/* last remaining hole */
 			done = 1;
-		} else if (!h->prev_hole) {
+		} else if (first) {
 			/* first hole */
-			first_hole = h->next_hole;
+			d->first_hole = h->next_hole;
 			payload[h->next_hole].prev_hole = 0;
 		} else if (!h->next_hole) {
 			/* last hole */
@@ -998,10 +1100,10 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 		h = newh;
 		if (h->next_hole)
 			payload[h->next_hole].prev_hole = (h - payload);
-		if (h->prev_hole)
+		if (!first)
 			payload[h->prev_hole].next_hole = (h - payload);
 		else
-			first_hole = (h - payload);
+			d->first_hole = (h - payload);
 
 	} else {
 		/* fragment sits in the middle: split the hole */
@@ -1019,8 +1121,11 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	if (!done)
 		return NULL;
 
-	localip->ip_len = htons(total_len);
-	*lenp = total_len + IP_HDR_SIZE;
+	/* The buffer stays as it is until another fragment arrives */
+	d->busy = false;
+	net_stats.frag_reassembled++;
+	localip->ip_len = htons(d->total_len);
+	*lenp = d->total_len + IP_HDR_SIZE;
 	return localip;
 }
 
@@ -1078,7 +1183,33 @@ static void receive_icmp(struct ip_udp_hdr *ip, int len,
 	}
 }
 
-void net_process_received_packet(uchar *in_packet, int len)
+int net_rx_direct(uchar *dest, int hdr_len)
+{
+	uchar *buf = dest - hdr_len;
+	int ret;
+
+	if (net_rx_direct_buf) {
+		eth_recv_into(NULL);
+		memcpy(net_rx_direct_buf, net_rx_direct_save,
+		       net_rx_direct_len);
+		net_rx_direct_buf = NULL;
+	}
+	if (!dest)
+		return 0;
+	if (hdr_len > NET_RX_DIRECT_MAX_HDR)
+		return -E2BIG;
+
+	memcpy(net_rx_direct_save, buf, hdr_len);
+	ret = eth_recv_into(buf);
+	if (ret)
+		return ret;
+	net_rx_direct_buf = buf;
+	net_rx_direct_len = hdr_len;
+
+	return 0;
+}
+
+static void net_process_packet(uchar *in_packet, int len)
 {
 	struct ethernet_hdr *et;
 	struct ip_udp_hdr *ip;
@@ -1102,6 +1233,7 @@ void net_process_received_packet(uchar *in_packet, int len)
 	/* too small packet? */
 	if (len < ETHER_HDR_SIZE)
 		return;
+	net_stats.rx_packets++;
 
 #if defined(CONFIG_API) || defined(CONFIG_EFI_LOADER)
 	if (push_packet) {
@@ -1260,6 +1392,11 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if (ip->ip_p == IPPROTO_ICMP) {
 			receive_icmp(ip, len, src_ip, et);
 			return;
+#if defined(CONFIG_PROT_TCP)
+		} else if (ip->ip_p == IPPROTO_TCP) {
+			tcp_receive((struct ip_tcp_hdr *)ip, len);
+			return;
+#endif
 		} else if (ip->ip_p != IPPROTO_UDP) {	/* Only UDP packets */
 			return;
 		}
@@ -1337,6 +1474,36 @@ void net_process_received_packet(uchar *in_packet, int len)
 	}
 }
 
+void net_process_received_packet(uchar *in_packet, int len)
+{
+	uchar save[NET_RX_DIRECT_MAX_HDR];
+	int save_len;
+
+	if (!net_rx_direct_buf || in_packet != net_rx_direct_buf) {
+		net_process_packet(in_packet, len);
+		return;
+	}
+
+	/*
+	 * The handler may ask for the next packet to be received in place, so
+	 * finish with this request before calling it
+	 */
+	save_len = net_rx_direct_len;
+	memcpy(save, net_rx_direct_save, save_len);
+	net_rx_direct_buf = NULL;
+
+	net_process_packet(in_packet, len);
+
+	/* The payload has been dealt with, so put back what was in front */
+	memcpy(in_packet, save, save_len);
+	/*
+	 * If the handler wants the next packet in the same place, it saved our
+	 * headers rather than what they overwrote
+	 */
+	if (net_rx_direct_buf == in_packet && net_rx_direct_len == save_len)
+		memcpy(net_rx_direct_save, save, save_len);
+}
+
 /**********************************************************************/
 
 static int net_check_prereq(enum proto_t protocol)
@@ -1369,6 +1536,9 @@ static int net_check_prereq(enum proto_t protocol)
 #endif
 #if defined(CONFIG_CMD_NFS)
 	case NFS:
+#endif
+#if defined(CONFIG_CMD_WGET)
+	case WGET:
 #endif
 		/* Fall through */
 	case TFTPGET:
@@ -1573,7 +1743,8 @@ int net_parse_bootfile(struct in_addr *ipaddr, char *filename, int max_len)
 
 #if	defined(CONFIG_CMD_NFS)		|| \
 	defined(CONFIG_CMD_SNTP)	|| \
-	defined(CONFIG_CMD_DNS)
+	defined(CONFIG_CMD_DNS)		|| \
+	defined(CONFIG_PROT_TCP)
 /*
  * make port a little random (1024-17407)
  * This keeps the math somewhat trivial to compute, and seems to work with
@@ -28,9 +28,11 @@
 
 #include <common.h>
 #include <command.h>
+#include <env.h>
 #include <net.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <linux/build_bug.h>
 #include "nfs.h"
 #include "bootp.h"
 
@@ -45,12 +47,39 @@
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
+/* net_loop() returns the size of the file as an int */
+#define NFS_MAX_FILE_SIZE	INT_MAX
+
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
+static u64 nfs_offset;		/* offset of the next READ to send */
 static int nfs_len;
+/* Headers in front of the data of the last READ reply */
+static int nfs_read_hdr_len;
 static ulong nfs_timeout = NFS_TIMEOUT;
 
+/*
+ * READs in flight, matched to their replies by XID. A free slot has an id
+ * of 0.
+ */
+struct nfs_read {
+	unsigned long id;
+	u64 offset;
+	int len;
+};
+
+static struct nfs_read nfs_reads[CONFIG_NFS_WINDOW];
+static int nfs_window;		/* number of READs to keep in flight */
+static bool nfs_eof;		/* nfs_file_end is known */
+static u64 nfs_file_end;
+static u64 nfs_stored_end;	/* end of the furthest data stored so far */
+static u64 nfs_received;	/* number of bytes stored */
+static ulong nfs_hashes;
+static ulong nfs_time_start;
+static uint nfs_read_count;	/* READ replies used */
+static uint nfs_resent_count;	/* READs sent again after a timeout */
+static uint nfs_in_place_count;	/* READ replies received in place */
+
 static char dirfh[NFS_FHSIZE];	/* NFSv2 / NFSv3 file handle of directory */
 static char filefh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle */
 static int filefh3_length;	/* (variable) length of filefh when NFSv3 */
@@ -78,7 +107,7 @@ static char nfs_path_buff[2048];
 #define NFSV3_FLAG 1 << 1
 static char supported_nfs_versions = NFSV2_FLAG | NFSV3_FLAG;
 
-static inline int store_block(uchar *src, unsigned offset, unsigned len)
+static inline int store_block(uchar *src, ulong offset, unsigned len)
 {
 	ulong newsize = offset + len;
 #ifdef CONFIG_SYS_DIRECT_FLASH_NFS
@@ -103,7 +132,11 @@ static inline int store_block(uchar *src, unsigned offset, unsigned len)
 	{
 		void *ptr = map_sysmem(load_addr + offset, len);
 
-		memcpy(ptr, src, len);
+		/* The data may have been received in place, or close to it */
+		if (ptr != src)
+			memmove(ptr, src, len);
+		else
+			nfs_in_place_count++;
 		unmap_sysmem(ptr);
 	}
 
@@ -112,6 +145,17 @@ static inline int store_block(uchar *src, unsigned offset, unsigned len)
 	return 0;
 }
 
+/* Check that a file of @size bytes can be loaded, complaining if not */
+static int nfs_check_size(u64 size)
+{
+	if (size <= NFS_MAX_FILE_SIZE)
+		return 0;
+	printf("*** ERROR: File too large (%llu bytes, at most %d)\n",
+	       (unsigned long long)size, NFS_MAX_FILE_SIZE);
+
+	return -EFBIG;
+}
+
 static char *basename(char *path)
 {
 	char *fname;
@@ -170,15 +214,14 @@ static uint32_t *rpc_add_credentials(uint32_t *p)
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
-static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
+static void rpc_send(unsigned long id, int rpc_prog, int rpc_proc,
+		     uint32_t *data, int datalen)
 {
 	struct rpc_t rpc_pkt;
-	unsigned long id;
 	uint32_t *p;
 	int pktlen;
 	int sport;
 
-	id = ++rpc_id;
 	rpc_pkt.u.call.id = htonl(id);
 	rpc_pkt.u.call.type = htonl(MSG_CALL);
 	rpc_pkt.u.call.rpcvers = htonl(2);	/* use RPC version 2 */
@@ -217,6 +260,11 @@ static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 			    nfs_our_port, pktlen);
 }
 
+static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
+{
+	rpc_send(++rpc_id, rpc_prog, rpc_proc, data, datalen);
+}
+
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
@@ -356,7 +404,7 @@ static void nfs_lookup_req(char *fname)
 /**************************************************************************
 NFS_READ - Read File on NFS Server
 **************************************************************************/
-static void nfs_read_req(int offset, int readlen)
+static void nfs_read_req(struct nfs_read *rd)
 {
 	uint32_t data[1024];
 	uint32_t *p;
@@ -368,22 +416,75 @@ static void nfs_read_req(int offset, int readlen)
 	if (supported_nfs_versions & NFSV2_FLAG) {
 		memcpy(p, filefh, NFS_FHSIZE);
 		p += (NFS_FHSIZE / 4);
-		*p++ = htonl(offset);
-		*p++ = htonl(readlen);
+		*p++ = htonl((u32)rd->offset);
+		*p++ = htonl(rd->len);
 		*p++ = 0;
 	} else { /* NFSV3_FLAG */
 		*p++ = htonl(filefh3_length);
 		memcpy(p, filefh, filefh3_length);
 		p += (filefh3_length / 4);
-		*p++ = htonl(0); /* offset is 64-bit long, so fill with 0 */
-		*p++ = htonl(offset);
-		*p++ = htonl(readlen);
+		*p++ = htonl(rd->offset >> 32);
+		*p++ = htonl((u32)rd->offset);
+		*p++ = htonl(rd->len);
 		*p++ = 0;
 	}
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req(PROG_NFS, NFS_READ, data, len);
+	/* A READ which is sent again keeps its XID */
+	rpc_send(rd->id, PROG_NFS, NFS_READ, data, len);
+}
+
+/* Use @rd for the next READ of the file, if it has not ended before that */
+static void nfs_read_next(struct nfs_read *rd)
+{
+	if (nfs_eof && nfs_offset >= nfs_file_end) {
+		rd->id = 0;
+		return;
+	}
+	rd->id = ++rpc_id;
+	rd->offset = nfs_offset;
+	rd->len = nfs_len;
+	nfs_offset += nfs_len;
+	nfs_read_req(rd);
+}
+
+/* Start reading the file with a window of READs */
+static void nfs_read_start(void)
+{
+	int i;
+
+	nfs_offset = 0;
+	nfs_len = NFS_READ_SIZE;
+	nfs_eof = false;
+	nfs_stored_end = 0;
+	nfs_received = 0;
+	nfs_hashes = 0;
+	nfs_read_count = 0;
+	nfs_resent_count = 0;
+	nfs_in_place_count = 0;
+	nfs_time_start = get_timer(0);
+	memset(nfs_reads, '\0', sizeof(nfs_reads));
+	for (i = 0; i < nfs_window; i++)
+		nfs_read_next(&nfs_reads[i]);
+}
+
+/* Forget the READs in flight, so that any late replies are dropped */
+static void nfs_read_stop(void)
+{
+	memset(nfs_reads, '\0', sizeof(nfs_reads));
+}
+
+static bool nfs_read_busy(void)
+{
+	int i;
+
+	for (i = 0; i < nfs_window; i++) {
+		if (nfs_reads[i].id)
+			return true;
+	}
+
+	return false;
 }
 
 /**************************************************************************
@@ -391,6 +492,8 @@ RPC request dispatcher
 **************************************************************************/
 static void nfs_send(void)
 {
+	int i;
+
 	debug("%s\n", __func__);
 
 	switch (nfs_state) {
@@ -416,7 +519,10 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		for (i = 0; i < nfs_window; i++) {
+			if (nfs_reads[i].id)
+				nfs_read_req(&nfs_reads[i]);
+		}
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -511,6 +617,8 @@ static int nfs_umountall_reply(uchar *pkt, unsigned len)
 static int nfs_lookup_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
+	uint32_t *attr;
+	u64 size = 0;
 
 	debug("%s\n", __func__);
 
@@ -569,6 +677,10 @@ static int nfs_lookup_reply(uchar *pkt, unsigned len)
 		if (((uchar *)&(rpc_pkt.u.reply.data[0]) - (uchar *)(&rpc_pkt) + NFS_FHSIZE) > len)
 			return -NFS_RPC_DROP;
 		memcpy(filefh, rpc_pkt.u.reply.data + 1, NFS_FHSIZE);
+		/* Attributes follow the handle, with a 32-bit size */
+		attr = rpc_pkt.u.reply.data + 1 + NFS_FHSIZE / 4;
+		if ((uchar *)(attr + 6) - (uchar *)&rpc_pkt <= len)
+			size = ntohl(attr[5]);
 	} else {  /* NFSV3_FLAG */
 		filefh3_length = ntohl(rpc_pkt.u.reply.data[1]);
 		if (filefh3_length > NFS3_FHSIZE)
@@ -576,9 +688,13 @@ static int nfs_lookup_reply(uchar *pkt, unsigned len)
 		if (((uchar *)&(rpc_pkt.u.reply.data[0]) - (uchar *)(&rpc_pkt) + filefh3_length) > len)
 			return -NFS_RPC_DROP;
 		memcpy(filefh, rpc_pkt.u.reply.data + 2, filefh3_length);
+		/* Optional attributes follow the handle, with a 64-bit size */
+		attr = rpc_pkt.u.reply.data + 2 + filefh3_length / 4;
+		if ((uchar *)(attr + 8) - (uchar *)&rpc_pkt <= len && attr[0])
+			size = (u64)ntohl(attr[6]) << 32 | ntohl(attr[7]);
 	}
 
-	return 0;
+	return nfs_check_size(size);
 }
 
 static int nfs3_get_attributes_offset(uint32_t *data)
@@ -659,20 +775,46 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 	return 0;
 }
 
-static int nfs_read_reply(uchar *pkt, unsigned len)
+/* Print a hash mark for each ten half-blocks loaded */
+static void nfs_show_progress(void)
+{
+	while (nfs_hashes < nfs_received / (NFS_READ_SIZE / 2 * 10)) {
+		if (nfs_hashes && !(nfs_hashes % HASHES_PER_LINE))
+			puts("\n\t ");
+		putc('#');
+		nfs_hashes++;
+	}
+}
+
+/*
+ * Handle the reply to one of the READs in flight, setting @rdp to that READ
+ * and @eofp to true if the server says the file ends after this data
+ */
+static int nfs_read_reply(uchar *pkt, unsigned len, struct nfs_read **rdp,
+			  bool *eofp)
 {
 	struct rpc_t rpc_pkt;
+	struct nfs_read *rd = NULL;
 	int rlen;
 	uchar *data_ptr;
+	int i;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	/* Only the headers are copied, the data is stored from the packet */
+	memcpy(&rpc_pkt.u.data[0], pkt, NFS_READ_REPLY_HDR_SIZE);
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+	for (i = 0; i < nfs_window; i++) {
+		if (nfs_reads[i].id &&
+		    nfs_reads[i].id == ntohl(rpc_pkt.u.reply.id)) {
+			rd = &nfs_reads[i];
+			break;
+		}
+	}
+	if (!rd)
 		return -NFS_RPC_DROP;
+	*rdp = rd;
+	*eofp = false;
 
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
@@ -685,12 +827,6 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
-		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
-		putc('#');
-
 	if (supported_nfs_versions & NFSV2_FLAG) {
 		rlen = ntohl(rpc_pkt.u.reply.data[18]);
 		data_ptr = (uchar *)&(rpc_pkt.u.reply.data[19]);
@@ -700,8 +836,8 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 
 		/* count value */
 		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
-		/* Skip unused values :
-			EOF:		32 bits value,
+		*eofp = rpc_pkt.u.reply.data[2 + nfsv3_data_offset] != 0;
+		/* Skip unused value :
 			data_size:	32 bits value,
 		*/
 		data_ptr = (uchar *)
@@ -710,13 +846,69 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 
 	if (((uchar *)&(rpc_pkt.u.reply.data[0]) - (uchar *)(&rpc_pkt) + rlen) > len)
 			return -9999;
-
-	if (store_block(data_ptr, nfs_offset, rlen))
+	if (rlen > rd->len)
+		return -9999;
+
+	nfs_read_hdr_len = data_ptr - (uchar *)&rpc_pkt;
+	data_ptr = pkt + nfs_read_hdr_len;
+
+	/* An empty reply past the end must not change the file size */
+	if (!rlen)
+		return 0;
+	if (nfs_check_size(rd->offset + rlen))
+		return -EFBIG;
+	if (store_block(data_ptr, rd->offset, rlen))
 			return -9999;
+	nfs_stored_end = max(nfs_stored_end, rd->offset + rlen);
+	nfs_received += rlen;
+	nfs_read_count++;
+	nfs_show_progress();
 
 	return rlen;
 }
 
+/*
+ * Ask for the reply to the oldest READ in flight, which is normally the next
+ * to arrive, to be received with its data straight in its place in memory,
+ * assuming the headers are as long as the last time. This is only done while
+ * nothing after it has been stored, since the driver may write past the data.
+ */
+static void nfs_rx_direct(void)
+{
+#ifndef CONFIG_SYS_DIRECT_FLASH_NFS
+	int hdr_len = net_eth_hdr_size() + IP_UDP_HDR_SIZE + nfs_read_hdr_len;
+	struct nfs_read *rd = NULL;
+	int i;
+
+	for (i = 0; i < nfs_window; i++) {
+		if (nfs_reads[i].id &&
+		    (!rd || nfs_reads[i].offset < rd->offset))
+			rd = &nfs_reads[i];
+	}
+	if (!rd || rd->len != NFS_READ_SIZE || rd->offset < hdr_len ||
+	    nfs_stored_end > rd->offset) {
+		net_rx_direct(NULL, 0);
+		return;
+	}
+	net_rx_direct(map_sysmem(load_addr + rd->offset, 0), hdr_len);
+#endif
+}
+
+/* Show how fast the file was loaded */
+static void nfs_show_stats(void)
+{
+	ulong time_taken = get_timer(nfs_time_start);
+
+	puts("\n\t ");	/* Line up with "Loading: " */
+	if (time_taken > 0) {
+		print_size(nfs_received / time_taken * 1000, "/s");
+		puts(", ");
+	}
+	printf("%u READs of %d bytes, window %d, %u resent, %u received in place",
+	       nfs_read_count, NFS_READ_SIZE, nfs_window, nfs_resent_count,
+	       nfs_in_place_count);
+}
+
 /**************************************************************************
 Interfaces of U-BOOT
 **************************************************************************/
@@ -730,6 +922,12 @@ static void nfs_timeout_handler(void)
 		net_set_timeout_handler(nfs_timeout +
 					NFS_TIMEOUT * nfs_timeout_count,
 					nfs_timeout_handler);
+		if (nfs_state == STATE_READ_REQ) {
+			int i;
+
+			for (i = 0; i < nfs_window; i++)
+				nfs_resent_count += !!nfs_reads[i].id;
+		}
 		nfs_send();
 	}
 }
@@ -737,6 +935,8 @@ static void nfs_timeout_handler(void)
 static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			unsigned src, unsigned len)
 {
+	struct nfs_read *rd;
+	bool eof;
 	int rlen;
 	int reply;
 
@@ -795,8 +995,9 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		reply = nfs_lookup_reply(pkt, len);
 		if (reply == -NFS_RPC_DROP) {
 			break;
-		} else if (reply == -NFS_RPC_ERR) {
-			puts("*** ERROR: File lookup fail\n");
+		} else if (reply == -NFS_RPC_ERR || reply == -EFBIG) {
+			if (reply == -NFS_RPC_ERR)
+				puts("*** ERROR: File lookup fail\n");
 			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		} else if (reply == -NFS_RPC_PROG_MISMATCH &&
@@ -809,9 +1010,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_send();
 		} else {
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
-			nfs_send();
+			nfs_read_start();
 		}
 		break;
 
@@ -834,22 +1033,42 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		break;
 
 	case STATE_READ_REQ:
-		rlen = nfs_read_reply(pkt, len);
+		rlen = nfs_read_reply(pkt, len, &rd, &eof);
 		if (rlen == -NFS_RPC_DROP)
 			break;
 		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
+		if (rlen >= 0) {
+			if (!rlen || eof) {
+				/* Nothing is asked for from here on */
+				if (!nfs_eof || rd->offset + rlen < nfs_file_end)
+					nfs_file_end = rd->offset + rlen;
+				nfs_eof = true;
+				rd->id = 0;
+			} else if (rlen < rd->len) {
+				/* A short read: ask for the rest */
+				rd->id = ++rpc_id;
+				rd->offset += rlen;
+				rd->len -= rlen;
+				nfs_read_req(rd);
+			} else {
+				nfs_read_next(rd);
+			}
+			if (nfs_read_busy()) {
+				nfs_rx_direct();
+				break;
+			}
+			nfs_show_stats();
+			nfs_download_state = NETLOOP_SUCCESS;
+			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
+			nfs_read_stop();
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
-				nfs_download_state = NETLOOP_SUCCESS;
-			if (rlen < 0)
-				debug("NFS READ error (%d)\n", rlen);
+			debug("NFS READ error (%d)\n", rlen);
+			nfs_read_stop();
 			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		}
@@ -861,6 +1080,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 void nfs_start(void)
 {
 	debug("%s\n", __func__);
+	BUILD_BUG_ON(NFS_READ_SIZE > NFS_MAX_READ_SIZE);
 	nfs_download_state = NETLOOP_FAIL;
 
 	nfs_server_ip = net_server_ip;
@@ -917,6 +1137,9 @@ void nfs_start(void)
 
 	nfs_timeout_count = 0;
 	nfs_state = STATE_PRCLOOKUP_PROG_MOUNT_REQ;
+	nfs_window = env_get_ulong("nfswindowsize", 10, CONFIG_NFS_WINDOW);
+	nfs_window = clamp(nfs_window, 1, CONFIG_NFS_WINDOW);
+	nfs_read_stop();
 
 	/*nfs_our_port = 4096 + (get_ticks() % 3072);*/
 	/*FIX ME !!!*/
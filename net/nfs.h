@@ -41,8 +41,26 @@
  * However, if CONFIG_IP_DEFRAG is set, a bigger value could be used.  In any
  * case, most NFS servers are optimized for a power of 2.
  */
+#ifdef CONFIG_NFS_READ_SIZE
+#define NFS_READ_SIZE	CONFIG_NFS_READ_SIZE
+#else
 #define NFS_READ_SIZE	1024	/* biggest power of two that fits Ether frame */
+#endif
 #define NFS_MAX_ATTRS	26
+/* longest RPC header in front of the data of a READ reply */
+#define NFS_READ_REPLY_HDR_SIZE	((6 + NFS_MAX_ATTRS) * sizeof(uint32_t))
+
+/* Largest READ reply which fits in one frame, or can be reassembled */
+#ifdef CONFIG_IP_DEFRAG
+#ifndef CONFIG_NET_MAXDEFRAG
+#define CONFIG_NET_MAXDEFRAG 16384
+#endif
+#define NFS_MAX_READ_SIZE	(CONFIG_NET_MAXDEFRAG - IP_UDP_HDR_SIZE - \
+				 NFS_READ_REPLY_HDR_SIZE)
+#else
+#define NFS_MAX_READ_SIZE	(ETH_DATA_LEN - IP_UDP_HDR_SIZE - \
+				 NFS_READ_REPLY_HDR_SIZE)
+#endif
 
 /* Values for Accept State flag on RPC answers (See: rfc1831) */
 enum rpc_accept_stat {
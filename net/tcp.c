@@ -0,0 +1,521 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Minimal TCP client
+ *
+ * This is just enough TCP to fetch a file from a server on a local network
+ * quickly: there is one connection, which sends little, and received data is
+ * taken in order only (no SACK), ideally straight into its final place in
+ * memory. Throughput comes from a large receive window, which keeps the
+ * server sending while we ACK every second segment.
+ */
+
+#include <common.h>
+#include <net.h>
+#include <asm/unaligned.h>
+#include "tcp.h"
+
+/* First retransmission timeout; this doubles with each retry */
+#define TCP_RTO_MS		1000
+/* Retransmissions before giving up */
+#define TCP_RETRIES		6
+/* Longest time a received segment may wait to be acknowledged */
+#define TCP_DELACK_MS		20
+/* Time without hearing from the server before giving up */
+#define TCP_IDLE_MS		15000
+
+enum tcp_state {
+	TCP_CLOSED,
+	TCP_SYN_SENT,
+	TCP_ESTABLISHED,
+	TCP_FIN_WAIT_1,		/* we sent a FIN */
+	TCP_FIN_WAIT_2,		/* our FIN was acknowledged */
+	TCP_CLOSING,		/* both sent a FIN, ours is not acknowledged */
+	TCP_CLOSE_WAIT,		/* server sent a FIN */
+	TCP_LAST_ACK,		/* then we sent ours */
+};
+
+static enum tcp_state tcp_state;
+static const struct tcp_ops *tcp_ops;
+static struct in_addr tcp_remote_ip;
+static uchar tcp_remote_ethaddr[ARP_HLEN];
+static int tcp_remote_port;
+static int tcp_local_port;
+
+static u32 tcp_snd_una;		/* oldest sequence number not acknowledged */
+static u32 tcp_snd_nxt;		/* next sequence number to send */
+static u32 tcp_irs;		/* initial sequence number of the server */
+static u32 tcp_rcv_nxt;		/* next sequence number expected */
+static int tcp_wscale;		/* shift of our window, if the server agreed */
+
+static uchar tcp_tx_buf[TCP_MSS];	/* data not yet acknowledged */
+static int tcp_tx_len;
+static bool tcp_fin_sent;
+
+static int tcp_unacked;		/* segments received but not acknowledged */
+static ulong tcp_ack_due;	/* when a delayed ACK must go, or 0 */
+static ulong tcp_rtx_due;	/* when to retransmit, if anything is unacked */
+static ulong tcp_rto;
+static int tcp_retries;
+static ulong tcp_last_rx;
+
+static inline bool tcp_seq_lt(u32 a, u32 b)
+{
+	return (s32)(a - b) < 0;
+}
+
+static inline bool tcp_seq_le(u32 a, u32 b)
+{
+	return (s32)(a - b) <= 0;
+}
+
+/* Shift needed for CONFIG_TCP_RX_WINDOW to fit in the 16-bit window field */
+static int tcp_window_shift(void)
+{
+	int shift = 0;
+
+	while ((CONFIG_TCP_RX_WINDOW >> shift) > 0xffff && shift < 14)
+		shift++;
+
+	return shift;
+}
+
+static u16 tcp_window(bool syn)
+{
+	ulong win = CONFIG_TCP_RX_WINDOW;
+
+	/* The window in a SYN is never scaled */
+	if (!syn)
+		win >>= tcp_wscale;
+
+	return min(win, 0xffffUL);
+}
+
+static u16 tcp_checksum(struct in_addr src, struct in_addr dest,
+			const uchar *tcp, int len)
+{
+	struct {
+		struct in_addr src;
+		struct in_addr dest;
+		u8 zero;
+		u8 proto;
+		u16 len;
+	} __packed phdr;
+
+	phdr.src = src;
+	phdr.dest = dest;
+	phdr.zero = 0;
+	phdr.proto = IPPROTO_TCP;
+	phdr.len = htons(len);
+
+	return add_ip_checksums(sizeof(phdr),
+				compute_ip_checksum(&phdr, sizeof(phdr)),
+				compute_ip_checksum(tcp, len));
+}
+
+int tcp_set_tcp_header(uchar *pkt, struct in_addr dest, int dport, int sport,
+		       int payload_len, u8 action, u32 tcp_seq_num,
+		       u32 tcp_ack_num)
+{
+	struct ip_tcp_hdr *ip = (struct ip_tcp_hdr *)pkt;
+	uchar *opt = pkt + IP_TCP_HDR_SIZE;
+	int hdr_len = TCP_HDR_SIZE;
+
+	if (action & TCP_SYN) {
+		opt[0] = TCP_OPT_MSS;
+		opt[1] = 4;
+		put_unaligned_be16(TCP_MSS, opt + 2);
+		opt[4] = TCP_OPT_NOP;
+		opt[5] = TCP_OPT_WSCALE;
+		opt[6] = 3;
+		opt[7] = tcp_window_shift();
+		hdr_len += 8;
+	}
+
+	net_set_ip_header(pkt, dest, net_ip, IP_HDR_SIZE + hdr_len + payload_len,
+			  IPPROTO_TCP);
+
+	ip->tcp_src = htons(sport);
+	ip->tcp_dst = htons(dport);
+	ip->tcp_seq = htonl(tcp_seq_num);
+	ip->tcp_ack = htonl(tcp_ack_num);
+	ip->tcp_hlen = (hdr_len / 4) << 4;
+	ip->tcp_flags = action;
+	ip->tcp_win = htons(tcp_window(action & TCP_SYN));
+	ip->tcp_xsum = 0;
+	ip->tcp_urg = 0;
+	ip->tcp_xsum = tcp_checksum(net_ip, dest, pkt + IP_HDR_SIZE,
+				    hdr_len + payload_len);
+
+	return IP_HDR_SIZE + hdr_len;
+}
+
+static void tcp_send_segment(u8 action, const void *data, int len, u32 seq)
+{
+	uchar *pkt = net_tx_packet + net_eth_hdr_size() + IP_TCP_HDR_SIZE;
+
+	if (len)
+		memcpy(pkt, data, len);
+	net_send_ip_packet(tcp_remote_ethaddr, tcp_remote_ip, tcp_remote_port,
+			   tcp_local_port, len, IPPROTO_TCP, action, seq,
+			   action & TCP_ACK ? tcp_rcv_nxt : 0);
+	if (action & TCP_ACK) {
+		tcp_unacked = 0;
+		tcp_ack_due = 0;
+	}
+}
+
+static void tcp_send_ack(void)
+{
+	tcp_send_segment(TCP_ACK, NULL, 0, tcp_snd_nxt);
+}
+
+/* (Re)send everything the server has not acknowledged */
+static void tcp_transmit(void)
+{
+	u8 action = TCP_ACK;
+
+	if (tcp_state == TCP_SYN_SENT) {
+		tcp_send_segment(TCP_SYN, NULL, 0, tcp_snd_una);
+	} else if (tcp_snd_una != tcp_snd_nxt) {
+		if (tcp_tx_len)
+			action |= TCP_PUSH;
+		if (tcp_fin_sent)
+			action |= TCP_FIN;
+		tcp_send_segment(action, tcp_tx_buf, tcp_tx_len, tcp_snd_una);
+	}
+	tcp_rtx_due = get_timer(0) + tcp_rto;
+}
+
+static bool tcp_outstanding(void)
+{
+	return tcp_state == TCP_SYN_SENT || tcp_snd_una != tcp_snd_nxt;
+}
+
+static void tcp_timeout_handler(void);
+
+/* Set the timer for whichever of our deadlines comes first */
+static void tcp_update_timer(void)
+{
+	ulong now = get_timer(0);
+	ulong due = tcp_last_rx + TCP_IDLE_MS;
+
+	if (tcp_state == TCP_CLOSED)
+		return;
+	if (tcp_ack_due && tcp_seq_lt(tcp_ack_due, due))
+		due = tcp_ack_due;
+	if (tcp_outstanding() && tcp_seq_lt(tcp_rtx_due, due))
+		due = tcp_rtx_due;
+	/* An interval of 0 would cancel the handler, so fire it at once */
+	net_set_timeout_handler(tcp_seq_lt(now, due) ? due - now : 1,
+				tcp_timeout_handler);
+}
+
+static void tcp_finish(int err)
+{
+	tcp_state = TCP_CLOSED;
+	net_set_timeout_handler(0, NULL);
+	net_rx_direct(NULL, 0);
+	tcp_ops->closed(err);
+}
+
+static void tcp_timeout_handler(void)
+{
+	ulong now = get_timer(0);
+
+	if (tcp_ack_due && tcp_seq_le(tcp_ack_due, now))
+		tcp_send_ack();
+	if (tcp_outstanding() && tcp_seq_le(tcp_rtx_due, now)) {
+		if (++tcp_retries > TCP_RETRIES) {
+			tcp_abort();
+			tcp_finish(-ETIMEDOUT);
+			return;
+		}
+		puts("T ");
+		tcp_rto *= 2;
+		tcp_transmit();
+	}
+	if (tcp_seq_le(tcp_last_rx + TCP_IDLE_MS, now)) {
+		tcp_abort();
+		tcp_finish(-ETIMEDOUT);
+		return;
+	}
+	tcp_update_timer();
+}
+
+void tcp_connect(struct in_addr ip, int port, const struct tcp_ops *ops)
+{
+	tcp_ops = ops;
+	tcp_remote_ip = ip;
+	tcp_remote_port = port;
+	memset(tcp_remote_ethaddr, 0, ARP_HLEN);
+	/* Do not reuse the port of a connection the server may remember */
+	if (tcp_local_port)
+		tcp_local_port = 1024 + (tcp_local_port - 1023) % 0x4000;
+	else
+		tcp_local_port = random_port();
+
+	tcp_snd_una = get_ticks();
+	tcp_snd_nxt = tcp_snd_una + 1;
+	tcp_wscale = 0;
+	tcp_tx_len = 0;
+	tcp_fin_sent = false;
+	tcp_unacked = 0;
+	tcp_ack_due = 0;
+	tcp_rto = TCP_RTO_MS;
+	tcp_retries = 0;
+	tcp_last_rx = get_timer(0);
+
+	tcp_state = TCP_SYN_SENT;
+	tcp_transmit();
+	tcp_update_timer();
+}
+
+int tcp_send(const void *data, int len)
+{
+	if (tcp_state != TCP_SYN_SENT && tcp_state != TCP_ESTABLISHED &&
+	    tcp_state != TCP_CLOSE_WAIT)
+		return -ENOTCONN;
+	if (tcp_tx_len)
+		return -EBUSY;
+	if (len > sizeof(tcp_tx_buf))
+		return -E2BIG;
+
+	memcpy(tcp_tx_buf, data, len);
+	tcp_tx_len = len;
+	if (tcp_state != TCP_SYN_SENT) {
+		tcp_snd_nxt += len;
+		tcp_transmit();
+		tcp_update_timer();
+	}
+
+	return 0;
+}
+
+void tcp_close(void)
+{
+	switch (tcp_state) {
+	case TCP_SYN_SENT:
+		tcp_abort();
+		return;
+	case TCP_ESTABLISHED:
+		tcp_state = TCP_FIN_WAIT_1;
+		break;
+	case TCP_CLOSE_WAIT:
+		tcp_state = TCP_LAST_ACK;
+		break;
+	default:
+		return;
+	}
+	tcp_fin_sent = true;
+	tcp_snd_nxt++;
+	tcp_transmit();
+	tcp_update_timer();
+}
+
+void tcp_abort(void)
+{
+	if (tcp_state == TCP_CLOSED)
+		return;
+	if (tcp_state != TCP_SYN_SENT)
+		tcp_send_segment(TCP_RST, NULL, 0, tcp_snd_nxt);
+	tcp_state = TCP_CLOSED;
+	net_set_timeout_handler(0, NULL);
+	net_rx_direct(NULL, 0);
+}
+
+/* Look for the window-scale option in a SYN from the server */
+static bool tcp_has_wscale(const uchar *opt, int len)
+{
+	while (len > 0 && *opt != TCP_OPT_END) {
+		if (*opt == TCP_OPT_NOP) {
+			opt++;
+			len--;
+			continue;
+		}
+		if (len < 2 || opt[1] < 2 || opt[1] > len)
+			break;
+		if (*opt == TCP_OPT_WSCALE)
+			return true;
+		len -= opt[1];
+		opt += opt[1];
+	}
+
+	return false;
+}
+
+/* Ask for the next segment to be received where its data will be stored */
+static void tcp_rx_arm(void)
+{
+	uchar *dest;
+
+	if (!tcp_ops->rx_dest)
+		return;
+	dest = tcp_ops->rx_dest(tcp_rcv_nxt - tcp_irs - 1);
+	/* The headers in front must be 16-bit aligned for the checksum */
+	if (dest && !((ulong)dest & 1))
+		net_rx_direct(dest, net_eth_hdr_size() + IP_TCP_HDR_SIZE);
+	else
+		net_rx_direct(NULL, 0);
+}
+
+static void tcp_rx_syn(struct ip_tcp_hdr *ip, int hdr_len)
+{
+	u32 ack = ntohl(ip->tcp_ack);
+
+	if ((ip->tcp_flags & (TCP_SYN | TCP_ACK)) != (TCP_SYN | TCP_ACK) ||
+	    ack != tcp_snd_nxt)
+		return;
+
+	tcp_irs = ntohl(ip->tcp_seq);
+	tcp_rcv_nxt = tcp_irs + 1;
+	tcp_snd_una = ack;
+	if (tcp_has_wscale((uchar *)ip + IP_TCP_HDR_SIZE,
+			   hdr_len - TCP_HDR_SIZE))
+		tcp_wscale = tcp_window_shift();
+	tcp_state = TCP_ESTABLISHED;
+	tcp_retries = 0;
+	tcp_rto = TCP_RTO_MS;
+
+	if (tcp_tx_len) {
+		tcp_snd_nxt += tcp_tx_len;
+		tcp_transmit();
+	} else {
+		tcp_send_ack();
+	}
+	tcp_rx_arm();
+}
+
+/* Handle an acknowledgement of what we sent */
+static void tcp_rx_ack(u32 ack)
+{
+	u32 acked;
+	int len;
+
+	if (!tcp_seq_lt(tcp_snd_una, ack) || !tcp_seq_le(ack, tcp_snd_nxt))
+		return;
+
+	acked = ack - tcp_snd_una;
+	len = min_t(u32, acked, tcp_tx_len);
+	memmove(tcp_tx_buf, tcp_tx_buf + len, tcp_tx_len - len);
+	tcp_tx_len -= len;
+	tcp_snd_una = ack;
+	tcp_retries = 0;
+	tcp_rto = TCP_RTO_MS;
+	tcp_rtx_due = get_timer(0) + tcp_rto;
+
+	if (tcp_fin_sent && ack == tcp_snd_nxt) {
+		switch (tcp_state) {
+		case TCP_FIN_WAIT_1:
+			tcp_state = TCP_FIN_WAIT_2;
+			break;
+		case TCP_CLOSING:
+		case TCP_LAST_ACK:
+			tcp_finish(0);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void tcp_receive(struct ip_tcp_hdr *ip, int len)
+{
+	uchar *data;
+	int hdr_len;
+	u32 seq;
+	u8 flags;
+
+	if (tcp_state == TCP_CLOSED || len < IP_TCP_HDR_SIZE)
+		return;
+	if (ip->ip_src.s_addr != tcp_remote_ip.s_addr ||
+	    ntohs(ip->tcp_src) != tcp_remote_port ||
+	    ntohs(ip->tcp_dst) != tcp_local_port)
+		return;
+	hdr_len = (ip->tcp_hlen >> 4) * 4;
+	if (hdr_len < TCP_HDR_SIZE || IP_HDR_SIZE + hdr_len > len)
+		return;
+	if (tcp_checksum(ip->ip_src, ip->ip_dst, (uchar *)ip + IP_HDR_SIZE,
+			 len - IP_HDR_SIZE)) {
+		debug("TCP: bad checksum\n");
+		return;
+	}
+
+	seq = ntohl(ip->tcp_seq);
+	flags = ip->tcp_flags;
+	data = (uchar *)ip + IP_HDR_SIZE + hdr_len;
+	len -= IP_HDR_SIZE + hdr_len;
+	tcp_last_rx = get_timer(0);
+
+	if (flags & TCP_RST) {
+		if (tcp_state == TCP_SYN_SENT) {
+			if ((flags & TCP_ACK) && ntohl(ip->tcp_ack) == tcp_snd_nxt)
+				tcp_finish(-ECONNREFUSED);
+		} else if (seq == tcp_rcv_nxt) {
+			tcp_finish(-ECONNRESET);
+		}
+		return;
+	}
+
+	if (tcp_state == TCP_SYN_SENT) {
+		tcp_rx_syn(ip, hdr_len);
+		tcp_update_timer();
+		return;
+	}
+	if (!(flags & TCP_ACK))
+		return;
+	tcp_rx_ack(ntohl(ip->tcp_ack));
+	if (tcp_state == TCP_CLOSED)
+		return;
+
+	/* A repeated SYN means our ACK of it was lost, so is handled here */
+	if (len || (flags & (TCP_SYN | TCP_FIN))) {
+		/* Drop any part we have already had */
+		if (tcp_seq_lt(seq, tcp_rcv_nxt) &&
+		    tcp_seq_lt(tcp_rcv_nxt, seq + len)) {
+			data += tcp_rcv_nxt - seq;
+			len -= tcp_rcv_nxt - seq;
+			seq = tcp_rcv_nxt;
+		}
+		if (seq != tcp_rcv_nxt) {
+			/* Out of order, or a repeat: tell the server at once */
+			tcp_send_ack();
+		} else {
+			u32 offset = tcp_rcv_nxt - tcp_irs - 1;
+			bool open = tcp_state == TCP_ESTABLISHED ||
+				    tcp_state == TCP_FIN_WAIT_1 ||
+				    tcp_state == TCP_FIN_WAIT_2;
+
+			if (len && open) {
+				tcp_rcv_nxt += len;
+				tcp_unacked++;
+				tcp_ops->rx(offset, data, len);
+				if (tcp_state == TCP_CLOSED)
+					return;
+			}
+			if ((flags & TCP_FIN) && open) {
+				tcp_rcv_nxt++;
+				tcp_send_ack();
+				switch (tcp_state) {
+				case TCP_ESTABLISHED:
+					tcp_state = TCP_CLOSE_WAIT;
+					break;
+				case TCP_FIN_WAIT_1:
+					tcp_state = TCP_CLOSING;
+					break;
+				default:
+					tcp_finish(0);
+					return;
+				}
+				tcp_ops->rx(tcp_rcv_nxt - tcp_irs - 2, NULL, 0);
+				if (tcp_state == TCP_CLOSED)
+					return;
+			} else if (tcp_unacked >= 2) {
+				tcp_send_ack();
+			} else if (tcp_unacked && !tcp_ack_due) {
+				tcp_ack_due = get_timer(0) + TCP_DELACK_MS;
+			}
+			tcp_rx_arm();
+		}
+	}
+	tcp_update_timer();
+}
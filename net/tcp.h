@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Minimal TCP client, enough to fetch a file from a server
+ *
+ * Only one connection is supported at a time. Data is sent in at most one
+ * segment at a time and received data is only accepted in order, with
+ * delayed ACKs and an advertised window of CONFIG_TCP_RX_WINDOW bytes.
+ */
+
+#ifndef __TCP_H__
+#define __TCP_H__
+
+#include <net.h>
+
+/* Largest segment payload we send or ask the server to send */
+#define TCP_MSS		1460
+
+/**
+ * struct tcp_ops - Callbacks from TCP to the protocol using it
+ *
+ * @rx:		Called with data received in order. @offset is the position of
+ *		@data in the stream from the server, starting at 0. If the
+ *		data was received in place (see @rx_dest), it may already be
+ *		where it is to be stored, or may overlap it. Called with @len
+ *		of 0 once the server has finished sending.
+ * @rx_dest:	Optional. Returns where the data at @offset will be stored,
+ *		so that the next segment can be received straight there, or
+ *		NULL if it cannot be
+ * @closed:	Called once the connection has gone: with 0 if it was closed
+ *		by both ends, or a -ve error if it was reset or timed out
+ */
+struct tcp_ops {
+	void (*rx)(u32 offset, uchar *data, int len);
+	uchar *(*rx_dest)(u32 offset);
+	void (*closed)(int err);
+};
+
+/**
+ * tcp_connect() - Open a connection to a server
+ *
+ * The handshake proceeds from net_loop(), which must be running. Any
+ * earlier connection is dropped without telling the server.
+ *
+ * @ip:		IP address of the server
+ * @port:	Port to connect to
+ * @ops:	Callbacks for the connection
+ */
+void tcp_connect(struct in_addr ip, int port, const struct tcp_ops *ops);
+
+/**
+ * tcp_send() - Send data to the server
+ *
+ * The data is copied and is sent once the connection is established, then
+ * resent until the server acknowledges it.
+ *
+ * @data:	Data to send
+ * @len:	Number of bytes to send, at most TCP_MSS
+ * @return 0 if OK, -EBUSY if earlier data has not been acknowledged yet,
+ *	-E2BIG if @len is too large, -ENOTCONN if the connection is closing
+ */
+int tcp_send(const void *data, int len);
+
+/* Tell the server we have finished, once it has everything we sent */
+void tcp_close(void);
+
+/* Reset the connection without waiting for the server */
+void tcp_abort(void);
+
+/**
+ * tcp_set_tcp_header() - Set the IP and TCP headers of a segment
+ *
+ * This is used by net_send_ip_packet().
+ *
+ * @pkt:	Start of the IP header
+ * @dest:	IP address to send to
+ * @dport:	Destination port
+ * @sport:	Source port
+ * @payload_len: Length of the data after the TCP header, which must be
+ *		0 for a SYN since its header has options
+ * @action:	TCP_... flags to set
+ * @tcp_seq_num: Sequence number
+ * @tcp_ack_num: Acknowledgement number
+ * @return size of the IP and TCP headers
+ */
+int tcp_set_tcp_header(uchar *pkt, struct in_addr dest, int dport, int sport,
+		       int payload_len, u8 action, u32 tcp_seq_num,
+		       u32 tcp_ack_num);
+
+/**
+ * tcp_receive() - Process a received TCP segment
+ *
+ * @ip:		Received packet, starting at the IP header
+ * @len:	Length of the packet from the IP header
+ */
+void tcp_receive(struct ip_tcp_hdr *ip, int len);
+
+#endif /* __TCP_H__ */
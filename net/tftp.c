@@ -10,6 +10,7 @@
 #include <command.h>
 #include <efi_loader.h>
 #include <env.h>
+#include <image.h>
 #include <mapmem.h>
 #include <net.h>
 #include <net/tftp.h>
@@ -79,6 +80,10 @@ static int	timeout_count;
 static ulong	tftp_cur_block;
 /* last packet sequence number received */
 static ulong	tftp_prev_block;
+/* block number whose arrival completes the current window */
+static ulong	tftp_next_ack;
+/* last block re-acknowledged because of a gap in the window */
+static ulong	tftp_last_nack;
 /* count of sequence number wraparounds */
 static ulong	tftp_block_wrap;
 /* memory offset due to wrapping */
@@ -94,6 +99,8 @@ static int	tftp_tsize;
 /* The number of hashes we printed */
 static short	tftp_tsize_num_hash;
 #endif
+/* The number of blocks the network driver put straight into place */
+static ulong	tftp_in_place;
 #ifdef CONFIG_CMD_TFTPPUT
 /* 1 if writing, else 0 */
 static int	tftp_put_active;
@@ -141,6 +148,25 @@ static char tftp_filename[MAX_LEN];
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = TFTP_MTU_BLOCKSIZE;
 
+/*
+ * RFC 7440 window size: the number of blocks the server may send before it
+ * has to wait for an ACK. A window of 1 is the lock-step RFC 1350 protocol.
+ */
+#ifdef CONFIG_TFTP_WINDOWSIZE
+#define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
+#else
+#define TFTP_WINDOWSIZE 1
+#endif
+
+/*
+ * Block numbers are 16 bits and wrap, so a window must stay within half of
+ * them for a gap to be told apart from an old block
+ */
+#define TFTP_MAX_WINDOWSIZE	0x7fff
+
+static unsigned short tftp_windowsize = 1;
+static unsigned short tftp_windowsize_option = TFTP_WINDOWSIZE;
+
 static inline int store_block(int block, uchar *src, unsigned int len)
 {
 	ulong offset = block * tftp_block_size + tftp_block_wrap_offset;
@@ -179,8 +205,14 @@ static inline int store_block(int block, uchar *src, unsigned int len)
 		}
 #endif
 		ptr = map_sysmem(store_addr, len);
-		memcpy(ptr, src, len);
+		/* The block may have been received in place, or close to it */
+		if (ptr != src)
+			memmove(ptr, src, len);
+		else
+			tftp_in_place++;
 		unmap_sysmem(ptr);
+		/* Blocks are stored in order, so tell the FIT code */
+		fit_stream_data(newsize);
 	}
 
 	if (net_boot_file_size < newsize)
@@ -189,12 +221,32 @@ static inline int store_block(int block, uchar *src, unsigned int len)
 	return 0;
 }
 
+/*
+ * Ask for the block after the current one to be received straight into its
+ * place in memory. This only works when each ACK is followed by exactly one
+ * block, and only if the packet buffer stays within the load area.
+ */
+static void tftp_rx_direct(void)
+{
+#if defined(CONFIG_LMB) && !defined(CONFIG_SYS_DIRECT_FLASH_TFTP)
+	ulong offset = tftp_cur_block * tftp_block_size + tftp_block_wrap_offset;
+	int hdr_len = net_eth_hdr_size() + IP_UDP_HDR_SIZE + 4;
+
+	if (tftp_windowsize != 1 || offset < hdr_len ||
+	    offset - hdr_len + PKTSIZE_ALIGN > tftp_load_size)
+		return;
+	net_rx_direct(map_sysmem(tftp_load_addr + offset, 0), hdr_len);
+#endif
+}
+
 /* Clear our state ready for a new transfer */
 static void new_transfer(void)
 {
 	tftp_prev_block = 0;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
+	tftp_next_ack = tftp_windowsize;
+	tftp_last_nack = TFTP_SEQUENCE_SIZE;	/* not a valid block number */
 #ifdef CONFIG_CMD_TFTPPUT
 	tftp_put_final_block_sent = 0;
 #endif
@@ -302,7 +354,10 @@ static void tftp_complete(void)
 		print_size(net_boot_file_size /
 			time_start * 1000, "/s");
 	}
+	if (tftp_in_place)
+		printf("\n\t %lu blocks received in place", tftp_in_place);
 	puts("\ndone\n");
+	fit_stream_end();
 	net_set_state(NETLOOP_SUCCESS);
 }
 
@@ -347,6 +402,10 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+		/* only reads are windowed; 1 is the default, so skip it */
+		if (tftp_state == STATE_SEND_RRQ && tftp_windowsize_option > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_windowsize_option, 0);
 		len = pkt - xp;
 		break;
 
@@ -412,11 +471,31 @@ static void icmp_handler(unsigned type, unsigned code, unsigned dest,
 }
 #endif
 
+/*
+ * A data block arrived which is not the next one in sequence, so something
+ * in the current window was lost or reordered. Acknowledge the last block we
+ * hold, which makes the server restart the window right after it. The rest of
+ * the broken window is likely still in flight, so only do this once per gap.
+ */
+static void tftp_window_gap(ushort block)
+{
+	debug("Received block %d, expected %d\n", block,
+	      (ushort)(tftp_prev_block + 1));
+	if (tftp_last_nack == tftp_prev_block)
+		return;
+
+	tftp_cur_block = tftp_prev_block;
+	tftp_last_nack = tftp_prev_block;
+	tftp_next_ack = (ushort)(tftp_prev_block + tftp_windowsize);
+	tftp_send();
+}
+
 static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			 unsigned src, unsigned len)
 {
 	__be16 proto;
 	__be16 *s;
+	ushort block;
 	int i;
 
 	if (dest != tftp_our_port) {
@@ -491,6 +570,18 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("Blocksize ack: %s, %d\n",
 				      (char *)pkt + i + 8, tftp_block_size);
 			}
+			if (strcmp((char *)pkt + i, "windowsize") == 0) {
+				tftp_windowsize = (unsigned short)
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				/* The server may only lower our request */
+				if (!tftp_windowsize ||
+				    tftp_windowsize > tftp_windowsize_option)
+					tftp_windowsize =
+						tftp_windowsize_option;
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt + i + 11, tftp_windowsize);
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				tftp_tsize = simple_strtoul((char *)pkt + i + 6,
@@ -513,8 +604,15 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (len < 2)
 			return;
 		len -= 2;
-		tftp_cur_block = ntohs(*(__be16 *)pkt);
+		block = ntohs(*(__be16 *)pkt);
+
+		if (tftp_state == STATE_DATA && block != tftp_prev_block &&
+		    block != (ushort)(tftp_prev_block + 1)) {
+			tftp_window_gap(block);
+			break;
+		}
 
+		tftp_cur_block = block;
 		update_block_number();
 
 		if (tftp_state == STATE_SEND_RRQ)
@@ -553,13 +651,19 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		}
 
 		/*
-		 *	Acknowledge the block just received, which will prompt
-		 *	the remote for the next one.
+		 *	Acknowledge the last block of each window, which will
+		 *	prompt the remote for the next one. The final block is
+		 *	always acknowledged.
 		 */
-		tftp_send();
-
-		if (len < tftp_block_size)
+		if (len < tftp_block_size) {
+			tftp_send();
 			tftp_complete();
+		} else if (tftp_cur_block == tftp_next_ack) {
+			tftp_rx_direct();
+			tftp_send();
+			tftp_next_ack = (ushort)(tftp_next_ack +
+						 tftp_windowsize);
+		}
 		break;
 
 	case TFTP_ERROR:
@@ -595,6 +699,10 @@ static void tftp_timeout_handler(void)
 	} else {
 		puts("T ");
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+		/* the server restarts its window after our ACK */
+		if (tftp_state == STATE_DATA && !tftp_put_active)
+			tftp_next_ack = (ushort)(tftp_cur_block +
+						 tftp_windowsize);
 		if (tftp_state != STATE_RECV_WRQ)
 			tftp_send();
 	}
@@ -633,6 +741,22 @@ void tftp_start(enum proto_t protocol)
 	if (ep != NULL)
 		tftp_block_size_option = simple_strtol(ep, NULL, 10);
 
+	ep = env_get("tftpwindowsize");
+	if (ep != NULL) {
+		long windowsize = simple_strtol(ep, NULL, 10);
+
+		if (windowsize < 1) {
+			printf("TFTP window size (%ld) too low, set min = 1\n",
+			       windowsize);
+			windowsize = 1;
+		} else if (windowsize > TFTP_MAX_WINDOWSIZE) {
+			printf("TFTP window size (%ld) too high, set max = %d\n",
+			       windowsize, TFTP_MAX_WINDOWSIZE);
+			windowsize = TFTP_MAX_WINDOWSIZE;
+		}
+		tftp_windowsize_option = windowsize;
+	}
+
 	ep = env_get("tftptimeout");
 	if (ep != NULL)
 		timeout_ms = simple_strtol(ep, NULL, 10);
@@ -654,8 +778,8 @@ void tftp_start(enum proto_t protocol)
 	}
 #endif
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_windowsize_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (!net_parse_bootfile(&tftp_remote_ip, tftp_filename, MAX_LEN)) {
@@ -724,12 +848,14 @@ void tftp_start(enum proto_t protocol)
 		printf("Load address: 0x%lx\n", tftp_load_addr);
 		puts("Loading: *\b");
 		tftp_state = STATE_SEND_RRQ;
+		fit_stream_start(tftp_load_addr);
 #ifdef CONFIG_CMD_BOOTEFI
 		efi_set_bootdev("Net", "", tftp_filename);
 #endif
 	}
 
 	time_start = get_timer(0);
+	tftp_in_place = 0;
 	timeout_count_max = tftp_timeout_count_max;
 
 	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
@@ -754,8 +880,9 @@ void tftp_start(enum proto_t protocol)
 
 	/* zero out server ether in case the server ip has changed */
 	memset(net_server_ethaddr, 0, 6);
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_windowsize to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_windowsize = 1;
 #ifdef CONFIG_TFTP_TSIZE
 	tftp_tsize = 0;
 	tftp_tsize_num_hash = 0;
@@ -786,8 +913,9 @@ void tftp_start_server(void)
 	timeout_ms = TIMEOUT;
 	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_windowsize to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_windowsize = 1;
 	tftp_cur_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
 
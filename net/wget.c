@@ -0,0 +1,284 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * wget - load a file over HTTP
+ *
+ * This sends a single HTTP/1.1 GET and stores the body of the response at
+ * the load address as it arrives, in order, so that most segments can be
+ * received straight into place.
+ */
+
+#include <common.h>
+#include <env.h>
+#include <image.h>
+#include <mapmem.h>
+#include <net.h>
+#include "tcp.h"
+#include "wget.h"
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Longest response header we accept */
+#define WGET_HDR_MAX		2048
+/* Bytes loaded per hash mark */
+#define WGET_HASH_BYTES		0x10000
+#define HASHES_PER_LINE		65
+
+enum wget_state {
+	WGET_HEADER,		/* waiting for the end of the response header */
+	WGET_BODY,		/* storing the body */
+	WGET_DONE,		/* have it all, waiting for the connection to go */
+};
+
+static enum wget_state wget_state;
+static struct in_addr wget_server_ip;
+static char wget_path[256];
+static ulong wget_load_addr;
+static ulong wget_load_size;
+static char wget_hdr[WGET_HDR_MAX + 1];
+static int wget_hdr_len;	/* once complete, this is where the body starts */
+static ulong wget_content_len;
+static bool wget_have_len;
+static ulong wget_hashes;
+static ulong wget_time_start;
+
+static void wget_fail(const char *msg)
+{
+	printf("\nwget error: %s\n", msg);
+	tcp_abort();
+	net_set_state(NETLOOP_FAIL);
+}
+
+static void wget_complete(void)
+{
+	ulong time_taken = get_timer(wget_time_start);
+
+	if (time_taken > 0) {
+		puts("\n\t ");	/* Line up with "Loading: " */
+		print_size(net_boot_file_size / time_taken * 1000, "/s");
+	}
+	puts("\ndone\n");
+	fit_stream_end();
+	net_set_state(NETLOOP_SUCCESS);
+}
+
+/* Check the status line and pick out the headers we care about */
+static int wget_parse_header(void)
+{
+	char *line, *end;
+
+	end = strstr(wget_hdr, "\r\n");
+	*end = '\0';
+	if (strncmp(wget_hdr, "HTTP/1.", 7) || wget_hdr[8] != ' ' ||
+	    simple_strtoul(wget_hdr + 9, NULL, 10) != 200) {
+		printf("\nwget error: '%s'\n", wget_hdr);
+		return -ENOENT;
+	}
+
+	for (line = end + 2; *line; line = end + 2) {
+		end = strstr(line, "\r\n");
+		if (!end)
+			break;
+		*end = '\0';
+
+		if (!strncasecmp(line, "Content-Length:", 15)) {
+			for (line += 15; *line == ' '; line++)
+				;
+			wget_content_len = simple_strtoul(line, NULL, 10);
+			wget_have_len = true;
+		} else if (!strncasecmp(line, "Transfer-Encoding:", 18) &&
+			   strstr(line + 18, "chunked")) {
+			puts("\nwget error: chunked encoding is not supported\n");
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static void wget_store(ulong offset, uchar *data, int len)
+{
+	void *ptr;
+
+	if (wget_have_len && offset + len > wget_content_len)
+		len = wget_content_len - offset;
+#ifdef CONFIG_LMB
+	if (offset + len > wget_load_size) {
+		wget_fail("trying to overwrite reserved memory...");
+		return;
+	}
+#endif
+	ptr = map_sysmem(wget_load_addr + offset, len);
+	/* The data may have been received in place, or close to it */
+	if (ptr != data)
+		memmove(ptr, data, len);
+	unmap_sysmem(ptr);
+
+	net_boot_file_size = offset + len;
+	fit_stream_data(net_boot_file_size);
+	while (wget_hashes < net_boot_file_size / WGET_HASH_BYTES) {
+		putc('#');
+		if (!(++wget_hashes % HASHES_PER_LINE))
+			puts("\n\t ");
+	}
+
+	if (wget_have_len && net_boot_file_size == wget_content_len) {
+		wget_state = WGET_DONE;
+		tcp_close();
+	}
+}
+
+static void wget_rx(u32 offset, uchar *data, int len)
+{
+	if (!len) {
+		/* The server has sent everything */
+		if (wget_state == WGET_DONE)
+			return;
+		if (wget_state == WGET_HEADER || wget_have_len) {
+			wget_fail("connection closed early");
+			return;
+		}
+		wget_state = WGET_DONE;
+		tcp_close();
+		return;
+	}
+
+	if (wget_state == WGET_HEADER) {
+		int start = max(wget_hdr_len - 3, 0);
+		int n = min(len, WGET_HDR_MAX - wget_hdr_len);
+		char *end;
+
+		memcpy(wget_hdr + wget_hdr_len, data, n);
+		wget_hdr[wget_hdr_len + n] = '\0';
+		end = strstr(wget_hdr + start, "\r\n\r\n");
+		if (!end) {
+			wget_hdr_len += n;
+			if (wget_hdr_len == WGET_HDR_MAX)
+				wget_fail("response header too long");
+			return;
+		}
+		end[2] = '\0';
+		n = end + 4 - (wget_hdr + wget_hdr_len);
+		wget_hdr_len += n;
+		if (wget_parse_header()) {
+			tcp_abort();
+			net_set_state(NETLOOP_FAIL);
+			return;
+		}
+		wget_state = WGET_BODY;
+		data += n;
+		offset += n;
+		len -= n;
+		if (wget_have_len && !wget_content_len) {
+			wget_state = WGET_DONE;
+			tcp_close();
+			return;
+		}
+	}
+
+	if (wget_state == WGET_BODY && len)
+		wget_store(offset - wget_hdr_len, data, len);
+}
+
+static uchar *wget_rx_dest(u32 offset)
+{
+#ifdef CONFIG_LMB
+	ulong body = offset - wget_hdr_len;
+	int hdr_len = net_eth_hdr_size() + IP_TCP_HDR_SIZE;
+
+	if (wget_state != WGET_BODY || body < hdr_len ||
+	    body - hdr_len + PKTSIZE_ALIGN > wget_load_size)
+		return NULL;
+
+	return map_sysmem(wget_load_addr + body, 0);
+#else
+	return NULL;
+#endif
+}
+
+static void wget_closed(int err)
+{
+	/* Once we have the whole file, how the connection ends is not a worry */
+	if (wget_state == WGET_DONE) {
+		wget_complete();
+		return;
+	}
+	printf("\nwget error: connection %s\n",
+	       err == -ECONNREFUSED ? "refused" :
+	       err == -ETIMEDOUT ? "timed out" : "reset");
+	net_set_state(NETLOOP_FAIL);
+}
+
+static const struct tcp_ops wget_tcp_ops = {
+	.rx		= wget_rx,
+	.rx_dest	= wget_rx_dest,
+	.closed		= wget_closed,
+};
+
+/* Initialize wget_load_addr and wget_load_size from load_addr and lmb */
+static int wget_init_load_addr(void)
+{
+#ifdef CONFIG_LMB
+	struct lmb lmb;
+	phys_size_t max_size;
+
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+
+	max_size = lmb_get_free_size(&lmb, load_addr);
+	if (!max_size)
+		return -1;
+
+	wget_load_size = max_size;
+#endif
+	wget_load_addr = load_addr;
+	return 0;
+}
+
+void wget_start(void)
+{
+	char req[TCP_MSS];
+	int len;
+
+	wget_server_ip = net_server_ip;
+	if (!net_parse_bootfile(&wget_server_ip, wget_path,
+				sizeof(wget_path))) {
+		puts("*** ERROR: no file name given\n");
+		net_set_state(NETLOOP_FAIL);
+		return;
+	}
+	len = snprintf(req, sizeof(req),
+		       "GET %s%s HTTP/1.1\r\n"
+		       "Host: %pI4\r\n"
+		       "User-Agent: U-Boot\r\n"
+		       "Connection: close\r\n\r\n",
+		       *wget_path == '/' ? "" : "/", wget_path,
+		       &wget_server_ip);
+	if (len >= sizeof(req)) {
+		puts("*** ERROR: file name too long\n");
+		net_set_state(NETLOOP_FAIL);
+		return;
+	}
+
+	printf("Using %s device\n", eth_get_name());
+	printf("HTTP from server %pI4; our IP address is %pI4\n",
+	       &wget_server_ip, &net_ip);
+	printf("Filename '%s'.\n", wget_path);
+
+	if (wget_init_load_addr()) {
+		puts("\nwget error: trying to overwrite reserved memory...\n");
+		net_set_state(NETLOOP_FAIL);
+		return;
+	}
+	printf("Load address: 0x%lx\n", wget_load_addr);
+	puts("Loading: *\b");
+	fit_stream_start(wget_load_addr);
+
+	wget_state = WGET_HEADER;
+	wget_hdr_len = 0;
+	wget_content_len = 0;
+	wget_have_len = false;
+	wget_hashes = 0;
+	wget_time_start = get_timer(0);
+
+	tcp_connect(wget_server_ip, WGET_HTTP_PORT, &wget_tcp_ops);
+	tcp_send(req, len);
+}
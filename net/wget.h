@@ -0,0 +1,17 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * wget - load a file over HTTP
+ */
+
+#ifndef __WGET_H__
+#define __WGET_H__
+
+#define WGET_HTTP_PORT	80
+
+/*
+ * Start loading net_boot_file_name from the server to load_addr, with an
+ * HTTP/1.1 GET (beginning of netloop)
+ */
+void wget_start(void);
+
+#endif /* __WGET_H__ */
@@ -6,7 +6,9 @@
 #include <common.h>
 #include <bootm.h>
 #include <command.h>
+#include <decomp_stream.h>
 #include <gzip.h>
+#include <lz4.h>
 #include <malloc.h>
 #include <mapmem.h>
 #include <asm/io.h>
@@ -19,6 +21,7 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <linux/sizes.h>
 #include <test/compression.h>
 #include <test/suites.h>
 #include <test/ut.h>
@@ -118,6 +121,23 @@ static const char lz4_compressed[] =
 	"\x9d\x12\x8c\x9d";
 static const unsigned long lz4_compressed_size = 276;
 
+/* zstd -19 /tmp/plain.txt -o /tmp/plain.zst */
+static const char zstd_compressed[] =
+	"\x28\xb5\x2f\xfd\x64\x5e\x00\xad\x05\x00\x42\x4e\x26\x17\x90\x3b"
+	"\x07\x04\x5a\x13\x8b\xa7\x65\x34\x12\x21\x6d\xb0\x39\xbb\xae\xe8"
+	"\xba\xc9\xcd\x5e\x02\x49\xd0\x2b\xa9\xfa\x96\x92\xe7\x1f\x19\x19"
+	"\x7c\x8f\xf1\x9d\x54\x37\xfc\xd6\x0a\xf3\x0c\x93\x56\xc7\x52\x4f"
+	"\x0a\x62\x3e\xd1\xa5\x83\x17\x31\xab\x5d\x8f\x57\xf3\xcc\x3b\x58"
+	"\xf8\x91\x8c\xf1\x2a\x5c\x89\xdd\xf2\x9b\x15\xb7\x92\x5b\xbe\xba"
+	"\xab\xd5\xd1\x34\xdf\xf0\x02\x0e\x61\xcd\x7b\xd6\x01\xfc\xc2\xa7"
+	"\xd4\xd1\x3d\x26\x9c\x10\x49\xb8\x5b\xcd\xba\x7c\xf7\xac\x4b\xad"
+	"\xb7\x31\x1c\xbc\xf9\xcb\x62\x8e\x2e\x9b\x0f\xd3\x87\x57\x45\x12"
+	"\x16\xfa\x3a\x79\xde\x65\xf8\xcc\x48\xd5\x43\xa6\xbd\xc3\x91\x29"
+	"\x65\x29\xa7\x5b\x9a\x08\x08\x00\x60\x13\x00\x63\xa3\x8e\x28\x94"
+	"\x79\x41\x2a\x78\xc2\x91\x70\x9f\xaa\x6a\x21\x7a\xa1\xaa\x0c\xe4"
+	"\xf4\x6e\xfa";
+static const unsigned long zstd_compressed_size = 195;
+
 
 #define TEST_BUFFER_SIZE	512
 
@@ -293,6 +313,40 @@ static int uncompress_using_lz4(struct unit_test_state *uts,
 	return (ret != 0);
 }
 
+static int compress_using_zstd(struct unit_test_state *uts,
+			       void *in, unsigned long in_size,
+			       void *out, unsigned long out_max,
+			       unsigned long *out_size)
+{
+	/* There is no zstd compression in u-boot, so fake it. */
+	ut_asserteq(in_size, strlen(plain));
+	ut_asserteq(0, memcmp(plain, in, in_size));
+
+	if (zstd_compressed_size > out_max)
+		return -1;
+
+	memcpy(out, zstd_compressed, zstd_compressed_size);
+	if (out_size)
+		*out_size = zstd_compressed_size;
+
+	return 0;
+}
+
+static int uncompress_using_zstd(struct unit_test_state *uts,
+				 void *in, unsigned long in_size,
+				 void *out, unsigned long out_max,
+				 unsigned long *out_size)
+{
+	size_t output_size = out_max;
+	int ret;
+
+	ret = decomp_stream_buf(IH_COMP_ZSTD, out, &output_size, in, in_size);
+	if (out_size)
+		*out_size = output_size;
+
+	return (ret != 0);
+}
+
 #define errcheck(statement) if (!(statement)) { \
 	fprintf(stderr, "\tFailed: %s\n", #statement); \
 	ret = 1; \
@@ -437,6 +491,13 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+static int compression_test_zstd(struct unit_test_state *uts)
+{
+	return run_test(uts, "zstd", compress_using_zstd,
+			uncompress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_zstd, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
@@ -527,12 +588,214 @@ static int compression_test_bootm_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_bootm_lz4, 0);
 
+static int compression_test_bootm_zstd(struct unit_test_state *uts)
+{
+	return run_bootm_test(uts, IH_COMP_ZSTD, compress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_bootm_zstd, 0);
+
 static int compression_test_bootm_none(struct unit_test_state *uts)
 {
 	return run_bootm_test(uts, IH_COMP_NONE, compress_using_none);
 }
 COMPRESSION_TEST(compression_test_bootm_none, 0);
 
+/**
+ * run_stream_test() - Run tests on the streaming decompression functions
+ *
+ * The compressed data is fed in pieces of various sizes, down to a byte at a
+ * time, so that every header and block boundary falls inside a piece.
+ *
+ * @comp_type:	Compression type to test
+ * @compress:	Our function to compress data
+ * @return 0 if OK, non-zero on failure
+ */
+static int run_stream_test(struct unit_test_state *uts, int comp_type,
+			   mutate_func compress)
+{
+	static const int piece_sizes[] = { 1, 3, 16, TEST_BUFFER_SIZE };
+	char compressed[TEST_BUFFER_SIZE];
+	char out[TEST_BUFFER_SIZE];
+	unsigned long compressed_size;
+	ulong unc_len = strlen(plain);
+	struct decomp_stream ds;
+	size_t out_len, pos, len;
+	int i;
+
+	printf("Testing: %s\n", genimg_get_comp_name(comp_type));
+	ut_assert(decomp_stream_supported(comp_type));
+	ut_assertok(compress(uts, (void *)plain, unc_len, compressed,
+			     sizeof(compressed), &compressed_size));
+
+	for (i = 0; i < ARRAY_SIZE(piece_sizes); i++) {
+		memset(out, 'A', sizeof(out));
+		ut_assertok(decomp_stream_init(&ds, comp_type, out,
+					       sizeof(out)));
+		for (pos = 0; pos < compressed_size; pos += len) {
+			len = min((size_t)piece_sizes[i],
+				  compressed_size - pos);
+			ut_assertok(decomp_stream_feed(&ds, compressed + pos,
+						       len));
+		}
+		ut_assertok(decomp_stream_finish(&ds, &out_len));
+		ut_asserteq(unc_len, out_len);
+		ut_asserteq(0, memcmp(plain, out, unc_len));
+		ut_asserteq('A', out[unc_len]);
+	}
+
+	/* Pieces must follow on from each other */
+	ut_assertok(decomp_stream_init(&ds, comp_type, out, sizeof(out)));
+	ut_assertok(decomp_stream_feed(&ds, compressed, 1));
+	ut_asserteq(-EINVAL, decomp_stream_feed(&ds, compressed + 2, 1));
+	ut_asserteq(-EINVAL, decomp_stream_finish(&ds, &out_len));
+
+	/* Stopping early is an error */
+	ut_assertok(decomp_stream_init(&ds, comp_type, out, sizeof(out)));
+	ut_assertok(decomp_stream_feed(&ds, compressed, compressed_size / 2));
+	ut_assert(decomp_stream_finish(&ds, &out_len));
+
+	/* So is running out of space, without writing beyond the buffer */
+	memset(out, 'A', sizeof(out));
+	ut_assertok(decomp_stream_init(&ds, comp_type, out, unc_len - 1));
+	decomp_stream_feed(&ds, compressed, compressed_size);
+	ut_assert(decomp_stream_finish(&ds, &out_len));
+	ut_asserteq('A', out[unc_len - 1]);
+
+	return 0;
+}
+
+static int compression_test_stream_gzip(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_GZIP, compress_using_gzip);
+}
+COMPRESSION_TEST(compression_test_stream_gzip, 0);
+
+static int compression_test_stream_lzma(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_LZMA, compress_using_lzma);
+}
+COMPRESSION_TEST(compression_test_stream_lzma, 0);
+
+static int compression_test_stream_lz4(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_LZ4, compress_using_lz4);
+}
+COMPRESSION_TEST(compression_test_stream_lz4, 0);
+
+/* Decode an lz4 frame a block at a time, as the other cores would */
+static int compression_test_lz4_frame(struct unit_test_state *uts)
+{
+	char frame[TEST_BUFFER_SIZE];
+	ulong unc_len = strlen(plain);
+	char out[TEST_BUFFER_SIZE];
+	struct lz4_block blk;
+	struct lz4_frame f;
+	size_t out_len = 0;
+	int ret;
+
+	ut_asserteq(-EAGAIN, lz4_frame_init(&f, lz4_compressed, 6));
+	ut_assertok(lz4_frame_init(&f, lz4_compressed, lz4_compressed_size));
+	ut_assert(f.independent);
+	ut_assert(f.has_content_checksum);
+	ut_asserteq(SZ_4M, f.block_max);
+
+	memset(out, 'A', sizeof(out));
+	while ((ret = lz4_frame_next(&f, &blk)) > 0) {
+		ut_asserteq(out_len, blk.dst_offset);
+		ret = lz4_block_decode(&f, &blk, out, blk.dst_offset,
+				       sizeof(out));
+		ut_assert(ret > 0);
+		out_len += ret;
+	}
+	ut_assertok(ret);
+	ut_asserteq(1, f.blocks);
+	ut_asserteq(lz4_compressed_size, f.pos);
+	ut_assertok(lz4_frame_check(&f, out, out_len));
+	ut_asserteq(unc_len, out_len);
+	ut_asserteq(0, memcmp(plain, out, unc_len));
+	ut_asserteq('A', out[unc_len]);
+
+	/* A truncated block is waited for */
+	ut_assertok(lz4_frame_init(&f, lz4_compressed, 20));
+	ut_asserteq(-EAGAIN, lz4_frame_next(&f, &blk));
+
+	if (!IS_ENABLED(CONFIG_LZ4_CHECKSUM))
+		return 0;
+
+	/* The header and content checksums are checked */
+	memcpy(frame, lz4_compressed, lz4_compressed_size);
+	frame[6] ^= 1;
+	ut_asserteq(-EBADMSG, lz4_frame_init(&f, frame, lz4_compressed_size));
+	frame[6] ^= 1;
+	frame[lz4_compressed_size - 1] ^= 1;
+	out_len = sizeof(out);
+	ut_asserteq(-EBADMSG, decomp_stream_buf(IH_COMP_LZ4, out, &out_len,
+						frame, lz4_compressed_size));
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_frame, 0);
+
+/* Two stored 64KB blocks, the first of which is short */
+static const char lz4_short_block[] =
+	"\x04\x22\x4d\x18\x60\x40\x82"
+	"\x05\x00\x00\x80" "hello"
+	"\x06\x00\x00\x80" " world"
+	"\x00\x00\x00\x00";
+
+/* A short block sends the parallel decoder back to decoding in order */
+static int compression_test_lz4_short_block(struct unit_test_state *uts)
+{
+	const char *expect = "hello world";
+	size_t len = strlen(expect);
+	char out[TEST_BUFFER_SIZE];
+	struct lz4_frame f;
+	size_t out_len;
+
+	/* The second block lands past the end of an exact-size buffer */
+	ut_assertok(lz4_frame_init(&f, lz4_short_block,
+				   sizeof(lz4_short_block) - 1));
+	ut_assert(f.independent);
+	ut_asserteq(-EAGAIN, lz4_frame_decode_mp(&f, out, len, &out_len));
+
+	memset(out, 'A', sizeof(out));
+	out_len = len;
+	ut_assertok(ulz4fn(lz4_short_block, sizeof(lz4_short_block) - 1, out,
+			   &out_len));
+	ut_asserteq(len, out_len);
+	ut_asserteq_mem(expect, out, len);
+	ut_asserteq('A', out[len]);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_short_block, 0);
+
+static int compression_test_stream_zstd(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_ZSTD, compress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_stream_zstd, 0);
+
+/* zstd refuses a buffer smaller than the frame header says, before decoding */
+static int compression_test_stream_zstd_size(struct unit_test_state *uts)
+{
+	ulong unc_len = strlen(plain);
+	struct decomp_stream ds;
+	char out[TEST_BUFFER_SIZE];
+	size_t out_len;
+
+	memset(out, 'A', sizeof(out));
+	ut_assertok(decomp_stream_init(&ds, IH_COMP_ZSTD, out, unc_len - 1));
+	ut_asserteq(-ENOBUFS, decomp_stream_feed(&ds, zstd_compressed,
+						 zstd_compressed_size));
+	ut_asserteq(-ENOBUFS, decomp_stream_finish(&ds, &out_len));
+	ut_asserteq(0, out_len);
+	ut_asserteq('A', out[0]);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_stream_zstd_size, 0);
+
 int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	struct unit_test *tests = ll_entry_start(struct unit_test,
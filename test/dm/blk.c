@@ -162,3 +162,99 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+/* Test the block cache lookup, eviction and invalidation */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	struct block_cache_dev_stats dev_stats;
+	struct block_cache_stats stats;
+	char buf[512 * 2], out[512 * 2];
+	int i;
+
+	/* Start with an empty cache: 4 sets of 4 ways, 6 entries per device */
+	blkcache_configure(0, 0, 0);
+	blkcache_configure(2, 16, 6);
+	memset(buf, 0xaa, 512);
+	memset(buf + 512, 0x55, 512);
+
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 0, 10, 1, 512, out));
+	blkcache_fill(IF_TYPE_HOST, 0, 10, 2, 512, buf);
+	ut_asserteq(1, blkcache_read(IF_TYPE_HOST, 0, 10, 2, 512, out));
+	ut_asserteq_mem(buf, out, sizeof(buf));
+	ut_asserteq(1, blkcache_read(IF_TYPE_HOST, 0, 10, 1, 512, out));
+
+	/* Part of an entry is a hit too */
+	ut_asserteq(1, blkcache_read(IF_TYPE_HOST, 0, 11, 1, 512, out));
+	ut_asserteq_mem(buf + 512, out, 512);
+
+	/* The device and block size must match too */
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 1, 10, 1, 512, out));
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 0, 10, 1, 1024, out));
+
+	/* Too big to cache */
+	blkcache_fill(IF_TYPE_HOST, 0, 20, 3, 512, buf);
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 0, 20, 1, 512, out));
+
+	ut_assertok(blkcache_dev_stats(0, &dev_stats));
+	ut_asserteq(IF_TYPE_HOST, dev_stats.iftype);
+	ut_asserteq(0, dev_stats.devnum);
+	ut_asserteq(3, dev_stats.hits);
+	ut_asserteq(3, dev_stats.misses);
+	ut_asserteq(1, dev_stats.entries);
+	ut_asserteq(512 * 4, dev_stats.bytes_saved);
+	ut_assertok(blkcache_dev_stats(1, &dev_stats));
+	ut_asserteq(1, dev_stats.devnum);
+	ut_asserteq(0, dev_stats.hits);
+	ut_asserteq(1, dev_stats.misses);
+	ut_asserteq(-ENOENT, blkcache_dev_stats(2, &dev_stats));
+
+	blkcache_stats(&stats);
+	ut_asserteq(3, stats.hits);
+	ut_asserteq(4, stats.misses);
+	ut_asserteq(1, stats.entries);
+	ut_asserteq(4, stats.sets);
+	ut_asserteq(4, stats.ways);
+	ut_asserteq(512 * 4, stats.bytes_saved);
+
+	/* Writes only drop the blocks they overlap */
+	blkcache_fill(IF_TYPE_HOST, 0, 12, 2, 512, buf);
+	blkcache_invalidate_range(IF_TYPE_HOST, 0, 11, 1);
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 0, 10, 1, 512, out));
+	ut_asserteq(1, blkcache_read(IF_TYPE_HOST, 0, 12, 1, 512, out));
+
+	/* One device cannot take more than its share, with room to spare */
+	blkcache_configure(2, 64, 6);
+	for (i = 0; i < 16; i++)
+		blkcache_fill(IF_TYPE_HOST, 0, 100 + 2 * i, 1, 512, buf);
+	for (i = 0; i < 16; i++)
+		blkcache_fill(IF_TYPE_HOST, 1, 100 + 2 * i, 1, 512, buf);
+	ut_assertok(blkcache_dev_stats(0, &dev_stats));
+	ut_asserteq(6, dev_stats.entries);
+	ut_assertok(blkcache_dev_stats(1, &dev_stats));
+	ut_asserteq(6, dev_stats.entries);
+
+	/* The most recent fill is always present */
+	ut_asserteq(1, blkcache_read(IF_TYPE_HOST, 1, 130, 1, 512, out));
+
+	blkcache_invalidate(IF_TYPE_HOST, 1);
+	ut_assertok(blkcache_dev_stats(1, &dev_stats));
+	ut_asserteq(0, dev_stats.entries);
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 1, 130, 1, 512, out));
+
+	/* Sets are rounded up but the cache keeps to the size asked for */
+	blkcache_configure(2, 20, 0);
+	for (i = 0; i < 64; i++)
+		blkcache_fill(IF_TYPE_HOST, 0, 2 * i, 2, 512, buf);
+	blkcache_stats(&stats);
+	ut_asserteq(8, stats.sets);
+	ut_asserteq(20, stats.entries);
+	ut_asserteq(1, blkcache_read(IF_TYPE_HOST, 0, 127, 1, 512, out));
+
+	/* Put back the defaults */
+	blkcache_configure(8, 32, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache, 0);
+#endif
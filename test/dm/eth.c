@@ -11,7 +11,9 @@
 #include <env.h>
 #include <fdtdec.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <net.h>
+#include <time.h>
 #include <dm/test.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
@@ -429,3 +431,1229 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_eth_async_ping_reply, DM_TESTF_SCAN_FDT);
+
+static int dm_test_eth_rx_batch(struct unit_test_state *uts)
+{
+	struct eth_sandbox_priv *priv;
+	struct udevice *dev;
+	int i;
+
+	net_init();
+	env_set("ethact", "eth@10002000");
+	ut_assertok(eth_init());
+	dev = eth_get_dev();
+	ut_assertnonnull(dev);
+	priv = dev_get_priv(dev);
+
+	/* all waiting packets are received and freed in a single burst */
+	for (i = 0; i < PKTBUFSRX - 1; i++)
+		ut_assertok(sandbox_eth_recv_ping_req(dev));
+	ut_asserteq(PKTBUFSRX - 1, eth_rx());
+	ut_asserteq(0, priv->recv_packets);
+	ut_asserteq(0, eth_rx());
+
+	eth_halt();
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_rx_batch, DM_TESTF_SCAN_FDT);
+
+/* TFTP opcodes, see RFC 1350 and RFC 2347 */
+#define SB_TFTP_RRQ		1
+#define SB_TFTP_DATA		3
+#define SB_TFTP_ACK		4
+#define SB_TFTP_OACK		6
+
+/* UDP port the fake TFTP server answers from (its transfer ID) */
+#define SB_TFTP_TID		1069
+/*
+ * The sandbox driver hands out its receive queue in bursts and the client
+ * still holds the burst with the packet that triggers an ACK, so this is the
+ * largest window the queue can take in one go
+ */
+#define SB_TFTP_MAX_WINDOW	(PKTBUFSRX / 2)
+
+/**
+ * struct sb_tftp_server - state of the fake TFTP server
+ *
+ * data - file contents served for every read request
+ * size - size of the file in bytes
+ * blksize - negotiated block size
+ * windowsize - negotiated window size (RFC 7440)
+ * drop_block - block to drop once to simulate packet loss, 0 for none
+ * last_sent - last block sent in the current window
+ * acks - number of ACKs received
+ * nacks - number of ACKs received before the end of a window
+ * arp_requests - number of ARP requests received
+ * wrong_dest - number of packets not sent to the server's MAC address
+ * move_host - change the server's MAC address on the next read request,
+ *	announcing it with an ARP packet
+ */
+struct sb_tftp_server {
+	const uchar *data;
+	int size;
+	int blksize;
+	int windowsize;
+	int drop_block;
+	int last_sent;
+	int acks;
+	int nacks;
+	int arp_requests;
+	int wrong_dest;
+	bool move_host;
+};
+
+/* Queue a UDP reply from port @sport of the fake server to @req's sender */
+static void sb_udp_reply(struct udevice *dev, void *req, int sport,
+			 const void *data, int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = req;
+	struct ip_udp_hdr *ip = req + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+
+	if (priv->recv_packets >= PKTBUFSRX)
+		return;
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	net_set_ip_header((uchar *)ipr, net_read_ip(&ip->ip_src),
+			  net_read_ip(&ip->ip_dst), IP_UDP_HDR_SIZE + len,
+			  IPPROTO_UDP);
+	ipr->udp_src = htons(sport);
+	ipr->udp_dst = ip->udp_src;
+	ipr->udp_len = htons(UDP_HDR_SIZE + len);
+	ipr->udp_xsum = 0;
+	memcpy((uchar *)ipr + IP_UDP_HDR_SIZE, data, len);
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + len;
+	++priv->recv_packets;
+}
+
+/* Answer a read request with an OACK for the options we support */
+static void sb_tftp_rrq(struct udevice *dev, struct sb_tftp_server *srv,
+			void *req, const char *opt, const char *end)
+{
+	char oack[64];
+	char *p = oack;
+	int windowsize = 1;
+
+	*(__be16 *)p = htons(SB_TFTP_OACK);
+	p += 2;
+
+	/* skip the file name and the mode */
+	opt += strlen(opt) + 1;
+	opt += strlen(opt) + 1;
+	while (opt < end) {
+		const char *val = opt + strlen(opt) + 1;
+		int num = simple_strtol(val, NULL, 10);
+
+		if (!strcmp(opt, "blksize")) {
+			srv->blksize = min(srv->blksize, num);
+			p += sprintf(p, "blksize%c%d%c", 0, srv->blksize, 0);
+		} else if (!strcmp(opt, "windowsize")) {
+			windowsize = min(srv->windowsize, num);
+			p += sprintf(p, "windowsize%c%d%c", 0, windowsize, 0);
+		}
+		opt = val + strlen(val) + 1;
+	}
+	srv->windowsize = windowsize;
+
+	sb_udp_reply(dev, req, SB_TFTP_TID, oack, p - oack);
+}
+
+/* Send the window of data blocks following @block */
+static void sb_tftp_send_window(struct udevice *dev,
+				struct sb_tftp_server *srv, void *req,
+				int block)
+{
+	uchar buf[2 + 2 + 1468];
+	int i;
+
+	for (i = 1; i <= srv->windowsize; i++) {
+		int offset = (block + i - 1) * srv->blksize;
+		int len = min(srv->blksize, srv->size - offset);
+
+		if (offset > srv->size)
+			break;
+		srv->last_sent = block + i;
+		if (srv->last_sent == srv->drop_block) {
+			srv->drop_block = 0;
+			continue;
+		}
+		*(__be16 *)buf = htons(SB_TFTP_DATA);
+		*(__be16 *)(buf + 2) = htons(srv->last_sent);
+		memcpy(buf + 4, srv->data + offset, len);
+		sb_udp_reply(dev, req, SB_TFTP_TID, buf, len + 4);
+	}
+}
+
+static int sb_tftp_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_tftp_server *srv = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	uchar *pkt = (uchar *)ip + IP_UDP_HDR_SIZE;
+	int block;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len)) {
+		srv->arp_requests++;
+		return 0;
+	}
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+	if (memcmp(eth->et_dest, priv->fake_host_hwaddr, ARP_HLEN))
+		srv->wrong_dest++;
+
+	switch (ntohs(*(__be16 *)pkt)) {
+	case SB_TFTP_RRQ:
+		if (srv->move_host) {
+			priv->fake_host_hwaddr[ARP_HLEN - 1]++;
+			sandbox_eth_recv_arp_req(dev);
+			srv->move_host = false;
+		}
+		sb_tftp_rrq(dev, srv, packet, (char *)pkt + 2,
+			    (char *)packet + len);
+		break;
+	case SB_TFTP_ACK:
+		block = ntohs(*(__be16 *)(pkt + 2));
+		srv->acks++;
+		if (block != srv->last_sent)
+			srv->nacks++;
+		sb_tftp_send_window(dev, srv, packet, block);
+		break;
+	}
+
+	return 0;
+}
+
+/* Fetch the file served by @srv using the given client window size */
+static int sb_tftp_get(struct unit_test_state *uts,
+		       struct sb_tftp_server *srv, int windowsize)
+{
+	ulong start;
+
+	srv->blksize = 1024;
+	srv->windowsize = SB_TFTP_MAX_WINDOW;
+	srv->last_sent = 0;
+	srv->acks = 0;
+	srv->nacks = 0;
+	env_set_ulong("tftpwindowsize", windowsize);
+	memset(map_sysmem(load_addr, srv->size), '\0', srv->size);
+
+	start = get_timer(0);
+	ut_asserteq(srv->size, net_loop(TFTPGET));
+	printf("TFTP window %d: %d bytes, %d ACKs, %lu ms\n",
+	       srv->windowsize, srv->size, srv->acks, get_timer(start));
+
+	ut_asserteq_mem(srv->data, map_sysmem(load_addr, srv->size),
+			srv->size);
+	/* one ACK for the OACK, then one per window */
+	ut_asserteq(1 + DIV_ROUND_UP(srv->size / srv->blksize + 1,
+				     srv->windowsize) + srv->nacks,
+		    srv->acks);
+
+	return 0;
+}
+
+static int _dm_test_eth_tftp_window(struct unit_test_state *uts,
+				    struct sb_tftp_server *srv)
+{
+	struct eth_sandbox_priv *priv;
+	struct udevice *dev;
+	int i;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_ETH, "eth@10002000",
+					      &dev));
+	priv = dev_get_priv(dev);
+
+	/* windows larger than the server allows are negotiated down */
+	for (i = 1; i <= SB_TFTP_MAX_WINDOW + 1; i++) {
+		priv->recv_direct_packets = 0;
+		ut_assertok(sb_tftp_get(uts, srv, i));
+		ut_asserteq(min(i, SB_TFTP_MAX_WINDOW), srv->windowsize);
+		ut_asserteq(0, srv->nacks);
+		/* in lock-step every block after the first is received in place */
+		ut_asserteq(i == 1 ? srv->size / srv->blksize : 0,
+			    priv->recv_direct_packets);
+	}
+
+	/* out-of-range settings are clamped rather than truncated */
+	ut_assertok(sb_tftp_get(uts, srv, 0));
+	ut_asserteq(1, srv->windowsize);
+	ut_assertok(sb_tftp_get(uts, srv, 0x10001));
+	ut_asserteq(SB_TFTP_MAX_WINDOW, srv->windowsize);
+
+	/* a lost block is re-requested with a single early ACK */
+	srv->drop_block = 5;
+	ut_assertok(sb_tftp_get(uts, srv, SB_TFTP_MAX_WINDOW));
+	ut_asserteq(1, srv->nacks);
+
+	return 0;
+}
+
+static int dm_test_eth_tftp_window(struct unit_test_state *uts)
+{
+	struct sb_tftp_server srv;
+	ulong old_load_addr = load_addr;
+	uchar *data;
+	int retval;
+	int i;
+
+	memset(&srv, '\0', sizeof(srv));
+	srv.size = 64 * 1024 + 100;
+	data = malloc(srv.size);
+	ut_assertnonnull(data);
+	for (i = 0; i < srv.size; i++)
+		data[i] = i * 7 + (i >> 8);
+	srv.data = data;
+	srv.drop_block = 0;
+
+	sandbox_eth_set_tx_handler(0, sb_tftp_handler);
+	sandbox_eth_set_priv(0, &srv);
+	env_set("ethact", "eth@10002000");
+	net_server_ip = string_to_ip("1.1.2.2");
+	strcpy(net_boot_file_name, "sandbox.img");
+	env_set("tftpblocksize", "1024");
+	load_addr = 0x1000000;
+
+	retval = _dm_test_eth_tftp_window(uts, &srv);
+
+	/* Restore the env */
+	load_addr = old_load_addr;
+	env_set("tftpblocksize", NULL);
+	env_set("tftpwindowsize", NULL);
+	net_boot_file_name[0] = '\0';
+	net_server_ip.s_addr = 0;
+	sandbox_eth_set_tx_handler(0, NULL);
+	sandbox_eth_set_priv(0, NULL);
+	free(data);
+
+	return retval;
+}
+
+DM_TEST(dm_test_eth_tftp_window, DM_TESTF_SCAN_FDT);
+
+static int _dm_test_eth_arp_cache(struct unit_test_state *uts,
+				  struct sb_tftp_server *srv)
+{
+	char cmd[40];
+
+	/* the server is found once and then remembered */
+	ut_assertok(sb_tftp_get(uts, srv, 1));
+	ut_asserteq(1, srv->arp_requests);
+	ut_assertok(sb_tftp_get(uts, srv, 1));
+	ut_asserteq(1, srv->arp_requests);
+	ut_asserteq(0, srv->wrong_dest);
+
+	/* an ARP packet from the server updates its MAC address */
+	srv->move_host = true;
+	ut_assertok(sb_tftp_get(uts, srv, 1));
+	srv->wrong_dest = 0;
+	ut_assertok(sb_tftp_get(uts, srv, 1));
+	ut_asserteq(1, srv->arp_requests);
+	ut_asserteq(0, srv->wrong_dest);
+
+	/* setting our IP address forgets everything */
+	snprintf(cmd, sizeof(cmd), "setenv ipaddr %s", env_get("ipaddr"));
+	ut_assertok(run_command(cmd, 0));
+	ut_assertok(sb_tftp_get(uts, srv, 1));
+	ut_asserteq(2, srv->arp_requests);
+	ut_asserteq(0, srv->wrong_dest);
+
+	return 0;
+}
+
+static int dm_test_eth_arp_cache(struct unit_test_state *uts)
+{
+	struct sb_tftp_server srv;
+	ulong old_load_addr = load_addr;
+	uchar data[3000];
+	int retval;
+	int i;
+
+	memset(&srv, '\0', sizeof(srv));
+	srv.size = sizeof(data);
+	for (i = 0; i < srv.size; i++)
+		data[i] = i;
+	srv.data = data;
+
+	sandbox_eth_set_tx_handler(0, sb_tftp_handler);
+	sandbox_eth_set_priv(0, &srv);
+	env_set("ethact", "eth@10002000");
+	net_server_ip = string_to_ip("1.1.2.2");
+	strcpy(net_boot_file_name, "sandbox.img");
+	env_set("tftpblocksize", "1024");
+	load_addr = 0x1000000;
+	arp_cache_flush();
+
+	retval = _dm_test_eth_arp_cache(uts, &srv);
+
+	/* Restore the env */
+	load_addr = old_load_addr;
+	env_set("tftpblocksize", NULL);
+	env_set("tftpwindowsize", NULL);
+	net_boot_file_name[0] = '\0';
+	net_server_ip.s_addr = 0;
+	sandbox_eth_set_tx_handler(0, NULL);
+	sandbox_eth_set_priv(0, NULL);
+
+	return retval;
+}
+
+DM_TEST(dm_test_eth_arp_cache, DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_CMD_NFS
+/* ONC RPC values the fake NFS server uses, see RFC 5531, 1094 and 1813 */
+#define SB_RPC_REPLY		1
+#define SB_RPC_PROG_MISMATCH	2
+#define SB_PROG_PORTMAP		100000
+#define SB_PROG_NFS		100003
+#define SB_PROG_MOUNT		100005
+#define SB_MOUNT_MNT		1
+#define SB_NFS_READ		6	/* the same in NFSv2 and NFSv3 */
+
+#define SB_NFS_MOUNT_PORT	635
+#define SB_NFS_PORT		2049
+#define SB_NFS_FHSIZE		32
+#define SB_NFS_READ_SIZE	1024
+/* Words in a call before the arguments: header and AUTH_UNIX credentials */
+#define SB_RPC_CALL_WORDS	(6 + 9)
+
+/**
+ * struct sb_nfs_server - state of the fake NFS server
+ *
+ * data - contents of the one file it serves
+ * size - size of the file in bytes
+ * v3_only - answer NFSv2 requests with a version mismatch
+ * pair_reads - hold each other READ back and answer it after the next one,
+ *	so that a client with fewer than two READs in flight gets stuck
+ * drop_read - READ to drop once to simulate packet loss, 0 for none
+ * short_read - offset of a READ to answer with half the data, 0 for none
+ * attr_size - file size to give in the attributes of an NFSv3 LOOKUP reply,
+ *	0 to leave the attributes out
+ * reads - number of READs received
+ * vers - NFS version of the last READ
+ * resends - number of READs received with an XID seen before
+ * max_xid - highest XID of a READ so far
+ * held - READ held back by @pair_reads
+ * held_len - length of @held, 0 if nothing is held
+ */
+struct sb_nfs_server {
+	const uchar *data;
+	int size;
+	bool v3_only;
+	bool pair_reads;
+	int drop_read;
+	int short_read;
+	u64 attr_size;
+	int reads;
+	int vers;
+	int resends;
+	u32 max_xid;
+	uchar held[256];
+	int held_len;
+};
+
+/* Fill in the header of a successful reply to the call with ID @xid */
+static __be32 *sb_rpc_reply_hdr(__be32 *buf, __be32 xid)
+{
+	buf[0] = xid;
+	buf[1] = htonl(SB_RPC_REPLY);
+	buf[2] = 0;		/* accepted */
+	buf[3] = 0;		/* AUTH_NONE verifier */
+	buf[4] = 0;
+	buf[5] = 0;		/* success */
+
+	return buf + 6;
+}
+
+/* Answer the READ in @req, in either NFS version */
+static void sb_nfs_read_reply(struct udevice *dev, struct sb_nfs_server *srv,
+			      void *req)
+{
+	struct ip_udp_hdr *ip = req + ETHER_HDR_SIZE;
+	__be32 *call = (void *)ip + IP_UDP_HDR_SIZE;
+	__be32 *args = call + SB_RPC_CALL_WORDS;
+	bool v2 = ntohl(call[4]) == 2;
+	__be32 buf[32 + SB_NFS_READ_SIZE / 4];
+	__be32 *p;
+	u64 offset;
+	u32 count;
+
+	if (v2) {
+		offset = ntohl(args[SB_NFS_FHSIZE / 4]);
+		count = ntohl(args[SB_NFS_FHSIZE / 4 + 1]);
+	} else {
+		args += 1 + ntohl(args[0]) / 4;
+		offset = (u64)ntohl(args[0]) << 32 | ntohl(args[1]);
+		count = ntohl(args[2]);
+	}
+	count = min(count, (u32)SB_NFS_READ_SIZE);
+	count = offset < srv->size ? min(count, (u32)(srv->size - offset)) : 0;
+	if (srv->short_read && offset == srv->short_read) {
+		srv->short_read = 0;
+		count /= 2;
+	}
+
+	p = sb_rpc_reply_hdr(buf, call[0]);
+	*p++ = 0;			/* status */
+	if (v2) {
+		memset(p, '\0', 17 * sizeof(*p));	/* attributes */
+		p += 17;
+		*p++ = htonl(count);
+	} else {
+		*p++ = 0;		/* no attributes follow */
+		*p++ = htonl(count);
+		*p++ = htonl(offset + count >= srv->size);	/* EOF */
+		*p++ = htonl(count);
+	}
+	memcpy(p, srv->data + offset, count);
+	sb_udp_reply(dev, req, ntohs(ip->udp_dst), buf,
+		     (void *)p - (void *)buf + count);
+}
+
+static void sb_nfs_read(struct udevice *dev, struct sb_nfs_server *srv,
+			void *req, unsigned int len)
+{
+	__be32 *call = req + ETHER_HDR_SIZE + IP_UDP_HDR_SIZE;
+	u32 xid = ntohl(call[0]);
+
+	srv->reads++;
+	srv->vers = ntohl(call[4]);
+	if (xid <= srv->max_xid)
+		srv->resends++;
+	else
+		srv->max_xid = xid;
+
+	if (srv->reads == srv->drop_read) {
+		/* nothing else is coming, so do not wait long for the timeout */
+		srv->drop_read = 0;
+		sandbox_eth_skip_timeout();
+		return;
+	}
+	if (srv->pair_reads && !srv->held_len && len <= sizeof(srv->held)) {
+		memcpy(srv->held, req, len);
+		srv->held_len = len;
+		return;
+	}
+	sb_nfs_read_reply(dev, srv, req);
+	if (srv->held_len) {
+		sb_nfs_read_reply(dev, srv, srv->held);
+		srv->held_len = 0;
+	}
+}
+
+static int sb_nfs_handler(struct udevice *dev, void *packet,
+			  unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_nfs_server *srv = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	__be32 *call = packet + ETHER_HDR_SIZE + IP_UDP_HDR_SIZE;
+	__be32 buf[48];
+	__be32 *p;
+	u32 prog, proc;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	prog = ntohl(call[3]);
+	proc = ntohl(call[5]);
+	p = sb_rpc_reply_hdr(buf, call[0]);
+	switch (prog) {
+	case SB_PROG_PORTMAP:
+		/* the program asked for follows the (empty) credentials */
+		*p++ = htonl(ntohl(call[6 + 4]) == SB_PROG_MOUNT ?
+			     SB_NFS_MOUNT_PORT : SB_NFS_PORT);
+		break;
+	case SB_PROG_MOUNT:
+		*p++ = 0;		/* status */
+		if (proc == SB_MOUNT_MNT) {
+			memset(p, 0x11, SB_NFS_FHSIZE);
+			p += SB_NFS_FHSIZE / 4;
+		}
+		break;
+	case SB_PROG_NFS:
+		if (ntohl(call[4]) == 2 && srv->v3_only) {
+			buf[5] = htonl(SB_RPC_PROG_MISMATCH);
+			*p++ = htonl(3);	/* lowest version */
+			*p++ = htonl(3);	/* highest version */
+			break;
+		}
+		if (proc == SB_NFS_READ) {
+			sb_nfs_read(dev, srv, packet, len);
+			return 0;
+		}
+		/* anything else is a LOOKUP */
+		*p++ = 0;		/* status */
+		if (ntohl(call[4]) == 3)
+			*p++ = htonl(SB_NFS_FHSIZE);
+		memset(p, 0x22, SB_NFS_FHSIZE);
+		p += SB_NFS_FHSIZE / 4;
+		if (ntohl(call[4]) == 3 && srv->attr_size) {
+			*p++ = htonl(1);	/* attributes follow */
+			memset(p, '\0', 21 * sizeof(*p));
+			p[5] = htonl(srv->attr_size >> 32);
+			p[6] = htonl((u32)srv->attr_size);
+			p += 21;
+		}
+		break;
+	default:
+		return 0;
+	}
+	sb_udp_reply(dev, packet, ntohs(ip->udp_dst), buf,
+		     (void *)p - (void *)buf);
+
+	return 0;
+}
+
+/* Fetch the file served by @srv using the given READ window */
+static int sb_nfs_get(struct unit_test_state *uts,
+		      struct sb_nfs_server *srv, int window)
+{
+	ulong start;
+
+	srv->reads = 0;
+	srv->resends = 0;
+	srv->max_xid = 0;
+	srv->held_len = 0;
+	env_set_ulong("nfswindowsize", window);
+	memset(map_sysmem(load_addr, srv->size), '\0', srv->size);
+
+	start = get_timer(0);
+	ut_asserteq(srv->size, net_loop(NFS));
+	printf("NFS window %d: %d bytes, %d READs, %lu ms\n", window,
+	       srv->size, srv->reads, get_timer(start));
+
+	ut_asserteq_mem(srv->data, map_sysmem(load_addr, srv->size),
+			srv->size);
+
+	return 0;
+}
+
+static int _dm_test_eth_nfs(struct unit_test_state *uts,
+			    struct sb_nfs_server *srv)
+{
+	int blocks = DIV_ROUND_UP(srv->size, SB_NFS_READ_SIZE);
+	struct eth_sandbox_priv *priv;
+	bool v2;
+	struct udevice *dev;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_ETH, "eth@10002000",
+					      &dev));
+	priv = dev_get_priv(dev);
+
+	/*
+	 * The client keeps to NFSv3 once a server has asked for it, so this
+	 * starts with NFSv2 only on the first run. NFSv2 has no end-of-file
+	 * flag, so there the short last block is followed by a READ of the
+	 * rest, which comes back empty. One READ at a time, every full block
+	 * after the first is received in place.
+	 */
+	priv->recv_direct_packets = 0;
+	ut_assertok(sb_nfs_get(uts, srv, 1));
+	v2 = srv->vers == 2;
+	ut_asserteq(blocks + v2, srv->reads);
+	ut_asserteq(blocks - 1, priv->recv_direct_packets);
+
+	/* with two READs in flight one more may go past the end */
+	ut_assertok(sb_nfs_get(uts, srv, 2));
+	ut_assert(srv->reads <= blocks + v2 + 1);
+	ut_asserteq(0, srv->resends);
+
+	/* a lost reply is asked for again with the same XID */
+	srv->drop_read = 5;
+	ut_assertok(sb_nfs_get(uts, srv, 1));
+	ut_asserteq(blocks + v2 + 1, srv->reads);
+	ut_asserteq(1, srv->resends);
+
+	/* NFSv3 marks the end of the file, so nothing past it is read */
+	srv->v3_only = true;
+	ut_assertok(sb_nfs_get(uts, srv, 1));
+	ut_asserteq(3, srv->vers);
+	ut_asserteq(blocks, srv->reads);
+
+	/* replies in any order are matched to their READs */
+	srv->pair_reads = true;
+	ut_assertok(sb_nfs_get(uts, srv, 2));
+	ut_asserteq(0, srv->resends);
+	srv->pair_reads = false;
+
+	/* a short read is followed by a READ of the rest of the block */
+	srv->short_read = 3 * SB_NFS_READ_SIZE;
+	ut_assertok(sb_nfs_get(uts, srv, 1));
+	ut_asserteq(blocks + 1, srv->reads);
+	ut_asserteq(0, srv->short_read);
+
+	/* the size in the attributes is checked */
+	srv->attr_size = srv->size;
+	ut_assertok(sb_nfs_get(uts, srv, 2));
+
+	/*
+	 * a file which net_loop() cannot report the size of is refused
+	 * before anything is read
+	 */
+	srv->attr_size = 0x100000000ULL + srv->size;
+	srv->reads = 0;
+	ut_assert(net_loop(NFS) < 0);
+	ut_asserteq(0, srv->reads);
+	srv->attr_size = 0;
+
+	return 0;
+}
+
+static int dm_test_eth_nfs(struct unit_test_state *uts)
+{
+	struct sb_nfs_server srv;
+	ulong old_load_addr = load_addr;
+	uchar *data;
+	int retval;
+	int i;
+
+	memset(&srv, '\0', sizeof(srv));
+	srv.size = 20 * SB_NFS_READ_SIZE + 100;
+	data = malloc(srv.size);
+	ut_assertnonnull(data);
+	for (i = 0; i < srv.size; i++)
+		data[i] = i * 7 + (i >> 8);
+	srv.data = data;
+
+	sandbox_eth_set_tx_handler(0, sb_nfs_handler);
+	sandbox_eth_set_priv(0, &srv);
+	env_set("ethact", "eth@10002000");
+	net_server_ip = string_to_ip("1.1.2.2");
+	strcpy(net_boot_file_name, "/export/sandbox.img");
+	load_addr = 0x1000000;
+
+	retval = _dm_test_eth_nfs(uts, &srv);
+
+	/* Restore the env */
+	load_addr = old_load_addr;
+	env_set("nfswindowsize", NULL);
+	net_boot_file_name[0] = '\0';
+	net_server_ip.s_addr = 0;
+	sandbox_eth_set_tx_handler(0, NULL);
+	sandbox_eth_set_priv(0, NULL);
+	free(data);
+
+	return retval;
+}
+
+DM_TEST(dm_test_eth_nfs, DM_TESTF_SCAN_FDT);
+#endif /* CONFIG_CMD_NFS */
+
+#ifdef CONFIG_IP_DEFRAG
+#define SB_FRAG_SIZE		1480
+#define SB_FRAG_DGRAM_SIZE	3000
+
+static uchar sb_defrag_data[SB_FRAG_DGRAM_SIZE];
+/* Bytes of the datagram carried by each fragment but the last */
+static int sb_defrag_frag_size;
+static int sb_defrag_received;
+static int sb_defrag_len;
+static u8 sb_defrag_first;
+
+static void sb_defrag_handler(uchar *pkt, unsigned int dport,
+			      struct in_addr sip, unsigned int sport,
+			      unsigned int len)
+{
+	sb_defrag_received++;
+	sb_defrag_len = len;
+	sb_defrag_first = *pkt;
+	if (len == SB_FRAG_DGRAM_SIZE - UDP_HDR_SIZE &&
+	    memcmp(pkt + 1, sb_defrag_data + UDP_HDR_SIZE + 1, len - 1))
+		sb_defrag_len = -1;
+}
+
+/*
+ * Pass fragment @frag of a UDP datagram of SB_FRAG_DGRAM_SIZE bytes to the
+ * network stack, as if it had come from @src with IP ID @id. The first byte
+ * of the UDP payload is @tag, so the datagrams can be told apart.
+ */
+static void sb_defrag_rx(struct in_addr src, u16 id, u8 tag, int frag)
+{
+	uchar pkt[ETHER_HDR_SIZE + IP_HDR_SIZE + SB_FRAG_SIZE];
+	struct ethernet_hdr *eth = (void *)pkt;
+	struct ip_udp_hdr *ip = (void *)pkt + ETHER_HDR_SIZE;
+	__be16 *udp = (__be16 *)sb_defrag_data;
+	int offset = frag * sb_defrag_frag_size;
+	int len = min(sb_defrag_frag_size, SB_FRAG_DGRAM_SIZE - offset);
+	bool more = offset + len < SB_FRAG_DGRAM_SIZE;
+
+	udp[0] = htons(1234);			/* source port */
+	udp[1] = htons(4321);			/* destination port */
+	udp[2] = htons(SB_FRAG_DGRAM_SIZE);	/* length */
+	udp[3] = 0;				/* no checksum */
+	sb_defrag_data[UDP_HDR_SIZE] = tag;
+
+	memcpy(eth->et_dest, net_ethaddr, ARP_HLEN);
+	memset(eth->et_src, 0x55, ARP_HLEN);
+	eth->et_protlen = htons(PROT_IP);
+	net_set_ip_header((uchar *)ip, net_ip, src, IP_HDR_SIZE + len,
+			  IPPROTO_UDP);
+	ip->ip_id = htons(id);
+	ip->ip_off = htons(offset / 8 | (more ? IP_FLAGS_MFRAG : 0));
+	ip->ip_sum = 0;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+	memcpy((uchar *)ip + IP_HDR_SIZE, sb_defrag_data + offset, len);
+
+	net_process_received_packet(pkt, ETHER_HDR_SIZE + IP_HDR_SIZE + len);
+}
+
+/* Let any datagrams left half-done time out, then reset the counters */
+static void sb_defrag_flush(struct in_addr src)
+{
+	int i;
+
+	timer_test_add_offset(CONFIG_NET_DEFRAG_TIMEOUT + 1);
+	for (i = 0; i < 3; i++)
+		sb_defrag_rx(src, 99, 'z', i);
+	sb_defrag_received = 0;
+	memset(&net_stats, '\0', sizeof(net_stats));
+}
+
+static int dm_test_eth_defrag(struct unit_test_state *uts)
+{
+	struct in_addr src1 = string_to_ip("1.1.2.2");
+	struct in_addr src2 = string_to_ip("1.1.2.3");
+	int i;
+
+	for (i = 0; i < SB_FRAG_DGRAM_SIZE; i++)
+		sb_defrag_data[i] = i * 7 + (i >> 8);
+	net_set_udp_handler(sb_defrag_handler);
+	sb_defrag_frag_size = SB_FRAG_SIZE;
+	sb_defrag_flush(src1);
+
+	/* fragments of two datagrams arriving interleaved, in any order */
+	for (i = 0; i < 3; i++) {
+		sb_defrag_rx(src1, 1, 'a', i);
+		sb_defrag_rx(src1, 2, 'b', 2 - i);
+	}
+	ut_asserteq(2, sb_defrag_received);
+	ut_asserteq(SB_FRAG_DGRAM_SIZE - UDP_HDR_SIZE, sb_defrag_len);
+	ut_asserteq(2, net_stats.frag_reassembled);
+
+	/* the same IP ID from another host is another datagram */
+	sb_defrag_rx(src1, 3, 'a', 0);
+	sb_defrag_rx(src2, 3, 'b', 0);
+	sb_defrag_rx(src2, 3, 'b', 1);
+	sb_defrag_rx(src2, 3, 'b', 2);
+	ut_asserteq(3, sb_defrag_received);
+	ut_asserteq('b', sb_defrag_first);
+	sb_defrag_rx(src1, 3, 'a', 2);
+	sb_defrag_rx(src1, 3, 'a', 1);
+	ut_asserteq(4, sb_defrag_received);
+	ut_asserteq('a', sb_defrag_first);
+	ut_asserteq(SB_FRAG_DGRAM_SIZE - UDP_HDR_SIZE, sb_defrag_len);
+
+	/* a datagram missing a fragment is dropped after the timeout */
+	sb_defrag_rx(src1, 4, 'a', 0);
+	sb_defrag_rx(src1, 4, 'a', 1);
+	timer_test_add_offset(CONFIG_NET_DEFRAG_TIMEOUT + 1);
+	sb_defrag_rx(src1, 4, 'a', 2);
+	ut_asserteq(4, sb_defrag_received);
+	ut_asserteq(1, net_stats.frag_timed_out);
+
+	/* with every buffer in use the oldest datagram makes way */
+	sb_defrag_flush(src1);
+	for (i = 0; i <= CONFIG_NET_DEFRAG_SLOTS; i++) {
+		sb_defrag_rx(src1, 10 + i, 'c', 0);
+		timer_test_add_offset(1);
+	}
+	ut_asserteq(1, net_stats.frag_dropped);
+	for (i = 1; i <= CONFIG_NET_DEFRAG_SLOTS; i++) {
+		sb_defrag_rx(src1, 10 + i, 'c', 1);
+		sb_defrag_rx(src1, 10 + i, 'c', 2);
+	}
+	ut_asserteq(CONFIG_NET_DEFRAG_SLOTS, sb_defrag_received);
+	sb_defrag_rx(src1, 10, 'c', 1);
+	sb_defrag_rx(src1, 10, 'c', 2);
+	ut_asserteq(CONFIG_NET_DEFRAG_SLOTS, sb_defrag_received);
+	ut_asserteq(CONFIG_NET_DEFRAG_SLOTS, net_stats.frag_reassembled);
+	ut_asserteq(3 * (CONFIG_NET_DEFRAG_SLOTS + 1), net_stats.frag_rx);
+	ut_asserteq(0, net_stats.frag_timed_out);
+
+	/* fragments other than the last must be a multiple of 8 bytes */
+	sb_defrag_frag_size = SB_FRAG_SIZE - 4;
+	sb_defrag_rx(src1, 20, 'd', 0);
+	ut_asserteq(2, net_stats.frag_dropped);
+
+	net_set_udp_handler(NULL);
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_defrag, 0);
+#endif /* CONFIG_IP_DEFRAG */
+
+#ifdef CONFIG_CMD_WGET
+/* Initial sequence number of the fake HTTP server, chosen to wrap early */
+#define SB_HTTP_ISN		0xfffff000
+#define SB_HTTP_MSS		1460
+
+/**
+ * struct sb_http_server - state of the fake HTTP server
+ *
+ * data - file contents served for every GET request
+ * size - size of the file in bytes
+ * status - HTTP status to answer with
+ * no_length - leave out Content-Length, so the file ends when the server
+ *	closes the connection
+ * drop_seg - response segment to drop once to simulate packet loss
+ *	(counting from 1), 0 for none
+ * hdr - response header
+ * hdr_len - length of the response header
+ * port - TCP port of the client
+ * rcv_nxt - next sequence number expected from the client
+ * snd_una - first byte of the response not acknowledged, from 0
+ * snd_nxt - next byte of the response to send
+ * resent - snd_una when the server last went back to resend, else -1
+ * wscale - window scale asked for by the client
+ * window - receive window last advertised by the client, in bytes
+ * segments - number of response segments sent
+ * resends - number of times the server went back to resend
+ * acks - number of segments from the client with just an ACK
+ * request_ok - the client sent the expected request
+ * closed - the client has closed its side of the connection
+ */
+struct sb_http_server {
+	const uchar *data;
+	int size;
+	int status;
+	bool no_length;
+	int drop_seg;
+	char hdr[128];
+	int hdr_len;
+	int port;
+	u32 rcv_nxt;
+	int snd_una;
+	int snd_nxt;
+	int resent;
+	int wscale;
+	int window;
+	int segments;
+	int resends;
+	int acks;
+	bool request_ok;
+	bool closed;
+};
+
+static u16 sb_tcp_checksum(struct ip_tcp_hdr *ip, int len)
+{
+	struct {
+		struct in_addr src;
+		struct in_addr dest;
+		u8 zero;
+		u8 proto;
+		u16 len;
+	} __packed phdr;
+
+	phdr.src = ip->ip_src;
+	phdr.dest = ip->ip_dst;
+	phdr.zero = 0;
+	phdr.proto = IPPROTO_TCP;
+	phdr.len = htons(len);
+
+	return add_ip_checksums(sizeof(phdr),
+				compute_ip_checksum(&phdr, sizeof(phdr)),
+				compute_ip_checksum((uchar *)ip + IP_HDR_SIZE,
+						    len));
+}
+
+/*
+ * Queue a TCP segment from the fake server to the sender of @req, carrying
+ * @len bytes of the response from @offset
+ */
+static void sb_http_reply(struct udevice *dev, struct sb_http_server *srv,
+			  void *req, u8 flags, int offset, int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = req;
+	struct ip_tcp_hdr *ip = req + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_tcp_hdr *ipr;
+	int hdr_len = TCP_HDR_SIZE;
+	uchar *p;
+
+	if (priv->recv_packets >= PKTBUFSRX)
+		return;
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	p = (uchar *)ipr + IP_TCP_HDR_SIZE;
+	if (flags & TCP_SYN) {
+		/* MSS, then window scaling with a shift of 0 */
+		memcpy(p, "\x02\x04\x05\xb4\x01\x03\x03\x00", 8);
+		hdr_len += 8;
+	} else if (len) {
+		int hlen = min(len, max(srv->hdr_len - offset, 0));
+
+		memcpy(p, srv->hdr + offset, hlen);
+		memcpy(p + hlen, srv->data + offset + hlen - srv->hdr_len,
+		       len - hlen);
+	}
+	net_set_ip_header((uchar *)ipr, net_read_ip(&ip->ip_src),
+			  net_read_ip(&ip->ip_dst),
+			  IP_HDR_SIZE + hdr_len + len, IPPROTO_TCP);
+	ipr->tcp_src = ip->tcp_dst;
+	ipr->tcp_dst = ip->tcp_src;
+	ipr->tcp_seq = htonl(SB_HTTP_ISN + (flags & TCP_SYN ? 0 : 1 + offset));
+	ipr->tcp_ack = htonl(srv->rcv_nxt);
+	ipr->tcp_hlen = (hdr_len / 4) << 4;
+	ipr->tcp_flags = flags;
+	ipr->tcp_win = htons(0x4000);
+	ipr->tcp_xsum = 0;
+	ipr->tcp_urg = 0;
+	ipr->tcp_xsum = sb_tcp_checksum(ipr, hdr_len + len);
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_HDR_SIZE + hdr_len + len;
+	++priv->recv_packets;
+}
+
+/*
+ * Send the next two segments of the response, within the client's window.
+ * Sending two for each ACK leaves room in the receive queue to answer the
+ * ACK that the client sends while it still holds the first two.
+ */
+static int sb_http_send(struct udevice *dev, struct sb_http_server *srv,
+			void *req)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	int total = srv->hdr_len + srv->size;
+	int count;
+
+	for (count = 0; count < 2 && priv->recv_packets < PKTBUFSRX;) {
+		int offset = srv->snd_nxt;
+		int len = min(SB_HTTP_MSS, total - offset);
+
+		if (offset == total) {
+			sb_http_reply(dev, srv, req, TCP_FIN | TCP_ACK, offset,
+				      0);
+			srv->snd_nxt++;
+			count++;
+			break;
+		} else if (offset > total ||
+			   offset + len - srv->snd_una > srv->window) {
+			break;
+		}
+		srv->snd_nxt += len;
+		count++;
+		if (++srv->segments == srv->drop_seg) {
+			srv->drop_seg = 0;
+			continue;
+		}
+		sb_http_reply(dev, srv, req, TCP_ACK | TCP_PUSH, offset, len);
+	}
+
+	return count;
+}
+
+static int sb_http_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_http_server *srv = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_tcp_hdr *ip = packet + ETHER_HDR_SIZE;
+	int hdr_len = (ip->tcp_hlen >> 4) * 4;
+	uchar *data = (uchar *)ip + IP_HDR_SIZE + hdr_len;
+	int data_len = ntohs(ip->ip_len) - IP_HDR_SIZE - hdr_len;
+	int ack = ntohl(ip->tcp_ack) - SB_HTTP_ISN - 1;
+	u8 flags = ip->tcp_flags;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_TCP)
+		return 0;
+	/* A bad checksum would show up as a failure to fetch the file */
+	if (sb_tcp_checksum(ip, ntohs(ip->ip_len) - IP_HDR_SIZE))
+		return 0;
+	if (flags & TCP_RST)
+		return 0;
+
+	if (flags & TCP_SYN) {
+		uchar *opt = (uchar *)ip + IP_TCP_HDR_SIZE;
+
+		srv->port = ntohs(ip->tcp_src);
+		srv->rcv_nxt = ntohl(ip->tcp_seq) + 1;
+		srv->snd_una = 0;
+		srv->snd_nxt = 0;
+		srv->resent = -1;
+		srv->wscale = 0;
+		while (opt < data && *opt != TCP_OPT_END) {
+			if (*opt == TCP_OPT_NOP) {
+				opt++;
+				continue;
+			}
+			if (*opt == TCP_OPT_WSCALE)
+				srv->wscale = opt[2];
+			opt += opt[1];
+		}
+		srv->window = ntohs(ip->tcp_win);
+		sb_http_reply(dev, srv, packet, TCP_SYN | TCP_ACK, 0, 0);
+		return 0;
+	}
+	if (ntohs(ip->tcp_src) != srv->port)
+		return 0;
+
+	srv->window = ntohs(ip->tcp_win) << srv->wscale;
+	if (data_len && ntohl(ip->tcp_seq) == srv->rcv_nxt) {
+		srv->rcv_nxt += data_len;
+		srv->request_ok = data_len > 30 &&
+			!strncmp((char *)data,
+				 "GET /sandbox.img HTTP/1.1\r\n", 27) &&
+			!strncmp((char *)data + data_len - 4, "\r\n\r\n", 4);
+	} else if (!data_len && !(flags & TCP_FIN)) {
+		srv->acks++;
+		/* A repeated ACK means the client is missing a segment */
+		if (ack == srv->snd_una && srv->snd_nxt != srv->snd_una &&
+		    srv->resent != srv->snd_una) {
+			srv->snd_nxt = srv->snd_una;
+			srv->resent = srv->snd_una;
+			srv->resends++;
+		}
+	}
+	if (ack > srv->snd_una)
+		srv->snd_una = ack;
+
+	if (flags & TCP_FIN) {
+		srv->rcv_nxt++;
+		srv->closed = true;
+	}
+	if (!srv->request_ok)
+		return 0;
+	if (!sb_http_send(dev, srv, packet) && (flags & TCP_FIN))
+		sb_http_reply(dev, srv, packet, TCP_ACK, srv->snd_nxt, 0);
+
+	return 0;
+}
+
+/* Fetch the file served by @srv over HTTP, returning the net_loop() result */
+static int sb_http_get(struct sb_http_server *srv)
+{
+	ulong start;
+	int ret;
+
+	if (srv->status == 200 && !srv->no_length)
+		srv->hdr_len = sprintf(srv->hdr,
+				       "HTTP/1.1 200 OK\r\n"
+				       "Content-Length: %d\r\n\r\n", srv->size);
+	else
+		srv->hdr_len = sprintf(srv->hdr, "HTTP/1.1 %d Whatever\r\n\r\n",
+				       srv->status);
+	srv->segments = 0;
+	srv->resends = 0;
+	srv->acks = 0;
+	srv->request_ok = false;
+	srv->closed = false;
+	memset(map_sysmem(load_addr, srv->size), '\0', srv->size);
+
+	start = get_timer(0);
+	ret = net_loop(WGET);
+	printf("HTTP: %d bytes, %d segments, %d ACKs, %lu ms\n", srv->size,
+	       srv->segments, srv->acks, get_timer(start));
+
+	return ret;
+}
+
+static int _dm_test_eth_wget(struct unit_test_state *uts,
+			     struct sb_http_server *srv)
+{
+	struct eth_sandbox_priv *priv;
+	struct udevice *dev;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_ETH, "eth@10002000",
+					      &dev));
+	priv = dev_get_priv(dev);
+
+	priv->recv_direct_packets = 0;
+	ut_asserteq(srv->size, sb_http_get(srv));
+	ut_asserteq_mem(srv->data, map_sysmem(load_addr, srv->size),
+			srv->size);
+	ut_assert(srv->closed);
+	/* the window is scaled to fit and about every other segment is ACKed */
+	ut_asserteq(CONFIG_TCP_RX_WINDOW, srv->window);
+	ut_assert(srv->acks <= srv->segments / 2 + 2);
+	ut_asserteq(0, srv->resends);
+	/* segments after the first few are received in place */
+	ut_assert(priv->recv_direct_packets >= srv->segments / 2 - 2);
+
+	/* without a Content-Length the file ends when the server closes */
+	srv->no_length = true;
+	ut_asserteq(srv->size, sb_http_get(srv));
+	ut_asserteq_mem(srv->data, map_sysmem(load_addr, srv->size),
+			srv->size);
+	srv->no_length = false;
+
+	/* a lost segment is resent after a repeated ACK */
+	srv->drop_seg = 10;
+	ut_asserteq(srv->size, sb_http_get(srv));
+	ut_asserteq_mem(srv->data, map_sysmem(load_addr, srv->size),
+			srv->size);
+	ut_asserteq(1, srv->resends);
+
+	/* errors from the server fail the command */
+	srv->status = 404;
+	ut_assert(sb_http_get(srv) < 0);
+	srv->status = 200;
+
+	return 0;
+}
+
+static int dm_test_eth_wget(struct unit_test_state *uts)
+{
+	struct sb_http_server srv;
+	ulong old_load_addr = load_addr;
+	uchar *data;
+	int retval;
+	int i;
+
+	memset(&srv, '\0', sizeof(srv));
+	srv.size = 64 * 1024 + 100;
+	srv.status = 200;
+	data = malloc(srv.size);
+	ut_assertnonnull(data);
+	for (i = 0; i < srv.size; i++)
+		data[i] = i * 7 + (i >> 8);
+	srv.data = data;
+
+	sandbox_eth_set_tx_handler(0, sb_http_handler);
+	sandbox_eth_set_priv(0, &srv);
+	env_set("ethact", "eth@10002000");
+	net_server_ip = string_to_ip("1.1.2.2");
+	strcpy(net_boot_file_name, "sandbox.img");
+	load_addr = 0x1000000;
+
+	retval = _dm_test_eth_wget(uts, &srv);
+
+	/* Restore the env */
+	load_addr = old_load_addr;
+	net_boot_file_name[0] = '\0';
+	net_server_ip.s_addr = 0;
+	sandbox_eth_set_tx_handler(0, NULL);
+	sandbox_eth_set_priv(0, NULL);
+	free(data);
+
+	return retval;
+}
+
+DM_TEST(dm_test_eth_wget, DM_TESTF_SCAN_FDT);
+#endif /* CONFIG_CMD_WGET */
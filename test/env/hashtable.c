@@ -6,6 +6,9 @@
 
 #include <common.h>
 #include <command.h>
+#include <env_flags.h>
+#include <malloc.h>
+#include <net.h>
 #include <search.h>
 #include <stdio.h>
 #include <test/env.h>
@@ -13,6 +16,7 @@
 
 #define SIZE 32
 #define ITERATIONS 10000
+#define BENCH_VARS 5000
 
 static int htab_fill(struct unit_test_state *uts,
 		     struct hsearch_data *htab, size_t size)
@@ -123,3 +127,131 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 }
 
 ENV_TEST(env_test_htab_deletes, 0);
+
+/* Keep adding elements to a small hash table, so that it has to grow */
+static int env_test_htab_resize(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, SIZE * 32));
+	ut_assertok(htab_check_fill(uts, &htab, SIZE * 32));
+	ut_asserteq(SIZE * 32, htab.filled);
+	ut_assert(htab.size > SIZE * 32);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_resize, 0);
+
+/* Import a large generated environment and look up every variable in it */
+static int env_test_htab_import(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	struct env_entry item;
+	struct env_entry *ritem;
+	ulong start, import_us;
+	char key[20], value[20];
+	char *buf, *ptr;
+	int i;
+
+	buf = malloc(BENCH_VARS * 40);
+	ut_assertnonnull(buf);
+	for (i = 0, ptr = buf; i < BENCH_VARS; i++)
+		ptr += sprintf(ptr, "var_%05d=value %d", i, i) + 1;
+	*ptr++ = '\0';
+
+	memset(&htab, 0, sizeof(htab));
+	start = timer_get_us();
+	ut_asserteq(1, himport_r(&htab, buf, ptr - buf, '\0', 0, 0, 0, NULL));
+	import_us = timer_get_us() - start;
+	ut_asserteq(BENCH_VARS, htab.filled);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_VARS; i++) {
+		sprintf(key, "var_%05d", i);
+		sprintf(value, "value %d", i);
+		item.key = key;
+		hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+		ut_assertnonnull(ritem);
+		ut_asserteq_str(value, ritem->data);
+	}
+	printf("%d variables: import %lu us, lookup %lu us\n", BENCH_VARS,
+	       import_us, timer_get_us() - start);
+
+	hdestroy_r(&htab);
+	free(buf);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_import, 0);
+
+#ifdef CONFIG_CMD_NET
+/* The variables which import_change_ok() has been called for, in order */
+static char import_seen[64];
+static int import_flags[3];
+static bool import_callback[3];
+static int import_count;
+
+static int import_change_ok(const struct env_entry *item, const char *newval,
+			    enum env_op op, int flag)
+{
+	int len;
+
+	if (import_count < ARRAY_SIZE(import_flags)) {
+		import_flags[import_count] = item->flags;
+		import_callback[import_count] = item->callback != NULL;
+	}
+	import_count++;
+	len = strlen(import_seen);
+	snprintf(import_seen + len, sizeof(import_seen) - len, "%s=%s;",
+		 item->key, newval);
+
+	return 0;
+}
+
+/*
+ * Check that a bulk import sets up the callback and flags of each variable
+ * and then runs the checks and the callback once for each, in import order
+ */
+static int env_test_htab_import_callbacks(struct unit_test_state *uts)
+{
+	static const char env[] = "a=1\0netmask=255.255.0.0\0b=2\0vlan=5\0"
+				  "b=\0netmask=255.255.255.0\0";
+	struct hsearch_data htab;
+	struct in_addr netmask = net_netmask;
+	char buf[sizeof(env)];
+
+	import_seen[0] = '\0';
+	import_count = 0;
+	memcpy(buf, env, sizeof(env));
+	memset(&htab, 0, sizeof(htab));
+	htab.change_ok = import_change_ok;
+	ut_asserteq(1, himport_r(&htab, buf, sizeof(buf), '\0', 0, 0, 0,
+				 NULL));
+	ut_asserteq(3, htab.filled);
+
+	ut_asserteq_str("a=1;netmask=255.255.255.0;vlan=5;", import_seen);
+	ut_asserteq(3, import_count);
+	ut_asserteq(0, import_flags[0]);
+	ut_asserteq(env_flags_vartype_ipaddr,
+		    import_flags[1] & ENV_FLAGS_VARTYPE_BIN_MASK);
+	ut_asserteq(env_flags_vartype_decimal,
+		    import_flags[2] & ENV_FLAGS_VARTYPE_BIN_MASK);
+	ut_assert(!import_callback[0]);
+	ut_assert(import_callback[1]);
+	ut_assert(import_callback[2]);
+
+	/* The netmask callback saw the final value */
+	ut_asserteq(string_to_ip("255.255.255.0").s_addr, net_netmask.s_addr);
+	net_netmask = netmask;
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_import_callbacks, 0);
+#endif
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for CRC32 and CRC32C
+ *
+ * crc32() may use lookup tables eight bytes at a time or CPU instructions,
+ * both of which handle the unaligned head and tail of a buffer separately.
+ * Check every alignment and short length against a bitwise reference.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <div64.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+/* Number of different alignment values */
+#define SWEEP		16
+/* Longest buffer checked against the reference */
+#define CHECK_LEN	100
+/* Size of the buffer used to measure throughput */
+#define SPEED_LEN	(4 << 20)
+
+#define CRC32_POLY	0xedb88320
+#define CRC32C_POLY	0x82f63b78
+
+/* The check value from the catalogue of CRC algorithms */
+static const char check_msg[] = "123456789";
+
+/* Bit-at-a-time CRC, without the ones complement */
+static uint32_t crc_ref(uint32_t crc, uint32_t poly, const uint8_t *p,
+			uint len)
+{
+	int k;
+
+	while (len--) {
+		crc ^= *p++;
+		for (k = 0; k < 8; k++)
+			crc = crc & 1 ? poly ^ (crc >> 1) : crc >> 1;
+	}
+
+	return crc;
+}
+
+static void init_buffer(uint8_t *buf, uint len)
+{
+	uint i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = i * 7 + (i >> 8);
+}
+
+static int lib_test_crc32(struct unit_test_state *uts)
+{
+	uint8_t buf[SWEEP + CHECK_LEN];
+	uint offset, len;
+
+	ut_asserteq(0xcbf43926,
+		    crc32(0, (const uint8_t *)check_msg, strlen(check_msg)));
+
+	init_buffer(buf, sizeof(buf));
+	for (offset = 0; offset < SWEEP; offset++) {
+		for (len = 0; len <= CHECK_LEN; len++) {
+			ut_asserteq(crc_ref(0x12345678, CRC32_POLY,
+					    buf + offset, len),
+				    crc32_no_comp(0x12345678, buf + offset,
+						  len));
+		}
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_test_crc32, 0);
+
+#ifdef CONFIG_CRC32C
+static int lib_test_crc32c(struct unit_test_state *uts)
+{
+	uint8_t buf[SWEEP + CHECK_LEN];
+	uint32_t table[256];
+	uint offset, len;
+
+	crc32c_init(table, CRC32C_POLY);
+	ut_asserteq(0xe3069283,
+		    crc32c_cal(~0, check_msg, strlen(check_msg), table) ^ ~0);
+
+	init_buffer(buf, sizeof(buf));
+	for (offset = 0; offset < SWEEP; offset++) {
+		for (len = 0; len <= CHECK_LEN; len++) {
+			ut_asserteq(crc_ref(0x12345678, CRC32C_POLY,
+					    buf + offset, len),
+				    crc32c_cal(0x12345678,
+					       (const char *)buf + offset,
+					       len, table));
+		}
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_test_crc32c, 0);
+#endif
+
+static void show_speed(const char *name, ulong us)
+{
+	printf("%-10s %8lu us", name, us);
+	if (us) {
+		puts("  ");
+		print_size(lldiv((u64)SPEED_LEN * 1000000, us), "/s");
+	}
+	puts("\n");
+}
+
+/* Compare crc32() with a byte-at-a-time table lookup */
+static int lib_test_crc32_speed(struct unit_test_state *uts)
+{
+	uint32_t table[256], crc, ref;
+	uint8_t *buf;
+	ulong start;
+	uint i;
+
+	buf = malloc(SPEED_LEN);
+	ut_assertnonnull(buf);
+	init_buffer(buf, SPEED_LEN);
+	for (i = 0; i < 256; i++)
+		table[i] = crc_ref(0, CRC32_POLY, (uint8_t *)&i, 1);
+
+	start = timer_get_us();
+	ref = ~0;
+	for (i = 0; i < SPEED_LEN; i++)
+		ref = table[(ref ^ buf[i]) & 0xff] ^ (ref >> 8);
+	ref = ~ref;
+	show_speed("bytewise", timer_get_us() - start);
+
+	start = timer_get_us();
+	crc = crc32(0, buf, SPEED_LEN);
+	show_speed("crc32()", timer_get_us() - start);
+	free(buf);
+
+	ut_asserteq(ref, crc);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_crc32_speed, 0);
@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Known-answer tests for SHA-1 and SHA-256
+ *
+ * The messages are the examples from FIPS 180-2. The long message is hashed
+ * both in one go and in pieces which are not a multiple of the block size,
+ * so that the buffered and the multi-block paths are both used, whichever
+ * block function the build selects.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <hexdump.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+
+/* Length of the 'million a' message */
+#define MILLION_LEN	1000000
+/* Size of the pieces the long message is hashed in */
+#define PIECE_LEN	1000
+/* Watchdog chunk size for the one-shot functions */
+#define CHUNK_LEN	(64 * 1024)
+
+struct sha_test {
+	const char *msg;
+	uint8_t sha1[SHA1_SUM_LEN];
+	uint8_t sha256[SHA256_SUM_LEN];
+};
+
+static const struct sha_test sha_tests[] = {
+	{
+		"",
+		{ 0xda, 0x39, 0xa3, 0xee, 0x5e, 0x6b, 0x4b, 0x0d, 0x32, 0x55,
+		  0xbf, 0xef, 0x95, 0x60, 0x18, 0x90, 0xaf, 0xd8, 0x07, 0x09 },
+		{ 0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14,
+		  0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+		  0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c,
+		  0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55 },
+	},
+	{
+		"abc",
+		{ 0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+		  0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d },
+		{ 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+		  0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		  0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+		  0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad },
+	},
+	{
+		"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+		{ 0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2, 0x6e, 0xba, 0xae,
+		  0x4a, 0xa1, 0xf9, 0x51, 0x29, 0xe5, 0xe5, 0x46, 0x70, 0xf1 },
+		{ 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+		  0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+		  0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+		  0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 },
+	},
+};
+
+/* Digests of a million 'a' characters */
+static const uint8_t sha1_million[SHA1_SUM_LEN] = {
+	0x34, 0xaa, 0x97, 0x3c, 0xd4, 0xc4, 0xda, 0xa4, 0xf6, 0x1e,
+	0xeb, 0x2b, 0xdb, 0xad, 0x27, 0x31, 0x65, 0x34, 0x01, 0x6f,
+};
+
+static const uint8_t sha256_million[SHA256_SUM_LEN] = {
+	0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92,
+	0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+	0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e,
+	0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0,
+};
+
+#ifdef CONFIG_SHA1
+static int lib_test_sha1(struct unit_test_state *uts)
+{
+	uint8_t digest[SHA1_SUM_LEN];
+	sha1_context ctx;
+	uint8_t *buf;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sha_tests); i++) {
+		sha1_csum_wd((const unsigned char *)sha_tests[i].msg,
+			     strlen(sha_tests[i].msg), digest, CHUNK_LEN);
+		ut_asserteq_mem(sha_tests[i].sha1, digest, SHA1_SUM_LEN);
+	}
+
+	buf = malloc(MILLION_LEN);
+	ut_assertnonnull(buf);
+	memset(buf, 'a', MILLION_LEN);
+
+	sha1_csum_wd(buf, MILLION_LEN, digest, CHUNK_LEN);
+	ut_asserteq_mem(sha1_million, digest, SHA1_SUM_LEN);
+
+	sha1_starts(&ctx);
+	for (i = 0; i < MILLION_LEN; i += PIECE_LEN)
+		sha1_update(&ctx, buf + i, PIECE_LEN);
+	sha1_finish(&ctx, digest);
+	ut_asserteq_mem(sha1_million, digest, SHA1_SUM_LEN);
+	free(buf);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_sha1, 0);
+#endif
+
+#ifdef CONFIG_SHA256
+static int lib_test_sha256(struct unit_test_state *uts)
+{
+	uint8_t digest[SHA256_SUM_LEN];
+	sha256_context ctx;
+	uint8_t *buf;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sha_tests); i++) {
+		sha256_csum_wd((const unsigned char *)sha_tests[i].msg,
+			       strlen(sha_tests[i].msg), digest,
+			       CHUNK_LEN);
+		ut_asserteq_mem(sha_tests[i].sha256, digest, SHA256_SUM_LEN);
+	}
+
+	buf = malloc(MILLION_LEN);
+	ut_assertnonnull(buf);
+	memset(buf, 'a', MILLION_LEN);
+
+	sha256_csum_wd(buf, MILLION_LEN, digest, CHUNK_LEN);
+	ut_asserteq_mem(sha256_million, digest, SHA256_SUM_LEN);
+
+	sha256_starts(&ctx);
+	for (i = 0; i < MILLION_LEN; i += PIECE_LEN)
+		sha256_update(&ctx, buf + i, PIECE_LEN);
+	sha256_finish(&ctx, digest);
+	ut_asserteq_mem(sha256_million, digest, SHA256_SUM_LEN);
+	free(buf);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_sha256, 0);
+#endif
@@ -192,3 +192,166 @@ static int lib_memmove(struct unit_test_state *uts)
 }
 
 LIB_TEST(lib_memmove, 0);
+
+/* Lengths around the thresholds of the bulk loops and of zeroing by block */
+static const int large_lens[] = {
+	63, 64, 65, 127, 128, 129, 255, 256, 257, 511, 512, 513, 1000, 1024,
+};
+
+/* Allow for copying up to 1024 bytes */
+#define LARGE_BUFLEN (SWEEP + 1024 + SWEEP)
+
+/**
+ * check_region() - check that only a region of a buffer was changed
+ *
+ * @uts:	unit test state
+ * @buf:	buffer after the change
+ * @orig:	buffer before the change
+ * @expect:	expected contents of the region
+ * @offset:	relative start of the region in buffer
+ * @len:	length of the region
+ * Return:	0 = success, 1 = failure
+ */
+static int check_region(struct unit_test_state *uts, const u8 buf[],
+			const u8 orig[], const u8 expect[], int offset, int len)
+{
+	int i;
+
+	for (i = 0; i < LARGE_BUFLEN; ++i) {
+		if (i < offset || i >= offset + len) {
+			ut_asserteq(orig[i], buf[i]);
+		} else {
+			ut_asserteq(expect[i - offset], buf[i]);
+		}
+	}
+	return 0;
+}
+
+/**
+ * init_large_buffer() - initialize a large buffer
+ *
+ * The buffer is filled with values which repeat less often than 256 bytes,
+ * so that an access which lands at the wrong offset is caught.
+ *
+ * @buf:	buffer
+ * @seed:	value to start from
+ */
+static void init_large_buffer(u8 buf[], int seed)
+{
+	int i;
+
+	for (i = 0; i < LARGE_BUFLEN; ++i)
+		buf[i] = (i * 7 + i / 251 + seed) & 0xff;
+}
+
+/**
+ * lib_memset_large() - unit test for memset() of larger regions
+ *
+ * The architecture dependent implementations fill larger regions in bulk and
+ * may zero them a cache line at a time, so test those paths as well.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_memset_large(struct unit_test_state *uts)
+{
+	static u8 buf[LARGE_BUFLEN], orig[LARGE_BUFLEN], expect[LARGE_BUFLEN];
+	static const u8 values[] = { 0, MASK };
+	int offset, i, v;
+	void *ptr;
+
+	init_large_buffer(orig, 0);
+	for (v = 0; v < ARRAY_SIZE(values); ++v) {
+		memset(expect, values[v], sizeof(expect));
+		for (offset = 0; offset <= SWEEP; ++offset) {
+			for (i = 0; i < ARRAY_SIZE(large_lens); ++i) {
+				memcpy(buf, orig, sizeof(buf));
+				ptr = memset(buf + offset, values[v],
+					     large_lens[i]);
+				ut_asserteq_ptr(buf + offset, (u8 *)ptr);
+				if (check_region(uts, buf, orig, expect, offset,
+						 large_lens[i])) {
+					debug("%s: failure %d, %d, %d\n",
+					      __func__, values[v], offset,
+					      large_lens[i]);
+					return CMD_RET_FAILURE;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+LIB_TEST(lib_memset_large, 0);
+
+/**
+ * lib_memcpy_large() - unit test for memcpy() of larger regions
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_memcpy_large(struct unit_test_state *uts)
+{
+	static u8 src[LARGE_BUFLEN], buf[LARGE_BUFLEN], orig[LARGE_BUFLEN];
+	int offset1, offset2, i;
+	void *ptr;
+
+	init_large_buffer(src, 1);
+	init_large_buffer(orig, 0);
+	for (offset1 = 0; offset1 <= SWEEP; ++offset1) {
+		for (offset2 = 0; offset2 <= SWEEP; ++offset2) {
+			for (i = 0; i < ARRAY_SIZE(large_lens); ++i) {
+				memcpy(buf, orig, sizeof(buf));
+				ptr = memcpy(buf + offset2, src + offset1,
+					     large_lens[i]);
+				ut_asserteq_ptr(buf + offset2, (u8 *)ptr);
+				if (check_region(uts, buf, orig, src + offset1,
+						 offset2, large_lens[i])) {
+					debug("%s: failure %d, %d, %d\n",
+					      __func__, offset1, offset2,
+					      large_lens[i]);
+					return CMD_RET_FAILURE;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+LIB_TEST(lib_memcpy_large, 0);
+
+/**
+ * lib_memmove_large() - unit test for memmove() of larger overlapping regions
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_memmove_large(struct unit_test_state *uts)
+{
+	static u8 buf[LARGE_BUFLEN], orig[LARGE_BUFLEN];
+	int offset1, offset2, i;
+	void *ptr;
+
+	init_large_buffer(orig, 0);
+	for (offset1 = 0; offset1 <= 2 * SWEEP; ++offset1) {
+		for (offset2 = 0; offset2 <= 2 * SWEEP; ++offset2) {
+			for (i = 0; i < ARRAY_SIZE(large_lens); ++i) {
+				memcpy(buf, orig, sizeof(buf));
+				ptr = memmove(buf + offset2, buf + offset1,
+					      large_lens[i]);
+				ut_asserteq_ptr(buf + offset2, (u8 *)ptr);
+				if (check_region(uts, buf, orig,
+						 orig + offset1, offset2,
+						 large_lens[i])) {
+					debug("%s: failure %d, %d, %d\n",
+					      __func__, offset1, offset2,
+					      large_lens[i]);
+					return CMD_RET_FAILURE;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+LIB_TEST(lib_memmove_large, 0);
@@ -194,6 +194,28 @@ static int log_test(int testnum)
 		log_io("level %d\n", LOGL_DEBUG_IO);
 		break;
 	}
+#ifdef CONFIG_LOG_RING
+	case 11: {
+		/* Check that messages in the ring buffer are formatted later */
+		u8 mac[] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+		char str[] = "stack";
+
+		ret = log_add_filter("console", NULL, LOGL_MAX, "file");
+		if (ret < 0)
+			return ret;
+		log_info("%d %5s|%-4x|%*d|%.*s\n", -3, str, 0xab, 4, 7, 2,
+			 "abc");
+		strcpy(str, "gone");
+		log_info("%lld %llx %zu %c %% end\n", -5LL, 0x123456789abcULL,
+			 (size_t)42, 'z');
+		log_info("mac %pM\n", mac);
+		ret = log_remove_filter("console", ret);
+		if (ret < 0)
+			return ret;
+		log_ring_dump();
+		break;
+	}
+#endif
 	}
 
 	return 0;
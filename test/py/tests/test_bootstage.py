@@ -0,0 +1,33 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Check of boot stages against budgets and a baseline
+
+import json
+import pytest
+
+# Address and size of the stash used as a baseline
+BASE = '1000000'
+SIZE = '1000'
+
+@pytest.mark.buildconfigspec('cmd_bootstage')
+def test_bootstage_check(u_boot_console):
+    """Check that stages over budget are found and compared to a baseline"""
+    cons = u_boot_console
+    cons.run_command('bootstage stash %s %s' % (BASE, SIZE))
+    cons.run_command('setenv bootstage_budget board_init_r:1')
+    output = cons.run_command('bootstage check -j %s %s; echo rc=$?' %
+                              (BASE, SIZE))
+    cons.run_command('setenv bootstage_budget')
+    assert output.endswith('rc=1')
+    result = json.loads(output[:output.rindex('rc=')])
+    assert result['overruns'] == 1
+    recs = {rec['name']: rec for rec in result['records']}
+    assert recs['board_init_r']['over']
+    assert recs['board_init_r']['budget_us'] == 1
+    assert recs['board_init_r']['baseline_us'] == recs['board_init_r']['elapsed_us']
+    assert all('baseline_us' in rec for rec in result['records'])
+
+    output = cons.run_command('bootstage check %s %s; echo rc=$?' %
+                              (BASE, SIZE))
+    assert 'over budget' not in output
+    assert output.endswith('rc=0')
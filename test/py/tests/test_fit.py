@@ -27,6 +27,7 @@ base_its = '''
                         compression = "%(compression)s";
                         load = <0x40000>;
                         entry = <0x8>;
+                        %(kernel_hash)s
                 };
                 kernel@2 {
                         data = /incbin/("%(loadables1)s");
@@ -337,6 +338,7 @@ def test_fit(u_boot_console):
             'kernel_out' : kernel_out,
             'kernel_addr' : 0x40000,
             'kernel_size' : filesize(kernel),
+            'kernel_hash' : '',
 
             'fdt' : fdt,
             'fdt_out' : fdt_out,
@@ -396,6 +398,33 @@ def test_fit(u_boot_console):
                   'U-Boot loaded FDT from offset %#x, FDT is actually at %#x' %
                   (fit_offset, real_fit_offset))
 
+        # Hashes checked while the FIT is loaded are only trusted by the
+        # command straight after, so anything written in between is caught
+        if cons.config.buildconfig.get('config_fit_stream_verify',
+                                       'n') == 'y':
+            with cons.log.section('Kernel hashed while loading'):
+                params['kernel_hash'] = 'hash@1 { algo = "sha1"; };'
+                fit = make_fit(mkimage, params)
+                data = read_file(fit)
+                kernel_data = (params['fit_addr'] +
+                               data.find(read_file(kernel)))
+                load = 'host load hostfs 0 %(fit_addr)x %(fit)s' % params
+                bootm = 'bootm start %(fit_addr)x' % params
+                cons.restart_uboot()
+
+                output = cons.run_command_list([load, bootm])
+                assert 'OK (while loading)' in ''.join(output)
+
+                output = cons.run_command_list([load, 'echo', bootm])
+                assert 'OK (while loading)' not in ''.join(output)
+                assert 'Bad Data Hash' not in ''.join(output)
+
+                output = cons.run_command_list([load,
+                                                'mw.b %x 0' % kernel_data,
+                                                bootm])
+                assert 'Bad Data Hash' in ''.join(output)
+                params['kernel_hash'] = ''
+
         # Now a kernel and an FDT
         with cons.log.section('Kernel + FDT load'):
             params['fdt_load'] = 'load = <%#x>;' % params['fdt_addr']
@@ -130,3 +130,17 @@ def test_log_format(u_boot_console):
         run_with_format('FLfm', 'file.c:123-func() msg')
         run_with_format('lm', 'NOTICE. msg')
         run_with_format('m', 'msg')
+
+@pytest.mark.buildconfigspec('cmd_log')
+@pytest.mark.buildconfigspec('log_ring')
+def test_log_ring(u_boot_console):
+    """Test that records in the log ring buffer are formatted correctly"""
+    cons = u_boot_console
+    with cons.log.section('ring'):
+        cons.run_command('log format default')
+        output = cons.run_command('log test 11')
+    lines = [line.split('] ', 1)[1]
+             for line in output.replace('\r', '').splitlines()[-3:]]
+    assert lines == ['log_test() -3 stack|ab  |   7|ab',
+                     'log_test() -5 123456789abc 42 z % end',
+                     'log_test() mac 00:11:22:33:44:55']
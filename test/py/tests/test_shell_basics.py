@@ -43,3 +43,29 @@ def test_shell_run(u_boot_console):
     u_boot_console.run_command('setenv foo')
     u_boot_console.run_command('setenv monty')
     u_boot_console.run_command('setenv python')
+
+@pytest.mark.buildconfigspec('hush_parser')
+def test_shell_run_again(u_boot_console):
+    """Test running the same script more than once, including a loop which
+    exits early, since the parsed script may be kept and reused."""
+
+    u_boot_console.run_command(
+        "setenv foo 'for i in a b; do echo x$i$n; exit; done'")
+    for n in ('1', '2'):
+        u_boot_console.run_command('setenv n ' + n)
+        response = u_boot_console.run_command('run foo')
+        assert response.strip() == 'xa' + n
+    u_boot_console.run_command('setenv foo')
+    u_boot_console.run_command('setenv n')
+
+def test_shell_abbrev(u_boot_console):
+    """Test running a command by an abbreviation of its name."""
+
+    response = u_boot_console.run_command('ech hello')
+    assert response.strip() == 'hello'
+
+def test_shell_question_mark(u_boot_console):
+    """Test finding a command whose name is not its linker symbol name."""
+
+    response = u_boot_console.run_command('? echo')
+    assert 'echo - ' in response